@@ -37,6 +37,9 @@ uint64_t  g_stack_pointer;
 uint64_t  g_exception_ret_addr;
 uint64_t  g_ret_addr;
 uint32_t  g_wakeup_timeout;
+uint32_t  g_pe_pool;
+uint32_t  g_profile_csv;
+uint32_t  g_pcie_parallel_enum;
 uint32_t  g_single_test = SINGLE_TEST_SENTINEL;
 uint32_t  g_single_module = SINGLE_MODULE_SENTINEL;
 uint32_t  *g_skip_test_num;
@@ -69,7 +72,8 @@ createGicInfoTable(
   GicInfoTable = val_aligned_alloc(SIZE_4K, sizeof(GIC_INFO_TABLE)
                   + ((PLATFORM_OVERRIDE_GICITS_COUNT
                   + PLATFORM_OVERRIDE_GICRD_COUNT + PLATFORM_OVERRIDE_GICC_COUNT
-                  + PLATFORM_OVERRIDE_GICD_COUNT + gic_info_end_index) * sizeof(GIC_INFO_ENTRY)));
+                  + PLATFORM_OVERRIDE_GICD_COUNT + PLATFORM_OVERRIDE_GICH_COUNT
+                  + PLATFORM_OVERRIDE_GICMSIFRAME_COUNT + gic_info_end_index) * sizeof(GIC_INFO_ENTRY)));
 
   Status = val_gic_create_info_table(GicInfoTable);
 
@@ -124,10 +128,10 @@ createPcieVirtInfoTable(
                   + (PLATFORM_OVERRIDE_NUM_ECAM * sizeof(PCIE_INFO_BLOCK)));
   val_pcie_create_info_table(PcieInfoTable);
 
+  /* One block per IORT node, an ITS group node is not limited to IOVIRT_ITS_COUNT */
   IoVirtInfoTable = val_aligned_alloc(SIZE_4K, sizeof(IOVIRT_INFO_TABLE)
-                    + ((IOVIRT_ITS_COUNT + IOVIRT_SMMUV3_COUNT + IOVIRT_RC_COUNT
-                    + IOVIRT_SMMUV2_COUNT + IOVIRT_NAMED_COMPONENT_COUNT + IOVIRT_PMCG_COUNT)
-                    * sizeof(IOVIRT_BLOCK)) + (IOVIRT_MAX_NUM_MAP * sizeof(ID_MAP)));
+                    + (IORT_NODE_COUNT * sizeof(IOVIRT_BLOCK))
+                    + ((IOVIRT_MAX_NUM_MAP + IORT_NODE_COUNT) * sizeof(ID_MAP)));
   val_iovirt_create_info_table(IoVirtInfoTable);
 }
 
@@ -143,7 +147,7 @@ createPeripheralInfoTable(
   val_peripheral_create_info_table(PeripheralInfoTable);
 
   MemoryInfoTable = val_aligned_alloc(SIZE_4K, sizeof(MEMORY_INFO_TABLE)
-                    + (PLATFORM_OVERRIDE_MEMORY_ENTRY_COUNT * sizeof(MEM_INFO_BLOCK)));
+                    + ((PLATFORM_OVERRIDE_MEMORY_ENTRY_COUNT + 1) * sizeof(MEM_INFO_BLOCK)));
   val_memory_create_info_table(MemoryInfoTable);
 }
 
@@ -259,6 +263,8 @@ void
 freeSbsaAvsMem()
 {
 
+  /* Releases the PE pool, which still walks the PE info table */
+  val_free_shared_mem();
   val_pe_free_info_table();
   val_gic_free_info_table();
   val_timer_free_info_table();
@@ -272,7 +278,6 @@ freeSbsaAvsMem()
   val_hmat_free_info_table();
   val_srat_free_info_table();
   val_ras2_free_info_table();
-  val_free_shared_mem();
 }
 
 /***
@@ -320,6 +325,9 @@ ShellAppMainsbsa(
   g_print_mmio = FALSE;
   g_enable_pcie_tests = 1;
   g_wakeup_timeout = PLATFORM_OVERRIDE_TIMEOUT;
+  g_pe_pool = PLATFORM_OVERRIDE_PE_POOL;
+  g_profile_csv = PLATFORM_OVERRIDE_PROFILE_CSV;
+  g_pcie_parallel_enum = PLATFORM_OVERRIDE_PCIE_PARALLEL_ENUM;
 
   //
   // Initialize global counters
@@ -362,13 +370,14 @@ ShellAppMainsbsa(
                        + PLATFORM_OVERRIDE_NUM_RAS2_MEM_BLOCK * sizeof(RAS2_MEM_INFO);
   createInfoTable(val_ras2_create_info_table, ras2_size, "RAS2");
 
+  /* Secondary PEs may take part in the PCIe enumeration */
+  val_allocate_shared_mem();
+
   createPcieVirtInfoTable();
   createPeripheralInfoTable();
   createPmuInfoTable();
   createRasInfoTable();
 
-  val_allocate_shared_mem();
-
   /* Initialise exception vector, so any unexpected exception gets handled
    *  by default SBSA exception handler.
    */
@@ -399,7 +408,7 @@ ShellAppMainsbsa(
   if (g_sbsa_level > 5)
   {
     val_print(AVS_PRINT_TEST, "\n      *** Starting PCIe tests ***  \n", 0);
-    Status |= val_pcie_execute_tests(g_enable_pcie_tests, g_sbsa_level, val_pe_get_num());
+    Status |= val_pcie_execute_tests(g_sbsa_level, val_pe_get_num());
   }
 
   /*
@@ -433,6 +442,8 @@ print_test_status:
   val_print(AVS_PRINT_TEST, "  Tests Failed = %4d\n", g_sbsa_tests_fail);
   val_print(AVS_PRINT_TEST, "     --------------------------------------------------------- \n", 0);
 
+  val_test_profile_report();
+
   freeSbsaAvsMem();
 
   val_print(AVS_PRINT_TEST, "\n      **  For complete SBSA test coverage, it is ", 0);
@@ -26,6 +26,9 @@ extern uint32_t g_num_skip;
 /* Settings */
 #define PLATFORM_OVERRIDE_SBSA_LEVEL   0x7     //The permissible levels are 3,4,5,6 and 7
 #define PLATFORM_OVERRIDE_PRINT_LEVEL  0x3     //The permissible levels are 1,2,3,4 and 5
+#define PLATFORM_OVERRIDE_PE_POOL      0x0     //1 keeps secondary PEs parked between tests
+#define PLATFORM_OVERRIDE_PROFILE_CSV  0x0     //1 prints the per-test profile in CSV form at the end of the run
+#define PLATFORM_OVERRIDE_PCIE_PARALLEL_ENUM 0x0  //1 probes the ECAM regions on secondary PEs in parallel
 
 /* PCIe BAR config parameters*/
 #define PLATFORM_OVERRIDE_PCIE_BAR64_VAL   0x500000000
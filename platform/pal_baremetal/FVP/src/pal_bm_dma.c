@@ -16,6 +16,7 @@
 **/
 
 
+#include <malloc.h>
 #include "include/pal_common_support.h"
 #include "include/pal_pcie_enum.h"
 
@@ -34,6 +34,36 @@ pal_print(char *string, uint64_t data)
 
 }
 
+/**
+  @brief  Formats a string for the log file output
+
+  @param  buffer  Output buffer
+  @param  size    Size of the output buffer
+  @param  string  An ASCII string
+  @param  data    data for the formatted output
+
+  @return Number of characters written, excluding the terminating NULL
+**/
+uint32_t
+pal_log_format(char *buffer, uint32_t size, char *string, uint64_t data)
+{
+  return 0;
+}
+
+/**
+  @brief  Writes a block of formatted output to the platform log
+
+  @param  buffer  Formatted output
+  @param  size    Number of characters to write
+
+  @return None
+**/
+void
+pal_log_write(char *buffer, uint32_t size)
+{
+
+}
+
 }
 
 /**
@@ -0,0 +1,281 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+/* Checks the IoVirt RID map against the IORT walk it falls back to, on randomly
+ * generated tables with overlapping RC and SMMU ID mappings. The table is handed
+ * to VAL in place of the platform one through --wrap=pal_iovirt_create_info_table,
+ * and the walk is forced by failing the allocations of the map build through
+ * --wrap=val_memory_calloc.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "val/include/sbsa_avs_val.h"
+#include "val/include/val_interface.h"
+#include "val/include/sbsa_avs_pcie.h"
+#include "val/include/sbsa_avs_iovirt.h"
+#include "val/include/sbsa_avs_memory.h"
+#include "pal_host.h"
+
+#define CHECK_ROUNDS        200
+#define CHECK_SEGMENTS      3               /* One segment is left without an RC */
+#define CHECK_RID_SPAN      0x1400
+#define CHECK_MAX_BLOCKS    16
+#define CHECK_MAX_MAPS      8
+#define CHECK_TABLE_SIZE    (CHECK_MAX_BLOCKS * (sizeof(IOVIRT_BLOCK) + \
+                             CHECK_MAX_MAPS * sizeof(NODE_DATA_MAP)) + sizeof(IOVIRT_INFO_TABLE))
+#define CHECK_BDF_ENTRIES   512
+
+extern pcie_device_bdf_table *g_pcie_bdf_table;
+
+void *__real_val_memory_calloc(uint32_t num, uint32_t size);
+
+static uint64_t g_seed = 0x10e7c4ec;
+static uint64_t g_table[CHECK_TABLE_SIZE / 8 + 1];
+static uint64_t g_info_table[CHECK_TABLE_SIZE / 8 + 1];
+static uint32_t g_table_size;
+static uint32_t g_fail_calloc;
+
+typedef struct {
+  int      status;
+  uint32_t device_id;
+  uint32_t stream_id;
+  uint32_t its_id;
+} CHECK_RESULT;
+
+static CHECK_RESULT g_result[CHECK_SEGMENTS][CHECK_RID_SPAN];
+
+static uint32_t
+check_rand(uint32_t range)
+{
+  /* xorshift64 */
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 7;
+  g_seed ^= g_seed << 17;
+  return (uint32_t)(g_seed % range);
+}
+
+static uint64_t
+check_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void
+__wrap_pal_iovirt_create_info_table(IOVIRT_INFO_TABLE *iovirt)
+{
+  memcpy(iovirt, g_table, g_table_size);
+}
+
+void *
+__wrap_val_memory_calloc(uint32_t num, uint32_t size)
+{
+  if (g_fail_calloc)
+      return NULL;
+
+  return __real_val_memory_calloc(num, size);
+}
+
+static IOVIRT_BLOCK *
+check_add_block(IOVIRT_INFO_TABLE *table, IOVIRT_BLOCK *block, uint32_t type, uint32_t num_map)
+{
+  memset(block, 0, sizeof(*block) + num_map * sizeof(NODE_DATA_MAP));
+  block->type = type;
+  block->num_data_map = num_map;
+  table->num_blocks++;
+  return block;
+}
+
+/**
+  @brief  Generate two ITS groups, a named component, up to three SMMUv3 and up to
+          four RCs over the first two segments. RC mappings point at any of the
+          other blocks, so some of them are invalid, and both RC and SMMU
+          mappings overlap.
+**/
+static void
+check_gen_table(void)
+{
+  IOVIRT_INFO_TABLE *table = (IOVIRT_INFO_TABLE *)g_table;
+  IOVIRT_BLOCK *block;
+  uint32_t refs[CHECK_MAX_BLOCKS], its_refs[2];
+  uint32_t num_refs = 0, i, j, n;
+  ID_MAP *map;
+
+  memset(table, 0, sizeof(*table));
+  block = &table->blocks[0];
+
+  for (i = 0; i < 2; i++) {
+      check_add_block(table, block, IOVIRT_NODE_ITS_GROUP, 1);
+      block->data.its_count = 1;
+      block->data_map[0].id[0] = 0x10 + i;
+      its_refs[i] = refs[num_refs++] = (uint8_t *)block - (uint8_t *)table;
+      block = IOVIRT_NEXT_BLOCK(block);
+  }
+
+  check_add_block(table, block, IOVIRT_NODE_NAMED_COMPONENT, 0);
+  refs[num_refs++] = (uint8_t *)block - (uint8_t *)table;
+  block = IOVIRT_NEXT_BLOCK(block);
+
+  n = 1 + check_rand(3);
+  for (i = 0; i < n; i++) {
+      check_add_block(table, block, IOVIRT_NODE_SMMU_V3, 1 + check_rand(CHECK_MAX_MAPS));
+      for (j = 0; j < block->num_data_map; j++) {
+          map = &block->data_map[j].map;
+          map->input_base = check_rand(0x2000);
+          map->id_count = check_rand(0x400);
+          map->output_base = check_rand(0x10000);
+          map->output_ref = its_refs[check_rand(2)];
+      }
+      refs[num_refs++] = (uint8_t *)block - (uint8_t *)table;
+      block = IOVIRT_NEXT_BLOCK(block);
+  }
+
+  n = 1 + check_rand(4);
+  for (i = 0; i < n; i++) {
+      check_add_block(table, block, IOVIRT_NODE_PCI_ROOT_COMPLEX, 1 + check_rand(CHECK_MAX_MAPS));
+      block->data.rc.segment = check_rand(CHECK_SEGMENTS - 1);
+      for (j = 0; j < block->num_data_map; j++) {
+          map = &block->data_map[j].map;
+          map->input_base = check_rand(CHECK_RID_SPAN - 0x100);
+          map->id_count = check_rand(0x400);
+          map->output_base = check_rand(0x1800);
+          map->output_ref = refs[check_rand(num_refs)];
+      }
+      block = IOVIRT_NEXT_BLOCK(block);
+  }
+
+  g_table_size = (uint8_t *)block - (uint8_t *)table;
+}
+
+static void
+check_gen_bdf_table(pcie_device_bdf_table *bdf_tbl)
+{
+  uint32_t i, rid, seg;
+
+  bdf_tbl->num_entries = CHECK_BDF_ENTRIES;
+  rid = 0;
+  seg = 0;
+  for (i = 0; i < CHECK_BDF_ENTRIES; i++) {
+      /* Mostly neighbouring functions, with the odd jump */
+      rid += check_rand(8) ? 1 : check_rand(0x200);
+      if (rid >= CHECK_RID_SPAN) {
+          rid -= CHECK_RID_SPAN;
+          seg = (seg + 1) % CHECK_SEGMENTS;
+      }
+      memset(&bdf_tbl->device[i], 0, sizeof(bdf_tbl->device[i]));
+      bdf_tbl->device[i].bdf = PCIE_CREATE_BDF(seg, (rid >> 8), ((rid >> 3) & 0x1F), (rid & 0x7));
+  }
+}
+
+/**
+  @brief  Resolve every RID of the span in every segment, then every function of
+          the BDF table, and compare with the results of the first pass.
+  @return number of mismatches
+**/
+static uint32_t
+check_pass(uint32_t record, IOVIRT_DEVICE_INFO *info, IOVIRT_DEVICE_INFO *ref_info,
+           uint64_t *all_ns)
+{
+  uint32_t seg, rid, i, errors = 0;
+  CHECK_RESULT res, *exp;
+  uint64_t start;
+
+  for (seg = 0; seg < CHECK_SEGMENTS; seg++) {
+      for (rid = 0; rid < CHECK_RID_SPAN; rid++) {
+          memset(&res, 0, sizeof(res));
+          res.status = val_iovirt_get_device_info(rid, seg, &res.device_id, &res.stream_id,
+                                                  &res.its_id);
+          exp = &g_result[seg][rid];
+          if (record) {
+              *exp = res;
+              continue;
+          }
+          if (memcmp(&res, exp, sizeof(res))) {
+              if (errors++ < 8)
+                  printf("  seg %d rid 0x%x: map %d 0x%x 0x%x 0x%x, walk %d 0x%x 0x%x 0x%x\n",
+                         seg, rid, exp->status, exp->device_id, exp->stream_id, exp->its_id,
+                         res.status, res.device_id, res.stream_id, res.its_id);
+          }
+      }
+  }
+
+  start = check_ns();
+  val_iovirt_get_device_info_all(info);
+  *all_ns += check_ns() - start;
+
+  for (i = 0; i < g_pcie_bdf_table->num_entries; i++) {
+      if (!record && memcmp(&info[i], &ref_info[i], sizeof(info[i])))
+          errors++;
+  }
+
+  return errors;
+}
+
+int
+main(void)
+{
+  pcie_device_bdf_table *bdf_tbl;
+  IOVIRT_DEVICE_INFO *info_map, *info_walk;
+  uint64_t map_ns = 0, walk_ns = 0;
+  uint32_t round, errors = 0;
+
+  /* The walk reports unmapped RIDs as errors, keep them off the terminal */
+  g_print_level = AVS_PRINT_ERR + 1;
+
+  bdf_tbl = calloc(1, sizeof(*bdf_tbl) + CHECK_BDF_ENTRIES * sizeof(pcie_device_attr));
+  info_map = calloc(CHECK_BDF_ENTRIES, sizeof(IOVIRT_DEVICE_INFO));
+  info_walk = calloc(CHECK_BDF_ENTRIES, sizeof(IOVIRT_DEVICE_INFO));
+  if (bdf_tbl == NULL || info_map == NULL || info_walk == NULL) {
+      printf("iovirt_map_check: allocation failed\n");
+      return 1;
+  }
+  g_pcie_bdf_table = bdf_tbl;
+
+  for (round = 0; round < CHECK_ROUNDS; round++) {
+      check_gen_table();
+      check_gen_bdf_table(bdf_tbl);
+
+      g_fail_calloc = 0;
+      val_iovirt_create_info_table(g_info_table);
+      check_pass(1, info_map, NULL, &map_ns);
+
+      /* Same table, the RID map build fails and lookups walk the table */
+      g_fail_calloc = 1;
+      val_iovirt_create_info_table(g_info_table);
+      g_fail_calloc = 0;
+      errors += check_pass(0, info_walk, info_map, &walk_ns);
+  }
+
+  printf("%d random tables, %d RIDs in each of %d segments, %d BDF table entries\n",
+         CHECK_ROUNDS, CHECK_RID_SPAN, CHECK_SEGMENTS, CHECK_BDF_ENTRIES);
+  printf("val_iovirt_get_device_info_all: map %.1f us, walk %.1f us per table\n",
+         map_ns / 1000.0 / CHECK_ROUNDS, walk_ns / 1000.0 / CHECK_ROUNDS);
+
+  if (errors) {
+      printf("iovirt_map_check: %d lookups differ between the RID map and the walk\n", errors);
+      return 1;
+  }
+
+  printf("iovirt_map_check: RID map and walk agree\n");
+  return 0;
+}
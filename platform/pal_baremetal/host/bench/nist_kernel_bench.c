@@ -0,0 +1,401 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+/* Times the packed NIST counting kernels of VAL against the one byte per bit
+ * loops of the reference STS tests, on 1 Mbit and 100 Mbit sequences, and
+ * fails if the two give different counts. The counts are also compared on
+ * random unaligned ranges of a biased stream.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "val/include/sbsa_avs_val.h"
+#include "val/include/val_interface.h"
+#include "val/include/sbsa_avs_nist.h"
+#include "val/include/sbsa_avs_pe.h"
+#include "pal_host.h"
+
+/* Parameters of the STS run made by test_n001 */
+#define BENCH_BLOCK_LEN     128             /* BlockFrequency M */
+#define BENCH_SERIAL_LEN    16              /* Serial m */
+#define BENCH_RANGES        2000
+
+static uint64_t g_seed = 0x5eed0024;
+
+/* avs_nist.c is linked for its kernels only. The STS and the RNG sources are
+ * not part of the host build.
+ */
+uint32_t
+n001_entry(uint32_t num_pe)
+{
+  return AVS_STATUS_SKIP;
+}
+
+uint32_t
+pal_nist_generate_rng(uint32_t *rng_buffer)
+{
+  return AVS_STATUS_ERR;
+}
+
+uint64_t
+AA64FillRndr(uint64_t *buffer, uint64_t count)
+{
+  return 0;
+}
+
+uint64_t
+AA64FillRndrrs(uint64_t *buffer, uint64_t count)
+{
+  return 0;
+}
+
+/* Counts behind the P-values of the six counting tests */
+typedef struct {
+  uint64_t  ones;                   /* Frequency */
+  uint32_t *block_ones;             /* BlockFrequency, per block */
+  uint64_t  runs;                   /* Runs */
+  uint32_t *longest;                /* LongestRunOfOnes, per block */
+  int64_t   sum, sum_max, sum_min;  /* CumulativeSums */
+  uint32_t *patterns[3];            /* Serial, for m, m - 1 and m - 2 */
+} BENCH_COUNTS;
+
+enum { BENCH_FREQUENCY, BENCH_BLOCK_FREQUENCY, BENCH_RUNS, BENCH_LONGEST_RUN,
+       BENCH_CUSUM, BENCH_SERIAL, BENCH_NUM_TESTS };
+
+static const char *g_test_name[BENCH_NUM_TESTS] = {
+  "Frequency", "BlockFrequency", "Runs", "LongestRun", "CumulativeSums", "Serial"
+};
+
+static uint64_t
+bench_rand(void)
+{
+  /* xorshift64 */
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 7;
+  g_seed ^= g_seed << 17;
+  return g_seed;
+}
+
+static uint64_t
+bench_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* LongestRunOfOnes block length for a sequence of n bits, as in the STS */
+static uint32_t
+bench_longest_block(uint64_t n)
+{
+  return (n < 6272) ? 8 : (n < 750000) ? 128 : 10000;
+}
+
+static int
+bench_alloc(BENCH_COUNTS *c, uint64_t n, uint32_t m)
+{
+  uint32_t i;
+
+  memset(c, 0, sizeof(*c));
+  c->block_ones = calloc(n / BENCH_BLOCK_LEN + 1, sizeof(uint32_t));
+  c->longest = calloc(n / bench_longest_block(n) + 1, sizeof(uint32_t));
+  for (i = 0; i < 3; i++)
+      c->patterns[i] = calloc(1u << m, sizeof(uint32_t));
+
+  return (c->block_ones && c->longest && c->patterns[0] && c->patterns[1] && c->patterns[2]) ? 0 : 1;
+}
+
+static void
+bench_free(BENCH_COUNTS *c)
+{
+  uint32_t i;
+
+  free(c->block_ones);
+  free(c->longest);
+  for (i = 0; i < 3; i++)
+      free(c->patterns[i]);
+}
+
+/**
+  @brief  One byte per bit counts, with the loops of the reference STS tests.
+**/
+static void
+bench_reference(uint32_t test, const uint8_t *eps, uint64_t n, uint32_t m, BENCH_COUNTS *c)
+{
+  uint64_t i, j, k, len, run, best, mask;
+  uint32_t p;
+  int64_t  s;
+
+  switch (test) {
+  case BENCH_FREQUENCY:
+      for (i = 0, c->ones = 0; i < n; i++)
+          c->ones += eps[i];
+      break;
+  case BENCH_BLOCK_FREQUENCY:
+      for (i = 0; i < n / BENCH_BLOCK_LEN; i++) {
+          for (j = 0, k = 0; j < BENCH_BLOCK_LEN; j++)
+              k += eps[i * BENCH_BLOCK_LEN + j];
+          c->block_ones[i] = (uint32_t)k;
+      }
+      break;
+  case BENCH_RUNS:
+      for (i = 1, c->runs = 1; i < n; i++)
+          c->runs += (eps[i] != eps[i - 1]);
+      break;
+  case BENCH_LONGEST_RUN:
+      len = bench_longest_block(n);
+      for (i = 0; i < n / len; i++) {
+          for (j = 0, run = 0, best = 0; j < len; j++) {
+              run = eps[i * len + j] ? run + 1 : 0;
+              best = (run > best) ? run : best;
+          }
+          c->longest[i] = (uint32_t)best;
+      }
+      break;
+  case BENCH_CUSUM:
+      for (i = 0, s = 0, c->sum_max = 0, c->sum_min = 0; i < n; i++) {
+          s += eps[i] ? 1 : -1;
+          c->sum_max = (s > c->sum_max) ? s : c->sum_max;
+          c->sum_min = (s < c->sum_min) ? s : c->sum_min;
+      }
+      c->sum = s;
+      break;
+  case BENCH_SERIAL:
+      /* psi2 for m, m - 1 and m - 2, each pattern wraps to the start */
+      for (k = 0; k < 3; k++) {
+          mask = (1ull << (m - k)) - 1;
+          memset(c->patterns[k], 0, (mask + 1) * sizeof(uint32_t));
+          for (i = 0; i < n; i++) {
+              for (j = 0, p = 0; j < m - k; j++)
+                  p = (p << 1) | eps[(i + j) % n];
+              c->patterns[k][p]++;
+          }
+      }
+      break;
+  }
+}
+
+/**
+  @brief  The same counts with the VAL kernels on the packed stream.
+**/
+static void
+bench_packed(uint32_t test, const uint8_t *data, uint64_t start, uint64_t n, uint32_t m,
+             BENCH_COUNTS *c)
+{
+  uint64_t i, len;
+
+  switch (test) {
+  case BENCH_FREQUENCY:
+      c->ones = val_nist_count_ones(data, start, n);
+      break;
+  case BENCH_BLOCK_FREQUENCY:
+      for (i = 0; i < n / BENCH_BLOCK_LEN; i++)
+          c->block_ones[i] = (uint32_t)val_nist_count_ones(data, start + i * BENCH_BLOCK_LEN,
+                                                           BENCH_BLOCK_LEN);
+      break;
+  case BENCH_RUNS:
+      c->runs = val_nist_count_runs(data, start, n);
+      break;
+  case BENCH_LONGEST_RUN:
+      len = bench_longest_block(n);
+      for (i = 0; i < n / len; i++)
+          c->longest[i] = val_nist_longest_run(data, start + i * len, len);
+      break;
+  case BENCH_CUSUM:
+      val_nist_cusum(data, start, n, &c->sum, &c->sum_max, &c->sum_min);
+      break;
+  case BENCH_SERIAL:
+      for (i = 0; i < 3; i++)
+          val_nist_count_patterns(data, start, n, m - (uint32_t)i, c->patterns[i]);
+      break;
+  }
+}
+
+static int
+bench_compare(uint32_t test, uint64_t n, uint32_t m, BENCH_COUNTS *a, BENCH_COUNTS *b)
+{
+  uint32_t i;
+
+  switch (test) {
+  case BENCH_FREQUENCY:
+      return a->ones != b->ones;
+  case BENCH_BLOCK_FREQUENCY:
+      return memcmp(a->block_ones, b->block_ones, (n / BENCH_BLOCK_LEN) * sizeof(uint32_t)) != 0;
+  case BENCH_RUNS:
+      return a->runs != b->runs;
+  case BENCH_LONGEST_RUN:
+      return memcmp(a->longest, b->longest, (n / bench_longest_block(n)) * sizeof(uint32_t)) != 0;
+  case BENCH_CUSUM:
+      return a->sum != b->sum || a->sum_max != b->sum_max || a->sum_min != b->sum_min;
+  case BENCH_SERIAL:
+      for (i = 0; i < 3; i++)
+          if (memcmp(a->patterns[i], b->patterns[i], (1u << (m - i)) * sizeof(uint32_t)))
+              return 1;
+      return 0;
+  }
+
+  return 1;
+}
+
+/* Expand bits [start, start + n) to one byte per bit, as readPackedBitStream does */
+static void
+bench_unpack(const uint8_t *data, uint64_t start, uint64_t n, uint8_t *eps)
+{
+  uint64_t i;
+
+  for (i = 0; i < n; i++)
+      eps[i] = (data[(start + i) >> 3] >> (7 - ((start + i) & 7))) & 1;
+}
+
+static int
+bench_sequence(const uint8_t *data, uint64_t n, uint8_t *eps)
+{
+  BENCH_COUNTS ref, packed;
+  uint64_t start, t_ref, t_packed;
+  uint32_t test;
+  int errors = 0;
+
+  if (bench_alloc(&ref, n, BENCH_SERIAL_LEN) || bench_alloc(&packed, n, BENCH_SERIAL_LEN)) {
+      printf("nist_kernel_bench: allocation failed\n");
+      return 1;
+  }
+
+  start = bench_ns();
+  bench_unpack(data, 0, n, eps);
+  printf("\n%llu Mbit, unpacking to one byte per bit %.1f ms\n",
+         (unsigned long long)(n / 1000000), (bench_ns() - start) / 1e6);
+  printf("%-16s %14s %14s %10s\n", "test", "reference ms", "packed ms", "speedup");
+
+  for (test = 0; test < BENCH_NUM_TESTS; test++) {
+      start = bench_ns();
+      bench_reference(test, eps, n, BENCH_SERIAL_LEN, &ref);
+      t_ref = bench_ns() - start;
+
+      start = bench_ns();
+      bench_packed(test, data, 0, n, BENCH_SERIAL_LEN, &packed);
+      t_packed = bench_ns() - start;
+
+      printf("%-16s %14.2f %14.2f %9.1fx\n", g_test_name[test], t_ref / 1e6, t_packed / 1e6,
+             (double)t_ref / (t_packed ? t_packed : 1));
+
+      if (bench_compare(test, n, BENCH_SERIAL_LEN, &ref, &packed)) {
+          printf("nist_kernel_bench: %s counts differ\n", g_test_name[test]);
+          errors++;
+      }
+  }
+
+  bench_free(&ref);
+  bench_free(&packed);
+  return errors;
+}
+
+/**
+  @brief  Compare the kernels on random ranges, starting at any bit, of a
+          stream biased towards long runs of ones or of zeros.
+**/
+static int
+bench_ranges(uint8_t *data, uint64_t bits, uint8_t *eps)
+{
+  BENCH_COUNTS ref, packed;
+  uint64_t i, start, n;
+  uint32_t r, m, test;
+  int errors = 0;
+
+  for (i = 0; i < bits / 8; i++) {
+      data[i] = (uint8_t)bench_rand();
+      if ((i >> 10) & 1)
+          data[i] |= (uint8_t)bench_rand();
+      else if ((i >> 11) & 1)
+          data[i] &= (uint8_t)bench_rand();
+  }
+
+  for (r = 0; r < BENCH_RANGES; r++) {
+      n = 1 + bench_rand() % 20000;
+      start = bench_rand() % (bits - n);
+      m = 3 + bench_rand() % 10;
+      if (n < m)
+          n = m;
+      if (bench_alloc(&ref, n, m) || bench_alloc(&packed, n, m)) {
+          printf("nist_kernel_bench: allocation failed\n");
+          return 1;
+      }
+
+      bench_unpack(data, start, n, eps);
+      for (test = 0; test < BENCH_NUM_TESTS; test++) {
+          bench_reference(test, eps, n, m, &ref);
+          bench_packed(test, data, start, n, m, &packed);
+          if (bench_compare(test, n, m, &ref, &packed)) {
+              if (errors++ < 8)
+                  printf("nist_kernel_bench: %s counts differ at bit %llu, %llu bits, m %d\n",
+                         g_test_name[test], (unsigned long long)start, (unsigned long long)n, m);
+          }
+      }
+
+      bench_free(&ref);
+      bench_free(&packed);
+  }
+
+  return errors;
+}
+
+int
+main(void)
+{
+  static const uint64_t sizes[] = { 1000000, 100000000 };
+  uint64_t bits = sizes[1], i;
+  uint8_t *data, *eps;
+  int errors = 0;
+
+  g_print_level = AVS_PRINT_ERR;
+
+  /* The kernels read up to a byte past a 64-bit word, keep the tail mapped */
+  data = calloc(bits / 8 + 16, 1);
+  eps = malloc(bits);
+  if (data == NULL || eps == NULL) {
+      printf("nist_kernel_bench: allocation failed\n");
+      return 1;
+  }
+
+  for (i = 0; i < bits / 8; i++)
+      data[i] = (uint8_t)bench_rand();
+
+  /* Builds the cumulative sum tables of the kernels */
+  val_nist_set_stream(data, bits);
+
+  printf("BlockFrequency M %d, LongestRun M 128 or 10000, Serial m %d\n",
+         BENCH_BLOCK_LEN, BENCH_SERIAL_LEN);
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+      errors += bench_sequence(data, sizes[i], eps);
+
+  errors += bench_ranges(data, 1000000, eps);
+  val_nist_set_stream(NULL, 0);
+
+  if (errors) {
+      printf("nist_kernel_bench: %d mismatches between the reference and packed counts\n", errors);
+      return 1;
+  }
+
+  printf("\nnist_kernel_bench: reference and packed counts agree, also on %d random ranges\n",
+         BENCH_RANGES);
+  free(data);
+  free(eps);
+  return 0;
+}
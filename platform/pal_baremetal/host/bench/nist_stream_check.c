@@ -0,0 +1,231 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+/* Checks the running counts of the streamed NIST evaluation against the packed
+ * kernels on the same bits. A stream is read through val_nist_read_stream in
+ * chunks and split into bitstreams, as readStreamedBitStream of the STS does,
+ * and the counts of each bitstream are compared with those the packed tests
+ * take from the whole of it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "val/include/sbsa_avs_val.h"
+#include "val/include/val_interface.h"
+#include "val/include/sbsa_avs_nist.h"
+#include "pal_host.h"
+
+#define CHECK_STREAM_BITS   (8u << 20)
+#define CHECK_CHUNK         65536           /* NIST_STREAM_CHUNK of the STS */
+#define CHECK_BLOCK_LEN     128             /* BlockFrequency M of test_n001 */
+#define CHECK_MAX_SERIAL    16              /* Serial m of test_n001 */
+#define CHECK_ROUNDS        40
+
+static uint64_t g_seed = 0x5eed0025;
+static uint8_t *g_stream;
+static uint64_t g_stream_pos;
+static uint32_t g_random_reads;
+
+/* avs_nist.c is linked for its kernels only. The STS and the RNG sources are
+ * not part of the host build.
+ */
+uint32_t
+n001_entry(uint32_t num_pe)
+{
+  return AVS_STATUS_SKIP;
+}
+
+uint32_t
+pal_nist_generate_rng(uint32_t *rng_buffer)
+{
+  return AVS_STATUS_ERR;
+}
+
+uint64_t
+AA64FillRndr(uint64_t *buffer, uint64_t count)
+{
+  return 0;
+}
+
+uint64_t
+AA64FillRndrrs(uint64_t *buffer, uint64_t count)
+{
+  return 0;
+}
+
+static uint64_t
+check_rand(void)
+{
+  /* xorshift64 */
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 7;
+  g_seed ^= g_seed << 17;
+  return g_seed;
+}
+
+static uint32_t
+check_read_stream(uint8_t *buffer, uint64_t nbytes)
+{
+  if (g_stream_pos + nbytes > CHECK_STREAM_BITS / 8)
+      return AVS_STATUS_ERR;
+
+  memcpy(buffer, g_stream + g_stream_pos, nbytes);
+  g_stream_pos += nbytes;
+  return AVS_STATUS_PASS;
+}
+
+/**
+  @brief  Compare the running counts of one bitstream, starting at bit start
+          of the stream, with the packed kernels on the same bits.
+  @return number of mismatching counts
+**/
+static uint32_t
+check_bitstream(NIST_STREAM_STATE_t *state, uint64_t start, uint64_t n, uint32_t m,
+                uint32_t *counts)
+{
+  int64_t  sum, max, min, dev;
+  uint64_t i, blocks, block_dev;
+  uint32_t errors = 0;
+
+  if (state->bits != n || state->ones != val_nist_count_ones(g_stream, start, n))
+      errors++;
+  if (state->runs != val_nist_count_runs(g_stream, start, n))
+      errors++;
+
+  val_nist_cusum(g_stream, start, n, &sum, &max, &min);
+  if (state->sum != sum || state->sum_max != max || state->sum_min != min)
+      errors++;
+
+  blocks = n / CHECK_BLOCK_LEN;
+  for (i = 0, block_dev = 0; i < blocks; i++) {
+      dev = 2 * (int64_t)val_nist_count_ones(g_stream, start + i * CHECK_BLOCK_LEN,
+                                             CHECK_BLOCK_LEN) - CHECK_BLOCK_LEN;
+      block_dev += (uint64_t)(dev * dev);
+  }
+  if (state->blocks != blocks || state->block_dev != block_dev)
+      errors++;
+
+  val_nist_count_patterns(g_stream, start, n, m, counts);
+  if (memcmp(state->counts, counts, (1u << m) * sizeof(uint32_t)))
+      errors++;
+
+  return errors;
+}
+
+/**
+  @brief  Read the stream with the loop of readStreamedBitStream, in chunks of
+          CHECK_CHUNK bytes, or of random sizes when g_random_reads is set, and
+          check every bitstream of n bits.
+  @return number of mismatching counts
+**/
+static uint32_t
+check_stream(uint64_t n, uint32_t m, uint8_t *chunk, uint32_t *state_counts, uint32_t *counts)
+{
+  NIST_STREAM_STATE_t state;
+  uint64_t done, avail = 0, off = 0, left, nbytes, k;
+  uint32_t i, num, errors = 0;
+
+  val_nist_set_stream_reader(check_read_stream, CHECK_STREAM_BITS);
+  g_stream_pos = 0;
+  left = CHECK_STREAM_BITS / 8;
+  num = (uint32_t)(CHECK_STREAM_BITS / n);
+
+  for (i = 0; i < num; i++) {
+      val_nist_stream_init(&state, CHECK_BLOCK_LEN, m, state_counts);
+      for (done = 0; done < n; done += k) {
+          if (avail == 0) {
+              nbytes = g_random_reads ? 1 + check_rand() % CHECK_CHUNK : CHECK_CHUNK;
+              nbytes = (left < nbytes) ? left : nbytes;
+              if (val_nist_read_stream(chunk, nbytes) != AVS_STATUS_PASS) {
+                  printf("nist_stream_check: stream read failed\n");
+                  return errors + 1;
+              }
+              left -= nbytes;
+              avail = nbytes * 8;
+              off = 0;
+          }
+          k = (avail < n - done) ? avail : n - done;
+          val_nist_stream_update(&state, chunk, off, k);
+          off += k;
+          avail -= k;
+      }
+      val_nist_stream_finish(&state);
+
+      if (check_bitstream(&state, (uint64_t)i * n, n, m, counts)) {
+          if (errors++ < 8)
+              printf("  bitstream %d of %llu bits, m %d: streamed and packed counts differ\n",
+                     i, (unsigned long long)n, m);
+      }
+  }
+
+  val_nist_set_stream_reader(NULL, 0);
+  return errors;
+}
+
+int
+main(void)
+{
+  uint32_t *state_counts, *counts, round, m, errors = 0;
+  uint8_t  *chunk;
+  uint64_t  i, n;
+
+  g_print_level = AVS_PRINT_ERR;
+
+  /* The kernels read up to a byte past a 64-bit word, keep the tail mapped */
+  g_stream = calloc(CHECK_STREAM_BITS / 8 + 16, 1);
+  chunk = calloc(CHECK_CHUNK + 16, 1);
+  state_counts = calloc(1u << CHECK_MAX_SERIAL, sizeof(uint32_t));
+  counts = calloc(1u << CHECK_MAX_SERIAL, sizeof(uint32_t));
+  if (g_stream == NULL || chunk == NULL || state_counts == NULL || counts == NULL) {
+      printf("nist_stream_check: allocation failed\n");
+      return 1;
+  }
+
+  /* Random bytes, with stretches biased towards long runs of ones or zeros */
+  for (i = 0; i < CHECK_STREAM_BITS / 8; i++) {
+      g_stream[i] = (uint8_t)check_rand();
+      if ((i >> 10) & 1)
+          g_stream[i] |= (uint8_t)check_rand();
+      else if ((i >> 11) & 1)
+          g_stream[i] &= (uint8_t)check_rand();
+  }
+
+  /* The bitstreams of test_n001 first, then random lengths, m and reads */
+  errors += check_stream(100000, CHECK_MAX_SERIAL, chunk, state_counts, counts);
+  for (round = 0; round < CHECK_ROUNDS; round++) {
+      n = CHECK_MAX_SERIAL + check_rand() % 1500000;
+      m = 1 + (uint32_t)(check_rand() % CHECK_MAX_SERIAL);
+      g_random_reads = round & 1;
+      errors += check_stream(n, m, chunk, state_counts, counts);
+  }
+
+  if (errors) {
+      printf("nist_stream_check: %d bitstreams with streamed counts that differ from the packed path\n",
+             errors);
+      return 1;
+  }
+
+  printf("nist_stream_check: streamed and packed counts agree on %d Mbit read as bitstreams of "
+         "100000 bits and of %d random lengths\n", CHECK_STREAM_BITS >> 20, CHECK_ROUNDS);
+  free(g_stream);
+  free(chunk);
+  free(state_counts);
+  free(counts);
+  return 0;
+}
@@ -0,0 +1,253 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+/* Times val_pcie_read_cfg, which takes the config space base of a bus from the
+ * (segment, bus) lookup table, against the val_pcie_get_info walk of the ECAM
+ * regions it replaced, on a synthetic layout of split and sparse segments. The
+ * layout is handed to VAL through --wrap=pal_pcie_create_info_table, and
+ * --wrap=pal_mmio_read records the config address instead of reading it, every
+ * function reading as absent.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "val/include/sbsa_avs_val.h"
+#include "val/include/val_interface.h"
+#include "val/include/sbsa_avs_pcie.h"
+#include "pal_host.h"
+
+#define BENCH_MAX_SEG       20              /* Segments probed, most have no ECAM */
+#define BENCH_NUM_READS     (1u << 22)
+#define BENCH_ECAM_BASE     0x4000000000ull
+
+/* ECAM regions of the layout: segment, start bus, end bus. Segment 0 is split
+   over three regions, segments 2, 5 and 17 have none. Buses stay below the
+   PCIE_MAX_BUS of the RDN2 configuration the host build uses. */
+static const uint32_t g_layout[][3] = {
+  {0,  0x00, 0x0F},
+  {0,  0x10, 0x1F},
+  {1,  0x00, 0x3F},
+  {3,  0x08, 0x1F},
+  {4,  0x00, 0x07},
+  {0,  0x20, 0x3F},
+  {6,  0x00, 0x3F},
+  {16, 0x10, 0x2F},
+  {18, 0x00, 0x03},
+};
+#define BENCH_NUM_ECAM      (sizeof(g_layout) / sizeof(g_layout[0]))
+
+static uint64_t g_seed = 0x5eedecab;
+static uint64_t g_info_table[(sizeof(PCIE_INFO_TABLE) +
+                              BENCH_NUM_ECAM * sizeof(PCIE_INFO_BLOCK)) / 8 + 1];
+static volatile uint64_t g_mmio_addr;
+static uint32_t g_bdf[BENCH_NUM_READS];
+
+static uint64_t
+bench_rand(void)
+{
+  /* xorshift64 */
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 7;
+  g_seed ^= g_seed << 17;
+  return g_seed;
+}
+
+static uint64_t
+bench_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void
+__wrap_pal_pcie_create_info_table(PCIE_INFO_TABLE *table)
+{
+  uint32_t i;
+
+  table->num_entries = BENCH_NUM_ECAM;
+  for (i = 0; i < BENCH_NUM_ECAM; i++) {
+      table->block[i].ecam_base = BENCH_ECAM_BASE + ((uint64_t)i << 28);
+      table->block[i].segment_num = g_layout[i][0];
+      table->block[i].start_bus_num = g_layout[i][1];
+      table->block[i].end_bus_num = g_layout[i][2];
+  }
+}
+
+uint32_t
+__wrap_pal_mmio_read(uint64_t addr)
+{
+  g_mmio_addr = addr;
+  return 0xFFFFFFFF;
+}
+
+/**
+  @brief  The config read of the baseline, with the ECAM regions walked through
+          val_pcie_get_info on every access.
+**/
+static uint32_t
+bench_walk_read_cfg(uint32_t bdf, uint32_t offset, uint32_t *data)
+{
+  uint32_t bus     = PCIE_EXTRACT_BDF_BUS(bdf);
+  uint32_t dev     = PCIE_EXTRACT_BDF_DEV(bdf);
+  uint32_t func    = PCIE_EXTRACT_BDF_FUNC(bdf);
+  uint32_t segment = PCIE_EXTRACT_BDF_SEG(bdf);
+  uint32_t cfg_addr;
+  addr_t   ecam_base = 0;
+  uint32_t i = 0;
+
+  if ((bus >= PCIE_MAX_BUS) || (dev >= PCIE_MAX_DEV) || (func >= PCIE_MAX_FUNC))
+     return PCIE_NO_MAPPING;
+
+  while (i < val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0))
+  {
+      if ((bus >= val_pcie_get_info(PCIE_INFO_START_BUS, i)) &&
+           (bus <= val_pcie_get_info(PCIE_INFO_END_BUS, i)) &&
+           (segment == val_pcie_get_info(PCIE_INFO_SEGMENT, i))) {
+          ecam_base = val_pcie_get_info(PCIE_INFO_ECAM, i);
+          break;
+      }
+      i++;
+  }
+
+  if (ecam_base == 0)
+      return PCIE_NO_MAPPING;
+
+  cfg_addr = (bus * PCIE_MAX_DEV * PCIE_MAX_FUNC * 4096) + \
+               (dev * PCIE_MAX_FUNC * 4096) + (func * 4096);
+
+  *data = pal_mmio_read(ecam_base + cfg_addr + offset);
+  return 0;
+}
+
+/**
+  @brief  Compare the config address and status of both reads for every
+          function of every bus of the probed segments.
+  @return number of mismatches
+**/
+static uint32_t
+bench_check(uint32_t *mapped)
+{
+  uint32_t seg, bus, dev, func, bdf, data, status, errors = 0;
+  uint64_t addr;
+
+  *mapped = 0;
+  for (seg = 0; seg <= BENCH_MAX_SEG; seg++) {
+      for (bus = 0; bus < PCIE_MAX_BUS; bus++) {
+          for (dev = 0; dev < PCIE_MAX_DEV; dev++) {
+              for (func = 0; func < PCIE_MAX_FUNC; func++) {
+                  bdf = PCIE_CREATE_BDF(seg, bus, dev, func);
+                  g_mmio_addr = 0;
+                  status = bench_walk_read_cfg(bdf, 0x10, &data);
+                  addr = g_mmio_addr;
+                  g_mmio_addr = 0;
+                  if (status != val_pcie_read_cfg(bdf, 0x10, &data) || addr != g_mmio_addr) {
+                      if (errors++ < 8)
+                          printf("  bdf %x: walk %llx, lookup %llx\n", bdf,
+                                 (unsigned long long)addr, (unsigned long long)g_mmio_addr);
+                  }
+                  if (status == 0)
+                      (*mapped)++;
+              }
+          }
+      }
+  }
+
+  return errors;
+}
+
+/**
+  @brief  Time BENCH_NUM_READS config reads of the g_bdf list.
+  @return ns per read
+**/
+static double
+bench_run(uint32_t (*read_cfg)(uint32_t, uint32_t, uint32_t *), uint64_t *sum)
+{
+  uint64_t start;
+  uint32_t i, data;
+
+  *sum = 0;
+  start = bench_ns();
+  for (i = 0; i < BENCH_NUM_READS; i++) {
+      read_cfg(g_bdf[i], 0, &data);
+      *sum += g_mmio_addr;
+  }
+
+  return (double)(bench_ns() - start) / BENCH_NUM_READS;
+}
+
+int
+main(void)
+{
+  uint32_t i, j, n, bus, mapped;
+  uint64_t sum_walk, sum_lookup;
+  double t_walk, t_lookup;
+
+  g_print_level = AVS_PRINT_ERR + 1;
+
+  /* Cache maintenance of the BDF table reads CTR_EL0 of the emulated PE */
+  if (pal_host_pe_init()) {
+      printf("pcie_ecam_bench: failed to start the emulated PE\n");
+      return 1;
+  }
+
+  val_pcie_create_info_table(g_info_table);
+  if (val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0) != BENCH_NUM_ECAM) {
+      printf("pcie_ecam_bench: synthetic ECAM table not taken\n");
+      return 1;
+  }
+
+  n = bench_check(&mapped);
+  if (n) {
+      printf("pcie_ecam_bench: %d config addresses differ between the walk and the lookup\n", n);
+      return 1;
+  }
+
+  printf("%d ECAM regions over %d segments, %d reads per run\n",
+         (int)BENCH_NUM_ECAM, BENCH_MAX_SEG + 1, BENCH_NUM_READS);
+  printf("%-12s %10s %10s %10s\n", "region", "walk ns", "lookup ns", "speedup");
+
+  /* Reads of the buses of each region in turn, then of random regions */
+  for (j = 0; j <= BENCH_NUM_ECAM; j++) {
+      for (i = 0; i < BENCH_NUM_READS; i++) {
+          n = (j < BENCH_NUM_ECAM) ? j : (uint32_t)(bench_rand() % BENCH_NUM_ECAM);
+          bus = g_layout[n][1] + (uint32_t)(bench_rand() % (g_layout[n][2] - g_layout[n][1] + 1));
+          g_bdf[i] = PCIE_CREATE_BDF(g_layout[n][0], bus, (uint32_t)(bench_rand() % PCIE_MAX_DEV),
+                                     (uint32_t)(bench_rand() % PCIE_MAX_FUNC));
+      }
+
+      t_walk = bench_run(bench_walk_read_cfg, &sum_walk);
+      t_lookup = bench_run(val_pcie_read_cfg, &sum_lookup);
+      if (sum_walk != sum_lookup) {
+          printf("pcie_ecam_bench: walk and lookup read different addresses\n");
+          return 1;
+      }
+
+      if (j < BENCH_NUM_ECAM)
+          printf("%-3d seg %-4d %10.1f %10.1f %9.1fx\n", j, g_layout[j][0],
+                 t_walk, t_lookup, t_walk / t_lookup);
+      else
+          printf("%-12s %10.1f %10.1f %9.1fx\n", "random", t_walk, t_lookup, t_walk / t_lookup);
+  }
+
+  printf("pcie_ecam_bench: %d mapped functions, walk and lookup agree on all config addresses\n",
+         mapped);
+  return 0;
+}
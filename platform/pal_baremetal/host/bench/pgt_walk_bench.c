@@ -0,0 +1,207 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+/* Times val_pgt_walk on a large stage 1 hierarchy of randomly placed pages,
+ * with the walk cache and with the cache dropped before every walk.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "val/include/sbsa_avs_val.h"
+#include "val/include/sbsa_avs_cfg.h"
+#include "val/include/sbsa_avs_mmu.h"
+#include "val/include/sbsa_avs_pgt.h"
+#include "val/include/sbsa_avs_memory.h"
+#include "pal_host.h"
+
+#define BENCH_IAS           48
+#define BENCH_VA_WINDOW     (64ull << 30)   /* Mapped pages are spread over 64GB */
+#define BENCH_NUM_PAGES     16384
+#define BENCH_BATCH         256             /* Memory descriptors per val_pgt_create */
+#define BENCH_NUM_WALKS     (1u << 21)
+#define BENCH_RUN_LENGTH    8               /* Neighbouring pages queried in a row */
+
+static uint64_t g_seed = 0x5eed5b5a;
+static uint64_t g_va[BENCH_NUM_PAGES];
+
+static uint64_t
+bench_rand(void)
+{
+  /* xorshift64 */
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 7;
+  g_seed ^= g_seed << 17;
+  return g_seed;
+}
+
+static uint64_t
+bench_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int
+bench_cmp_va(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/**
+  @brief  Map BENCH_NUM_PAGES distinct random pages of the VA window, the first
+          batch creates the hierarchy and the next ones update it.
+**/
+static int
+bench_build(pgt_descriptor_t *pgt_desc)
+{
+  memory_region_descriptor_t mem_desc[BENCH_BATCH + 1];
+  uint32_t i, n, j;
+
+  for (i = 0; i < BENCH_NUM_PAGES; i++)
+      g_va[i] = (bench_rand() % (BENCH_VA_WINDOW >> 12)) << 12;
+  qsort(g_va, BENCH_NUM_PAGES, sizeof(g_va[0]), bench_cmp_va);
+  for (i = 1, n = 1; i < BENCH_NUM_PAGES; i++)
+      if (g_va[i] != g_va[n - 1])
+          g_va[n++] = g_va[i];
+  for (; n < BENCH_NUM_PAGES; n++)
+      g_va[n] = BENCH_VA_WINDOW + ((uint64_t)n << 12);
+
+  /* Shuffle so that every batch spreads over the whole window */
+  for (i = BENCH_NUM_PAGES - 1; i > 0; i--) {
+      j = bench_rand() % (i + 1);
+      n = (uint32_t)(g_va[i] >> 12);
+      g_va[i] = g_va[j];
+      g_va[j] = (uint64_t)n << 12;
+  }
+
+  pgt_desc->pgt_base = (uint64_t)NULL;
+  for (i = 0; i < BENCH_NUM_PAGES; i += n) {
+      /* A new hierarchy is sized from its descriptors, keep the first one small */
+      n = (i == 0) ? 1 : BENCH_BATCH;
+      if (n > BENCH_NUM_PAGES - i)
+          n = BENCH_NUM_PAGES - i;
+      val_memory_set(mem_desc, sizeof(mem_desc), 0);
+      for (j = 0; j < n; j++) {
+          mem_desc[j].virtual_address = g_va[i + j];
+          mem_desc[j].physical_address = g_va[i + j] ^ (1ull << 40);
+          mem_desc[j].length = 0x1000;
+          mem_desc[j].attributes = (1ull << MEM_ATTR_AF_SHIFT) | PGT_STAGE1_AP_RW;
+      }
+      if (val_pgt_create(mem_desc, pgt_desc))
+          return 1;
+  }
+
+  return 0;
+}
+
+/**
+  @brief  Walk the query sequence once and return the time per walk in ns.
+          With uncached set, the walk cache is dropped before every walk.
+**/
+static double
+bench_run(pgt_descriptor_t *pgt_desc, uint32_t neighbours, uint32_t uncached,
+          uint32_t invalidate_only, uint64_t *sum)
+{
+  uint64_t start, desc, va;
+  uint32_t i, base = 0, level;
+
+  g_seed = 0x5eed;
+  val_pgt_walk_cache_invalidate();
+  *sum = 0;
+
+  start = bench_ns();
+  for (i = 0; i < BENCH_NUM_WALKS; i++) {
+      if (!neighbours || (i % (2 * BENCH_RUN_LENGTH)) == 0)
+          base = bench_rand() % (BENCH_NUM_PAGES - BENCH_RUN_LENGTH);
+      /* Runs query each page of a short sorted range twice, at two offsets */
+      va = g_va[neighbours ? base + (i % BENCH_RUN_LENGTH) : base] + ((i & 1) ? 0x800 : 0x10);
+
+      if (uncached || invalidate_only)
+          val_pgt_walk_cache_invalidate();
+      if (invalidate_only)
+          continue;
+      if (val_pgt_walk(pgt_desc->pgt_base, BENCH_IAS, 12, va, &desc, &level))
+          return -1.0;
+      *sum += desc + level;
+  }
+
+  return (double)(bench_ns() - start) / BENCH_NUM_WALKS;
+}
+
+int
+main(void)
+{
+  pgt_descriptor_t pgt_desc;
+  uint64_t sum_cached, sum_uncached, sum_none;
+  double t_cached, t_uncached, t_inval;
+  uint32_t neighbours;
+
+  g_print_level = AVS_PRINT_ERR;
+
+  /* Cache maintenance of the table writes reads CTR_EL0 of the emulated PE */
+  if (pal_host_pe_init()) {
+      printf("pgt_walk_bench: failed to start the emulated PE\n");
+      return 1;
+  }
+
+  if (val_memory_page_size() != 0x1000) {
+      printf("pgt_walk_bench: 4KB pages required\n");
+      return 1;
+  }
+
+  val_memory_set(&pgt_desc, sizeof(pgt_desc), 0);
+  pgt_desc.ias = BENCH_IAS;
+  pgt_desc.oas = BENCH_IAS;
+  pgt_desc.stage = PGT_STAGE1;
+  pgt_desc.tcr.tg_size_log2 = 12;
+  pgt_desc.tcr.tsz = 64 - BENCH_IAS;
+
+  if (bench_build(&pgt_desc)) {
+      printf("pgt_walk_bench: failed to build the translation tables\n");
+      return 1;
+  }
+
+  /* Neighbouring pages are queried in sorted VA order */
+  qsort(g_va, BENCH_NUM_PAGES, sizeof(g_va[0]), bench_cmp_va);
+
+  printf("%d random pages over %lld GB, %d walks per run\n",
+         BENCH_NUM_PAGES, (long long)(BENCH_VA_WINDOW >> 30), BENCH_NUM_WALKS);
+  printf("%-12s %14s %14s %10s\n", "queries", "uncached ns", "cached ns", "speedup");
+
+  for (neighbours = 1; neighbours != (uint32_t)-1; neighbours--) {
+      t_inval = bench_run(&pgt_desc, neighbours, 0, 1, &sum_none);
+      t_uncached = bench_run(&pgt_desc, neighbours, 1, 0, &sum_uncached);
+      t_cached = bench_run(&pgt_desc, neighbours, 0, 0, &sum_cached);
+      if (t_uncached < 0 || t_cached < 0 || sum_cached != sum_uncached) {
+          printf("pgt_walk_bench: cached and uncached walks differ\n");
+          return 1;
+      }
+      /* Remove the cost of dropping the cache from the uncached walks */
+      t_uncached -= t_inval;
+      printf("%-12s %14.1f %14.1f %9.1fx\n", neighbours ? "neighbours" : "random",
+             t_uncached, t_cached, t_uncached / t_cached);
+  }
+
+  val_pgt_destroy(pgt_desc);
+  return 0;
+}
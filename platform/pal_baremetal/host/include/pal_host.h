@@ -0,0 +1,129 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#ifndef __PAL_HOST_H_
+#define __PAL_HOST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/* Host emulation of the baremetal PAL.
+ * The platform_*_cfg tables of the FVP port describe the emulated system,
+ * optionally edited by a description file. Every MMIO access issued through
+ * pal_mmio_* is routed to an in-memory register model; PEs are pthreads.
+ */
+
+#define HOST_MAX_PE              256
+#define HOST_MAX_REGIONS         512
+#define HOST_MAX_PCIE_FUNC       256
+
+#define HOST_DEFAULT_CNTFRQ      100000000ULL
+
+/* Emulated PSCI state of a PE, values match PSCI AFFINITY_INFO */
+#define HOST_PE_ON               0
+#define HOST_PE_OFF              1
+#define HOST_PE_ON_PENDING       2
+
+struct host_region;
+
+typedef uint64_t (*HOST_REG_READ)(struct host_region *region, uint64_t offset, uint32_t size);
+typedef void (*HOST_REG_WRITE)(struct host_region *region, uint64_t offset, uint32_t size,
+                               uint64_t data);
+
+/* One MMIO window backed by a register model. regs is the plain register file,
+ * read/write hooks implement side effects on top of it (NULL means RAM-like).
+ */
+typedef struct host_region {
+  uint64_t        base;
+  uint64_t        size;
+  uint8_t         *regs;
+  HOST_REG_READ   read;
+  HOST_REG_WRITE  write;
+  void            *ctx;
+  const char      *name;
+  pthread_mutex_t lock;
+} HOST_REGION;
+
+/* PCIe function described by the description file */
+typedef struct {
+  uint32_t seg;
+  uint32_t bus;
+  uint32_t dev;
+  uint32_t func;
+  uint32_t dp_type;        /* PCIe capability device/port type */
+  uint32_t vendor_id;
+  uint32_t device_id;
+  uint32_t class_code;     /* class << 16 | subclass << 8 | prog if */
+  uint64_t bar_size[6];
+  uint32_t bar_flags[6];   /* BAR type bits 3:0 as seen in config space */
+  uint32_t flr;
+} HOST_PCIE_FUNC;
+
+typedef struct {
+  uint64_t       cntfrq;
+  uint32_t       num_pcie_func;
+  HOST_PCIE_FUNC pcie_func[HOST_MAX_PCIE_FUNC];
+} HOST_PLATFORM_DESC;
+
+typedef struct {
+  uint32_t  index;
+  uint64_t  mpidr;
+  volatile uint32_t state;
+  pthread_t thread;
+  uint64_t  *sysreg;
+  uint64_t  fault_esr;
+  uint64_t  fault_far;
+  void      (*esr[4])(uint64_t, void *);
+} HOST_PE;
+
+extern HOST_PLATFORM_DESC g_host_desc;
+
+/* Log file given with -o, NULL if none */
+extern FILE *g_host_log_file;
+
+/* VAL log buffer, see avs_test_infra.c */
+void val_log_init(uint32_t level);
+void val_log_flush(void);
+
+/* pal_host_desc.c */
+int  pal_host_desc_load(const char *path);
+
+/* pal_host_model.c */
+int  pal_host_model_init(void);
+HOST_REGION *pal_host_region_add(uint64_t base, uint64_t size, const char *name,
+                                 HOST_REG_READ read, HOST_REG_WRITE write, void *ctx);
+HOST_REGION *pal_host_region_find(uint64_t addr);
+uint64_t pal_host_reg_get(HOST_REGION *region, uint64_t offset, uint32_t size);
+void pal_host_reg_set(HOST_REGION *region, uint64_t offset, uint32_t size, uint64_t data);
+uint64_t pal_host_mmio_read(uint64_t addr, uint32_t size);
+void pal_host_mmio_write(uint64_t addr, uint32_t size, uint64_t data);
+
+/* pal_host_pcie.c */
+int  pal_host_pcie_model_init(void);
+
+/* pal_host_pe.c */
+int  pal_host_pe_init(void);
+HOST_PE *pal_host_pe_self(void);
+HOST_PE *pal_host_pe_by_mpidr(uint64_t mpidr);
+void pal_host_psci_call(uint64_t *args);
+void pal_host_exception_init(void);
+
+/* pal_host_arch.c */
+void pal_host_sysreg_init(HOST_PE *pe);
+
+#endif
@@ -0,0 +1,265 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include <time.h>
+
+#include "include/pal_pcie_enum.h"
+#include "include/pal_common_support.h"
+#include "pal_host.h"
+
+#define HOST_PAGE_SIZE  0x1000
+
+FILE *g_host_log_file;
+
+/**
+  @brief  Sends a formatted string to the output console
+
+  @param  string  An ASCII string
+  @param  data    data for the formatted output
+
+  @return None
+**/
+void
+pal_print(char *string, uint64_t data)
+{
+  printf(string, data);
+}
+
+/**
+  @brief  Formats a string for the log file output
+
+  @param  buffer  Output buffer
+  @param  size    Size of the output buffer
+  @param  string  An ASCII string
+  @param  data    data for the formatted output
+
+  @return Number of characters written, excluding the terminating NULL
+**/
+uint32_t
+pal_log_format(char *buffer, uint32_t size, char *string, uint64_t data)
+{
+  int len = snprintf(buffer, size, string, data);
+
+  if (len < 0)
+      return 0;
+  return ((uint32_t)len < size) ? (uint32_t)len : size - 1;
+}
+
+/**
+  @brief  Writes a block of formatted output to the log file given with -o
+
+  @param  buffer  Formatted output
+  @param  size    Number of characters to write
+
+  @return None
+**/
+void
+pal_log_write(char *buffer, uint32_t size)
+{
+  if (g_host_log_file && size) {
+      fwrite(buffer, 1, size, g_host_log_file);
+      fflush(g_host_log_file);
+  }
+}
+
+/**
+  @brief   Creates a buffer with length equal to size within the
+           address range (mem_base, mem_base + mem_size)
+
+  @param   mem_base    - Base address of the memory range
+  @param   mem_size    - Size of the memory range of interest
+  @param   size        - Buffer size to be created
+
+  @return  Buffer address if SUCCESSFUL, else NULL
+**/
+void *
+pal_mem_alloc_at_address (
+  uint64_t mem_base,
+  uint64_t Size
+  )
+{
+  /* Host memory cannot be placed at a physical address */
+  (void)mem_base;
+  return malloc(Size);
+}
+
+/**
+  @brief  Free the memory allocated by pal_mem_alloc_at_address
+  @param  Buffer the base address of the memory range to be freed
+
+  @return None
+**/
+void
+pal_mem_free_at_address(uint64_t mem_base,
+  uint64_t Size
+)
+{
+  (void)Size;
+  free((void *)mem_base);
+}
+
+/**
+  @brief  Allocates memory of the requested size.
+
+  @param  Bdf:  BDF of the requesting PCIe device
+  @param  Size: size of the memory region to be allocated
+  @param  Pa:   physical address of the allocated memory
+**/
+void *
+pal_mem_alloc_cacheable(uint32_t Bdf, uint32_t Size, void **Pa)
+{
+  void *Va;
+
+  (void)Bdf;
+  Va = aligned_alloc(HOST_PAGE_SIZE, (Size + HOST_PAGE_SIZE - 1) & ~(HOST_PAGE_SIZE - 1));
+  *Pa = Va;
+  return Va;
+}
+
+/**
+  @brief  Frees the memory allocated
+
+  @param  Bdf:  BDF of the requesting PCIe device
+  @param  Size: size of the memory region to be freed
+  @param  Va:   virtual address of the memory to be freed
+  @param  Pa:   physical address of the memory to be freed
+**/
+void
+pal_mem_free_cacheable(uint32_t Bdf, uint32_t Size, void *Va, void *Pa)
+{
+  (void)Bdf;
+  (void)Size;
+  (void)Pa;
+  free(Va);
+}
+
+/**
+  @brief  Returns the physical address of the input virtual address.
+
+  @param Va virtual address of the memory to be converted
+
+  Returns the physical address.
+**/
+void *
+pal_mem_virt_to_phys(void *Va)
+{
+  /* Host memory is identity mapped for the emulated PEs */
+  return Va;
+}
+
+/**
+  @brief  Returns the virtual address of the input physical address.
+
+  @param Pa physical address of the memory to be converted
+
+  Returns the virtual address.
+**/
+void *
+pal_mem_phys_to_virt (
+  uint64_t Pa
+  )
+{
+  return (void*)Pa;
+}
+
+/**
+  Stalls the CPU for the number of microseconds specified by MicroSeconds.
+
+  @param  MicroSeconds  The minimum number of microseconds to delay.
+
+  @return 1 - Success, 0 -Failure
+
+**/
+uint64_t
+pal_time_delay_ms(uint64_t MicroSeconds)
+{
+  struct timespec ts;
+
+  ts.tv_sec  = (time_t)(MicroSeconds / 1000000);
+  ts.tv_nsec = (long)((MicroSeconds % 1000000) * 1000);
+  nanosleep(&ts, NULL);
+
+  return 1;
+}
+
+/**
+  @brief  page size being used in current translation regime.
+
+  @return page size being used
+**/
+uint32_t
+pal_mem_page_size()
+{
+    return HOST_PAGE_SIZE;
+}
+
+/**
+  @brief  allocates contiguous numpages of size
+          returned by pal_mem_page_size()
+
+  @return Start address of base page
+**/
+void *
+pal_mem_alloc_pages (uint32_t NumPages)
+{
+  return aligned_alloc(HOST_PAGE_SIZE, (size_t)NumPages * HOST_PAGE_SIZE);
+}
+
+/**
+  @brief  frees continguous numpages starting from page
+          at address PageBase
+
+**/
+void
+pal_mem_free_pages(void *PageBase, uint32_t NumPages)
+{
+  (void)NumPages;
+  free(PageBase);
+}
+
+/**
+  @brief  Allocates memory with the given alignement.
+
+  @param  Alignment   Specifies the alignment.
+  @param  Size        Requested memory allocation size.
+
+  @return Pointer to the allocated memory with requested alignment.
+**/
+void
+*pal_aligned_alloc( uint32_t alignment, uint32_t size )
+{
+  void *Buffer;
+
+  if (posix_memalign(&Buffer, alignment < sizeof(void *) ? sizeof(void *) : alignment, size))
+      return NULL;
+
+  return Buffer;
+}
+
+/**
+  @brief  Free the Aligned memory allocated by pal_aligned_alloc
+
+  @param  Buffer        the base address of the aligned memory range
+
+  @return None
+*/
+
+void
+pal_mem_free_aligned(void *Buffer)
+{
+    free(Buffer);
+}
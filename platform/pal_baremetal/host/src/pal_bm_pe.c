@@ -0,0 +1,113 @@
+/** @file
+ * Copyright (c) 2023 Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include <ucontext.h>
+
+#include "include/pal_common_support.h"
+#include "include/pal_pcie_enum.h"
+#include "pal_host.h"
+
+/**
+  Conduits for service calls (SMC vs HVC).
+**/
+#define CONDUIT_SMC       0
+#define CONDUIT_HVC       1
+#define CONDUIT_NONE     -2
+
+/**
+  @brief  Install Exception Handler for the calling PE. Faulting host
+          accesses are delivered to the synchronous exception handler.
+
+  @param  ExceptionType  - AARCH64 Exception type
+  @param  esr            - Function pointer of the exception handler
+
+  @return status of the API
+**/
+uint32_t
+pal_pe_install_esr(uint32_t ExceptionType,  void (*esr)(uint64_t, void *))
+{
+  if (ExceptionType >= 4)
+      return 1;
+
+  pal_host_pe_self()->esr[ExceptionType] = esr;
+  return 0;
+}
+
+/**
+  @brief Update the ELR to return from exception handler to a desired address
+
+  @param  context - host signal context of the faulting PE
+  @param  offset - address with which ELR should be updated
+
+  @return  None
+**/
+void
+pal_pe_update_elr(void *context, uint64_t offset)
+{
+  ucontext_t *uc = context;
+
+  if (uc == NULL)
+      return;
+
+#if defined(__x86_64__)
+  uc->uc_mcontext.gregs[REG_RIP] = (greg_t)offset;
+#elif defined(__aarch64__)
+  uc->uc_mcontext.pc = offset;
+#endif
+}
+
+/**
+  @brief Get the Exception syndrome of the last fault taken by the PE
+
+  @param  context - host signal context of the faulting PE
+
+  @return  ESR
+**/
+uint64_t
+pal_pe_get_esr(void *context)
+{
+  (void)context;
+  return pal_host_pe_self()->fault_esr;
+}
+
+/**
+  @brief Get the FAR of the last fault taken by the PE
+
+  @param  context - host signal context of the faulting PE
+
+  @return  FAR
+**/
+uint64_t
+pal_pe_get_far(void *context)
+{
+  (void)context;
+  return pal_host_pe_self()->fault_far;
+}
+
+/**
+  @brief   Checks whether PSCI is implemented if so,
+           using which conduit (HVC or SMC).
+
+  @param
+
+  @retval  CONDUIT_SMC:           PSCI is emulated by ArmCallSmc
+**/
+uint32_t
+pal_psci_get_conduit(void)
+{
+  return CONDUIT_SMC;
+}
@@ -0,0 +1,550 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+/* C replacements for the AArch64 assembly helpers of VAL and the baremetal
+ * PAL. System registers are per-PE values held by the emulated PE, the
+ * generic counter follows the host monotonic clock.
+ */
+
+#include <sched.h>
+#include <time.h>
+
+#include "include/pal_common_support.h"
+#include "pal_host.h"
+
+/* Name, reset value */
+#define HOST_SYSREG_LIST(X) \
+  X(MIDR,          0x410FD490) \
+  X(MPIDR,         0x80000000) \
+  X(CURRENTEL,     0x8) \
+  X(ID_AA64PFR0,   0x1101011121001111ULL) \
+  X(ID_AA64PFR1,   0x21) \
+  X(ID_AA64MMFR0,  0x100025) \
+  X(ID_AA64MMFR1,  0x10312122) \
+  X(ID_AA64MMFR2,  0x1221011100001011ULL) \
+  X(ID_AA64ISAR0,  0x0221100110212120ULL) \
+  X(ID_AA64ISAR1,  0x0000000100211122ULL) \
+  X(ID_AA64DFR0,   0x0000000210305508ULL) \
+  X(ID_AA64DFR1,   0x0) \
+  X(ID_AA64ZFR0,   0x0) \
+  X(ID_DFR0,       0x04010088) \
+  X(ID_ISAR0,      0x02101110) \
+  X(ID_ISAR1,      0x13112111) \
+  X(ID_ISAR2,      0x21232042) \
+  X(ID_ISAR3,      0x01112131) \
+  X(ID_ISAR4,      0x00010142) \
+  X(ID_ISAR5,      0x01011121) \
+  X(ID_MMFR0,      0x10201105) \
+  X(ID_MMFR1,      0x40000000) \
+  X(ID_MMFR2,      0x01260000) \
+  X(ID_MMFR3,      0x02122211) \
+  X(ID_MMFR4,      0x00021110) \
+  X(ID_PFR0,       0x10010131) \
+  X(ID_PFR1,       0x00010000) \
+  X(MVFR0,         0x10110222) \
+  X(MVFR1,         0x13211111) \
+  X(MVFR2,         0x00000043) \
+  X(CTR,           0x84448004) \
+  X(CLIDR,         0x82000023) \
+  X(CCSIDR,        0x701FE01A) \
+  X(CSSELR,        0x0) \
+  X(SCTLR1,        0x30D00800) \
+  X(SCTLR2,        0x30C50830) \
+  X(SCTLR3,        0x30C50830) \
+  X(HCR,           0x0) \
+  X(MDCR2,         0x6) \
+  X(VBAR2,         0x0) \
+  X(PMCR,          0x41003000) \
+  X(PMCEID0,       0x7FFF0F3F) \
+  X(PMCEID1,       0x0) \
+  X(PMOVS,         0x0) \
+  X(PMINTEN,       0x0) \
+  X(VMPIDR,        0x80000000) \
+  X(VPIDR,         0x410FD490) \
+  X(PMBIDR,        0x6) \
+  X(PMSIDR,        0x0) \
+  X(PMSIRR,        0x0) \
+  X(PMSCR2,        0x0) \
+  X(PMSFCR,        0x0) \
+  X(PMBPTR,        0x0) \
+  X(PMBLIMITR,     0x0) \
+  X(LORID,         0x0) \
+  X(ERRIDR,        0x0) \
+  X(ERR0FR,        0x0) \
+  X(ERR1FR,        0x0) \
+  X(ERR2FR,        0x0) \
+  X(ERR3FR,        0x0) \
+  X(ERRSELR,       0x0) \
+  X(ERXFR,         0x0) \
+  X(ERXCTLR,       0x0) \
+  X(ERXSTATUS,     0x0) \
+  X(ERXADDR,       0x0) \
+  X(ERXIDR,        0x0) \
+  X(ERXPFGF,       0x0) \
+  X(ERXPFGCTL,     0x0) \
+  X(ERXPFGCDN,     0x0) \
+  X(ESR2,          0x0) \
+  X(FAR2,          0x0) \
+  X(MAIR1,         0x0) \
+  X(MAIR2,         0x0) \
+  X(TCR1,          0x0000000500103510ULL) \
+  X(TCR2,          0x80853510) \
+  X(TTBR0_EL1,     0x0) \
+  X(TTBR1_EL1,     0x0) \
+  X(TTBR0_EL2,     0x0) \
+  X(TTBR1_EL2,     0x0) \
+  X(TPIDR1,        0x0) \
+  X(TPIDR2,        0x0) \
+  X(MPAMIDR,       0x0) \
+  X(MPAM1,         0x0) \
+  X(MPAM2,         0x0) \
+  X(CNTKCTL,       0x0) \
+  X(CNTP_CTL,      0x0) \
+  X(CNTP_CVAL,     0x0) \
+  X(CNTV_CTL,      0x0) \
+  X(CNTV_CVAL,     0x0) \
+  X(CNTVOFF,       0x0) \
+  X(CNTHP_CTL,     0x0) \
+  X(CNTHP_CVAL,    0x0) \
+  X(CNTHV_CTL,     0x0) \
+  X(CNTHV_CVAL,    0x0) \
+  X(ICC_PMR,       0x0) \
+  X(ICC_BPR1,      0x0) \
+  X(ICC_IGRPEN1,   0x0) \
+  X(ICH_HCR,       0x0) \
+  X(ICH_MISR,      0x0)
+
+#define HOST_SYSREG_ENUM(name, reset)   HOST_SYSREG_##name,
+#define HOST_SYSREG_RESET(name, reset)  (uint64_t)(reset),
+
+enum {
+  HOST_SYSREG_LIST(HOST_SYSREG_ENUM)
+  HOST_SYSREG_COUNT
+};
+
+static const uint64_t g_host_sysreg_reset[HOST_SYSREG_COUNT] = {
+  HOST_SYSREG_LIST(HOST_SYSREG_RESET)
+};
+
+#define HOST_TT_ENTRIES  512
+
+static uint64_t *g_host_ttbr0;
+
+#define SYSREG(name)  (pal_host_pe_self()->sysreg[HOST_SYSREG_##name])
+
+#define HOST_SYSREG_READ(fn, name) \
+  uint64_t fn(void); \
+  uint64_t fn(void) { return SYSREG(name); }
+
+#define HOST_SYSREG_WRITE(fn, name) \
+  void fn(uint64_t write_data); \
+  void fn(uint64_t write_data) { SYSREG(name) = write_data; }
+
+/**
+  @brief  Allocates the system register file of an emulated PE and loads the
+          reset values. MPIDR is taken from the PE configuration table.
+**/
+void
+pal_host_sysreg_init(HOST_PE *pe)
+{
+  pe->sysreg = malloc(sizeof(g_host_sysreg_reset));
+  if (pe->sysreg == NULL)
+      return;
+
+  memcpy(pe->sysreg, g_host_sysreg_reset, sizeof(g_host_sysreg_reset));
+  pe->sysreg[HOST_SYSREG_MPIDR]  = (1ull << 31) | pe->mpidr;
+  pe->sysreg[HOST_SYSREG_VMPIDR] = (1ull << 31) | pe->mpidr;
+
+  /* All PEs share one empty stage 1 table, entries added by VAL land in host memory */
+  if (g_host_ttbr0 == NULL) {
+      g_host_ttbr0 = aligned_alloc(HOST_TT_ENTRIES * sizeof(uint64_t),
+                                   HOST_TT_ENTRIES * sizeof(uint64_t));
+      if (g_host_ttbr0 == NULL)
+          return;
+      memset(g_host_ttbr0, 0, HOST_TT_ENTRIES * sizeof(uint64_t));
+  }
+  pe->sysreg[HOST_SYSREG_TTBR0_EL1] = (uint64_t)g_host_ttbr0;
+  pe->sysreg[HOST_SYSREG_TTBR0_EL2] = (uint64_t)g_host_ttbr0;
+}
+
+static uint64_t
+host_counter(void)
+{
+  struct timespec ts;
+  uint64_t freq = g_host_desc.cntfrq;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * freq + ((uint64_t)ts.tv_nsec * freq) / 1000000000ULL;
+}
+
+/* PeRegSysSupport.S */
+HOST_SYSREG_READ(ArmReadMpidr,        MPIDR)
+HOST_SYSREG_READ(ArmReadIdPfr0,       ID_AA64PFR0)
+HOST_SYSREG_READ(ArmReadIdPfr1,       ID_AA64PFR1)
+HOST_SYSREG_READ(AA64ReadMmfr0,       ID_AA64MMFR0)
+HOST_SYSREG_READ(AA64ReadMmfr1,       ID_AA64MMFR1)
+HOST_SYSREG_READ(AA64ReadMmfr2,       ID_AA64MMFR2)
+HOST_SYSREG_READ(AA64ReadCtr,         CTR)
+HOST_SYSREG_READ(AA64ReadIsar0,       ID_AA64ISAR0)
+HOST_SYSREG_READ(AA64ReadIsar1,       ID_AA64ISAR1)
+HOST_SYSREG_READ(AA64ReadSctlr3,      SCTLR3)
+HOST_SYSREG_READ(AA64ReadSctlr2,      SCTLR2)
+HOST_SYSREG_READ(AA64ReadSctlr1,      SCTLR1)
+HOST_SYSREG_READ(AA64ReadPmcr,        PMCR)
+HOST_SYSREG_WRITE(AA64WritePmcr,      PMCR)
+HOST_SYSREG_READ(AA64ReadIdDfr0,      ID_AA64DFR0)
+HOST_SYSREG_READ(AA64ReadIdDfr1,      ID_AA64DFR1)
+HOST_SYSREG_READ(ArmReadHcr,          HCR)
+HOST_SYSREG_READ(AA64ReadCurrentEL,   CURRENTEL)
+HOST_SYSREG_READ(AA64ReadMdcr2,       MDCR2)
+HOST_SYSREG_WRITE(AA64WriteMdcr2,     MDCR2)
+HOST_SYSREG_READ(AA64ReadVbar2,       VBAR2)
+HOST_SYSREG_WRITE(AA64WriteVbar2,     VBAR2)
+HOST_SYSREG_WRITE(AA64WritePmovsset,  PMOVS)
+HOST_SYSREG_WRITE(AA64WritePmovsclr,  PMOVS)
+HOST_SYSREG_WRITE(AA64WritePmintenset, PMINTEN)
+HOST_SYSREG_WRITE(AA64WritePmintenclr, PMINTEN)
+HOST_SYSREG_READ(AA64ReadCcsidr,      CCSIDR)
+HOST_SYSREG_READ(AA64ReadCsselr,      CSSELR)
+HOST_SYSREG_WRITE(AA64WriteCsselr,    CSSELR)
+HOST_SYSREG_READ(AA64ReadClidr,       CLIDR)
+HOST_SYSREG_READ(ArmReadDfr0,         ID_DFR0)
+HOST_SYSREG_READ(ArmReadIsar0,        ID_ISAR0)
+HOST_SYSREG_READ(ArmReadIsar1,        ID_ISAR1)
+HOST_SYSREG_READ(ArmReadIsar2,        ID_ISAR2)
+HOST_SYSREG_READ(ArmReadIsar3,        ID_ISAR3)
+HOST_SYSREG_READ(ArmReadIsar4,        ID_ISAR4)
+HOST_SYSREG_READ(ArmReadIsar5,        ID_ISAR5)
+HOST_SYSREG_READ(ArmReadMmfr0,        ID_MMFR0)
+HOST_SYSREG_READ(ArmReadMmfr1,        ID_MMFR1)
+HOST_SYSREG_READ(ArmReadMmfr2,        ID_MMFR2)
+HOST_SYSREG_READ(ArmReadMmfr3,        ID_MMFR3)
+HOST_SYSREG_READ(ArmReadMmfr4,        ID_MMFR4)
+HOST_SYSREG_READ(ArmReadPfr0,         ID_PFR0)
+HOST_SYSREG_READ(ArmReadPfr1,         ID_PFR1)
+HOST_SYSREG_READ(ArmReadMidr,         MIDR)
+HOST_SYSREG_READ(ArmReadMvfr0,        MVFR0)
+HOST_SYSREG_READ(ArmReadMvfr1,        MVFR1)
+HOST_SYSREG_READ(ArmReadMvfr2,        MVFR2)
+HOST_SYSREG_READ(AA64ReadPmceid0,     PMCEID0)
+HOST_SYSREG_READ(AA64ReadPmceid1,     PMCEID1)
+HOST_SYSREG_READ(AA64ReadVmpidr,      VMPIDR)
+HOST_SYSREG_READ(AA64ReadVpidr,       VPIDR)
+HOST_SYSREG_READ(AA64ReadPmbidr,      PMBIDR)
+HOST_SYSREG_READ(AA64ReadPmsidr,      PMSIDR)
+HOST_SYSREG_READ(AA64ReadLorid,       LORID)
+HOST_SYSREG_READ(AA64ReadErridr,      ERRIDR)
+HOST_SYSREG_READ(AA64ReadErr0fr,      ERR0FR)
+HOST_SYSREG_READ(AA64ReadErr1fr,      ERR1FR)
+HOST_SYSREG_READ(AA64ReadErr2fr,      ERR2FR)
+HOST_SYSREG_READ(AA64ReadErr3fr,      ERR3FR)
+HOST_SYSREG_WRITE(AA64WritePmsirr,    PMSIRR)
+HOST_SYSREG_WRITE(AA64WritePmscr2,    PMSCR2)
+HOST_SYSREG_WRITE(AA64WritePmsfcr,    PMSFCR)
+HOST_SYSREG_WRITE(AA64WritePmbptr,    PMBPTR)
+HOST_SYSREG_WRITE(AA64WritePmblimitr, PMBLIMITR)
+HOST_SYSREG_READ(AA64ReadEsr2,        ESR2)
+HOST_SYSREG_READ(AA64ReadFar2,        FAR2)
+HOST_SYSREG_READ(AA64ReadMair1,       MAIR1)
+HOST_SYSREG_READ(AA64ReadMair2,       MAIR2)
+HOST_SYSREG_READ(AA64ReadTcr1,        TCR1)
+HOST_SYSREG_READ(AA64ReadTcr2,        TCR2)
+HOST_SYSREG_READ(AA64ReadTtbr0El1,    TTBR0_EL1)
+HOST_SYSREG_READ(AA64ReadTtbr1El1,    TTBR1_EL1)
+HOST_SYSREG_READ(AA64ReadTtbr0El2,    TTBR0_EL2)
+HOST_SYSREG_READ(AA64ReadTtbr1El2,    TTBR1_EL2)
+HOST_SYSREG_READ(AA64ReadZfr0,        ID_AA64ZFR0)
+HOST_SYSREG_READ(AA64ReadTpidr1,      TPIDR1)
+HOST_SYSREG_READ(AA64ReadTpidr2,      TPIDR2)
+HOST_SYSREG_WRITE(AA64WriteTpidr1,    TPIDR1)
+HOST_SYSREG_WRITE(AA64WriteTpidr2,    TPIDR2)
+
+/* Per-PE scratch standing in for the stack frame saved by val_pe_context_save */
+static __thread uint64_t g_host_stack_frame[4];
+
+uint64_t AA64ReadSp(void);
+uint64_t
+AA64ReadSp(void)
+{
+  return (uint64_t)g_host_stack_frame;
+}
+
+uint64_t AA64WriteSp(uint64_t write_data);
+uint64_t
+AA64WriteSp(uint64_t write_data)
+{
+  (void)write_data;
+  return (uint64_t)g_host_stack_frame;
+}
+
+uint64_t ArmRdvl(void);
+uint64_t
+ArmRdvl(void)
+{
+  /* 128-bit SVE vector length */
+  return 16;
+}
+
+/* RasSupport.S, ERX* registers access the record selected by ERRSELR */
+HOST_SYSREG_READ(AA64ReadErrIdr1,     ERRIDR)
+HOST_SYSREG_WRITE(AA64WriteErrIdr1,   ERRIDR)
+HOST_SYSREG_READ(AA64ReadErrSelr1,    ERRSELR)
+HOST_SYSREG_WRITE(AA64WriteErrSelr1,  ERRSELR)
+HOST_SYSREG_READ(AA64ReadErrFr1,      ERXFR)
+HOST_SYSREG_READ(AA64ReadErrCtlr1,    ERXCTLR)
+HOST_SYSREG_WRITE(AA64WriteErrCtlr1,  ERXCTLR)
+HOST_SYSREG_READ(AA64ReadErrStatus1,  ERXSTATUS)
+HOST_SYSREG_WRITE(AA64WriteErrStatus1, ERXSTATUS)
+HOST_SYSREG_READ(AA64ReadErrAddr1,    ERXADDR)
+HOST_SYSREG_WRITE(AA64WriteErrAddr1,  ERXADDR)
+HOST_SYSREG_READ(AA64ReadErrPfgf1,    ERXPFGF)
+HOST_SYSREG_WRITE(AA64WriteErrPfgf1,  ERXPFGF)
+HOST_SYSREG_READ(AA64ReadErrPfgctl1,  ERXPFGCTL)
+HOST_SYSREG_WRITE(AA64WriteErrPfgctl1, ERXPFGCTL)
+HOST_SYSREG_READ(AA64ReadErrPfgcdn1,  ERXPFGCDN)
+HOST_SYSREG_WRITE(AA64WriteErrPfgcdn1, ERXPFGCDN)
+
+/* MpamSupport.s */
+HOST_SYSREG_READ(AA64ReadMpamidr,     MPAMIDR)
+HOST_SYSREG_READ(AA64ReadMpam1,       MPAM1)
+HOST_SYSREG_WRITE(AA64WriteMpam1,     MPAM1)
+HOST_SYSREG_READ(AA64ReadMpam2,       MPAM2)
+HOST_SYSREG_WRITE(AA64WriteMpam2,     MPAM2)
+
+/* ArchTimerSupport.S, timers never fire */
+HOST_SYSREG_READ(ArmReadCntkCtl,      CNTKCTL)
+HOST_SYSREG_WRITE(ArmWriteCntkCtl,    CNTKCTL)
+HOST_SYSREG_READ(ArmReadCntpCtl,      CNTP_CTL)
+HOST_SYSREG_WRITE(ArmWriteCntpCtl,    CNTP_CTL)
+HOST_SYSREG_READ(ArmReadCntpCval,     CNTP_CVAL)
+HOST_SYSREG_WRITE(ArmWriteCntpCval,   CNTP_CVAL)
+HOST_SYSREG_READ(ArmReadCntvCtl,      CNTV_CTL)
+HOST_SYSREG_WRITE(ArmWriteCntvCtl,    CNTV_CTL)
+HOST_SYSREG_READ(ArmReadCntvCval,     CNTV_CVAL)
+HOST_SYSREG_WRITE(ArmWriteCntvCval,   CNTV_CVAL)
+HOST_SYSREG_READ(ArmReadCntvOff,      CNTVOFF)
+HOST_SYSREG_WRITE(ArmWriteCntvOff,    CNTVOFF)
+HOST_SYSREG_READ(ArmReadCnthpCtl,     CNTHP_CTL)
+HOST_SYSREG_WRITE(ArmWriteCnthpCtl,   CNTHP_CTL)
+HOST_SYSREG_READ(ArmReadCnthvCtl,     CNTHV_CTL)
+HOST_SYSREG_WRITE(ArmWriteCnthvCtl,   CNTHV_CTL)
+
+uint64_t ArmReadCntFrq(void);
+uint64_t
+ArmReadCntFrq(void)
+{
+  return g_host_desc.cntfrq;
+}
+
+uint64_t ArmReadCntPct(void);
+uint64_t
+ArmReadCntPct(void)
+{
+  return host_counter();
+}
+
+uint64_t ArmReadCntvCt(void);
+uint64_t
+ArmReadCntvCt(void)
+{
+  return host_counter() - SYSREG(CNTVOFF);
+}
+
+/* TVAL views are derived from the compare value and the counter */
+#define HOST_TIMER_TVAL(rd, wr, cval, count) \
+  uint64_t rd(void); \
+  uint64_t rd(void) { return (uint32_t)(SYSREG(cval) - (count)); } \
+  void wr(uint64_t Val); \
+  void wr(uint64_t Val) { SYSREG(cval) = (count) + (uint64_t)(int64_t)(int32_t)Val; }
+
+HOST_TIMER_TVAL(ArmReadCntpTval,  ArmWriteCntpTval,  CNTP_CVAL,  host_counter())
+HOST_TIMER_TVAL(ArmReadCntvTval,  ArmWriteCntvTval,  CNTV_CVAL,  ArmReadCntvCt())
+HOST_TIMER_TVAL(ArmReadCnthpTval, ArmWriteCnthpTval, CNTHP_CVAL, host_counter())
+HOST_TIMER_TVAL(ArmReadCnthvTval, ArmWriteCnthvTval, CNTHV_CVAL, host_counter())
+
+/* GicSupport.S */
+HOST_SYSREG_WRITE(GicWriteIccPmr,     ICC_PMR)
+HOST_SYSREG_WRITE(GicWriteIccBpr1,    ICC_BPR1)
+HOST_SYSREG_WRITE(GicWriteIccIgrpen1, ICC_IGRPEN1)
+HOST_SYSREG_WRITE(GicWriteHcr,        HCR)
+HOST_SYSREG_READ(GicReadIchHcr,       ICH_HCR)
+HOST_SYSREG_WRITE(GicWriteIchHcr,     ICH_HCR)
+HOST_SYSREG_READ(GicReadIchMisr,      ICH_MISR)
+
+void GicClearDaif(void);
+void
+GicClearDaif(void)
+{
+}
+
+void TestExecuteBarrier(void);
+void
+TestExecuteBarrier(void)
+{
+  __sync_synchronize();
+}
+
+/* PeTestSupport.S and MpamSupport.s */
+void ArmExecuteMemoryBarrier(void);
+void
+ArmExecuteMemoryBarrier(void)
+{
+  __sync_synchronize();
+}
+
+void AA64IssueDSB(void);
+void
+AA64IssueDSB(void)
+{
+  __sync_synchronize();
+}
+
+void ArmCallWFI(void);
+void
+ArmCallWFI(void)
+{
+  sched_yield();
+}
+
+void ArmCallWFE(void);
+void
+ArmCallWFE(void)
+{
+  sched_yield();
+}
+
+void ArmCallSEV(void);
+void
+ArmCallSEV(void)
+{
+  __sync_synchronize();
+}
+
+void SpeProgramUnderProfiling(uint64_t interval, uint64_t address);
+void
+SpeProgramUnderProfiling(uint64_t interval, uint64_t address)
+{
+  (void)interval;
+  (void)address;
+}
+
+void DisableSpe(void);
+void
+DisableSpe(void)
+{
+}
+
+/* sbsa_exception_asm.S and v3_asm.S, interrupts are not delivered */
+void sbsa_gic_set_el2_vector_table(void);
+void
+sbsa_gic_set_el2_vector_table(void)
+{
+}
+
+uint32_t sbsa_gic_update_elr(uint64_t elr_value);
+uint32_t
+sbsa_gic_update_elr(uint64_t elr_value)
+{
+  (void)elr_value;
+  return 0;
+}
+
+uint32_t sbsa_gic_get_elr(void);
+uint32_t
+sbsa_gic_get_elr(void)
+{
+  return 0;
+}
+
+uint32_t sbsa_gic_get_esr(void);
+uint32_t
+sbsa_gic_get_esr(void)
+{
+  return (uint32_t)pal_host_pe_self()->fault_esr;
+}
+
+uint32_t sbsa_gic_get_far(void);
+uint32_t
+sbsa_gic_get_far(void)
+{
+  return (uint32_t)pal_host_pe_self()->fault_far;
+}
+
+uint32_t sbsa_gic_ack_intr(void);
+uint32_t
+sbsa_gic_ack_intr(void)
+{
+  /* Spurious interrupt ID */
+  return 1023;
+}
+
+void sbsa_gic_end_intr(uint32_t interrupt_id);
+void
+sbsa_gic_end_intr(uint32_t interrupt_id)
+{
+  (void)interrupt_id;
+}
+
+/* AvsTestInfra.S, the host keeps caches coherent */
+void DataCacheCleanInvalidateVA(uint64_t addr);
+void
+DataCacheCleanInvalidateVA(uint64_t addr)
+{
+  (void)addr;
+  __sync_synchronize();
+}
+
+void DataCacheCleanVA(uint64_t addr);
+void
+DataCacheCleanVA(uint64_t addr)
+{
+  (void)addr;
+  __sync_synchronize();
+}
+
+void DataCacheInvalidateVA(uint64_t addr);
+void
+DataCacheInvalidateVA(uint64_t addr)
+{
+  (void)addr;
+  __sync_synchronize();
+}
+
+/* ArmSmc.S, PSCI is the only firmware service emulated */
+void ArmCallSmc(ARM_SMC_ARGS *Args, int32_t Conduit);
+void
+ArmCallSmc(ARM_SMC_ARGS *Args, int32_t Conduit)
+{
+  uint64_t args[4];
+
+  (void)Conduit;
+  args[0] = Args->Arg0;
+  args[1] = Args->Arg1;
+  args[2] = Args->Arg2;
+  args[3] = Args->Arg3;
+  pal_host_psci_call(args);
+  Args->Arg0 = args[0];
+}
+
+/* ModuleEntryPoint.S, secondary PEs start on their own host thread stack */
+void val_test_entry(void);
+void ModuleEntryPoint(void);
+void
+ModuleEntryPoint(void)
+{
+  val_test_entry();
+}
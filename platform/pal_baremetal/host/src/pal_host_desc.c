@@ -0,0 +1,274 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include "include/pal_common_support.h"
+#include "include/platform_override_struct.h"
+#include "pal_host.h"
+
+extern PE_INFO_TABLE platform_pe_cfg;
+extern PLATFORM_OVERRIDE_GIC_INFO_TABLE platform_gic_cfg;
+extern PCIE_INFO_TABLE platform_pcie_cfg;
+extern PLATFORM_OVERRIDE_SMMU_NODE_DATA platform_smmu_node_data;
+extern RAS_INFO_TABLE platform_ras_cfg;
+extern PLATFORM_OVERRIDE_RAS_NODE_INTERFACE_INFO platform_ras_node_interface;
+extern PCIE_READ_TABLE platform_pcie_device_hierarchy;
+
+/* Entries instantiated by platform_cfg_fvp.c, the description can only edit these */
+#define HOST_DESC_MAX_PE     PLATFORM_OVERRIDE_PE_CNT
+#define HOST_DESC_MAX_ECAM   2
+#define HOST_DESC_MAX_PCIE   PLATFORM_PCIE_NUM_ENTRIES
+
+#define HOST_DESC_MAX_TOKEN  16
+
+HOST_PLATFORM_DESC g_host_desc = {
+  .cntfrq = HOST_DEFAULT_CNTFRQ,
+};
+
+static const struct {
+  const char *name;
+  uint32_t   dp_type;
+  uint32_t   class_code;
+} g_host_pcie_type[] = {
+  {"ep",    0x0, 0x020000},
+  {"rp",    0x4, 0x060400},
+  {"usp",   0x5, 0x060400},
+  {"dsp",   0x6, 0x060400},
+  {"rciep", 0x9, 0x088000},
+  {"rcec",  0xA, 0x080700},
+};
+
+static int
+host_desc_num(const char *token, uint64_t *value)
+{
+  char *end;
+
+  *value = strtoull(token, &end, 0);
+  return (*end != '\0');
+}
+
+/* pcie <seg> <bus> <dev> <func> <type> <vendor> <device> [class=] [barN=size[,64][,pref]] [flr] */
+static int
+host_desc_pcie(char **tok, uint32_t ntok)
+{
+  HOST_PCIE_FUNC *d;
+  uint64_t v[6];
+  uint32_t i, bar;
+  char *opt;
+
+  if ((ntok < 8) || (g_host_desc.num_pcie_func == HOST_MAX_PCIE_FUNC))
+      return 1;
+
+  d = &g_host_desc.pcie_func[g_host_desc.num_pcie_func];
+  memset(d, 0, sizeof(*d));
+
+  for (i = 0; i < 4; i++) {
+      if (host_desc_num(tok[1 + i], &v[i]))
+          return 1;
+  }
+  if (host_desc_num(tok[6], &v[4]) || host_desc_num(tok[7], &v[5]))
+      return 1;
+
+  d->seg       = (uint32_t)v[0];
+  d->bus       = (uint32_t)v[1];
+  d->dev       = (uint32_t)v[2];
+  d->func      = (uint32_t)v[3];
+  d->vendor_id = (uint32_t)v[4];
+  d->device_id = (uint32_t)v[5];
+  if ((d->bus > 0xFF) || (d->dev >= PCIE_MAX_DEV) || (d->func >= PCIE_MAX_FUNC))
+      return 1;
+
+  for (i = 0; i < sizeof(g_host_pcie_type) / sizeof(g_host_pcie_type[0]); i++) {
+      if (strcmp(tok[5], g_host_pcie_type[i].name) == 0)
+          break;
+  }
+  if (i == sizeof(g_host_pcie_type) / sizeof(g_host_pcie_type[0]))
+      return 1;
+  d->dp_type    = g_host_pcie_type[i].dp_type;
+  d->class_code = g_host_pcie_type[i].class_code;
+
+  for (i = 8; i < ntok; i++) {
+      if (strcmp(tok[i], "flr") == 0) {
+          d->flr = 1;
+      } else if (strncmp(tok[i], "class=", 6) == 0) {
+          if (host_desc_num(tok[i] + 6, &v[0]))
+              return 1;
+          d->class_code = (uint32_t)v[0];
+      } else if ((strncmp(tok[i], "bar", 3) == 0) && (tok[i][3] >= '0') &&
+                 (tok[i][3] <= '5') && (tok[i][4] == '=')) {
+          bar = (uint32_t)(tok[i][3] - '0');
+          opt = strchr(tok[i] + 5, ',');
+          if (opt)
+              *opt++ = '\0';
+          if (host_desc_num(tok[i] + 5, &v[0]) || (v[0] < 0x10) || (v[0] & (v[0] - 1)))
+              return 1;
+          d->bar_size[bar] = v[0];
+          while (opt) {
+              if (strncmp(opt, "64", 2) == 0)
+                  d->bar_flags[bar] |= 0x4;
+              else if (strncmp(opt, "pref", 4) == 0)
+                  d->bar_flags[bar] |= 0x8;
+              else
+                  return 1;
+              opt = strchr(opt, ',');
+              if (opt)
+                  opt++;
+          }
+          if ((d->bar_flags[bar] & 0x4) && (bar == 5))
+              return 1;
+      } else {
+          return 1;
+      }
+  }
+
+  g_host_desc.num_pcie_func++;
+  return 0;
+}
+
+/* The described functions replace the platform hierarchy table, which
+ * pal_pcie_check_device_list compares with the enumerated BDFs.
+ */
+static void
+host_desc_pcie_hierarchy(void)
+{
+  PCIE_READ_BLOCK *dev;
+  HOST_PCIE_FUNC *d;
+  uint32_t i;
+
+  if (g_host_desc.num_pcie_func == 0)
+      return;
+
+  if (g_host_desc.num_pcie_func > HOST_DESC_MAX_PCIE)
+      print(AVS_PRINT_WARN, "\n HOST: only %d functions fit the platform hierarchy,"
+            " PCIe tests will be skipped\n", HOST_DESC_MAX_PCIE);
+
+  for (i = 0; (i < g_host_desc.num_pcie_func) && (i < HOST_DESC_MAX_PCIE); i++) {
+      d = &g_host_desc.pcie_func[i];
+      dev = &platform_pcie_device_hierarchy.device[i];
+      dev->seg        = d->seg;
+      dev->bus        = d->bus;
+      dev->dev        = d->dev;
+      dev->func       = d->func;
+      dev->vendor_id  = d->vendor_id;
+      dev->device_id  = d->device_id;
+      dev->class_code = ((uint64_t)d->class_code << 8) | 0x1;
+  }
+  platform_pcie_device_hierarchy.num_entries = i;
+}
+
+static int
+host_desc_line(char **tok, uint32_t ntok, uint32_t *num_pe)
+{
+  uint64_t v[5];
+  uint32_t i;
+
+  for (i = 1; (i < ntok) && (i < 5); i++) {
+      if (strcmp(tok[0], "pcie") && host_desc_num(tok[i], &v[i - 1]))
+          return 1;
+  }
+
+  if (strcmp(tok[0], "pe") == 0) {
+      for (i = 1; i < ntok; i++) {
+          if ((*num_pe == HOST_DESC_MAX_PE) || host_desc_num(tok[i], &v[0]))
+              return 1;
+          platform_pe_cfg.pe_info[*num_pe].pe_num = *num_pe;
+          platform_pe_cfg.pe_info[*num_pe].mpidr  = v[0];
+          (*num_pe)++;
+      }
+      platform_pe_cfg.header.num_of_pe = *num_pe;
+  } else if ((strcmp(tok[0], "counter") == 0) && (ntok == 2) && v[0]) {
+      g_host_desc.cntfrq = v[0];
+  } else if ((strcmp(tok[0], "gicd") == 0) && (ntok == 2)) {
+      platform_gic_cfg.gicd_base[0] = v[0];
+  } else if ((strcmp(tok[0], "gicr") == 0) && (ntok == 2)) {
+      platform_gic_cfg.gicrd_base[0] = v[0];
+  } else if ((strcmp(tok[0], "its") == 0) && (ntok == 3) &&
+             (v[0] < PLATFORM_OVERRIDE_GICITS_COUNT)) {
+      platform_gic_cfg.gicits_base[v[0]] = v[1];
+  } else if ((strcmp(tok[0], "ecam") == 0) && (ntok == 6) && (v[0] < HOST_DESC_MAX_ECAM)) {
+      if (host_desc_num(tok[5], &v[4]) || (v[3] > v[4]) || (v[4] > 0xFF))
+          return 1;
+      platform_pcie_cfg.block[v[0]].ecam_base     = v[1];
+      platform_pcie_cfg.block[v[0]].segment_num   = (uint32_t)v[2];
+      platform_pcie_cfg.block[v[0]].start_bus_num = (uint32_t)v[3];
+      platform_pcie_cfg.block[v[0]].end_bus_num   = (uint32_t)v[4];
+      if (platform_pcie_cfg.num_entries <= v[0])
+          platform_pcie_cfg.num_entries = (uint32_t)v[0] + 1;
+  } else if ((strcmp(tok[0], "smmu") == 0) && (ntok == 3) && (v[0] < IOVIRT_SMMUV3_COUNT)) {
+      platform_smmu_node_data.smmu[v[0]].base = v[1];
+  } else if ((strcmp(tok[0], "ras") == 0) && (ntok == 4) && (v[0] < RAS_MAX_NUM_NODES)) {
+      platform_ras_node_interface.intf_info[v[0]].intf_type   = 1;
+      platform_ras_node_interface.intf_info[v[0]].base_addr   = v[1];
+      platform_ras_node_interface.intf_info[v[0]].num_err_rec = (uint32_t)v[2];
+      if (platform_ras_cfg.num_nodes <= v[0])
+          platform_ras_cfg.num_nodes = (uint32_t)v[0] + 1;
+  } else if (strcmp(tok[0], "pcie") == 0) {
+      return host_desc_pcie(tok, ntok);
+  } else {
+      return 1;
+  }
+
+  return 0;
+}
+
+/**
+  @brief  Applies a platform description file to the platform configuration
+          tables of the FVP port before the info tables are created.
+          Each line holds one directive, '#' starts a comment.
+
+  @param  path  Description file
+
+  @return 0 on success
+**/
+int
+pal_host_desc_load(const char *path)
+{
+  FILE *fp;
+  char line[512];
+  char *tok[HOST_DESC_MAX_TOKEN];
+  char *p;
+  uint32_t ntok, line_num = 0, num_pe = 0;
+
+  fp = fopen(path, "r");
+  if (fp == NULL) {
+      print(AVS_PRINT_ERR, "\n HOST: cannot open %s\n", path);
+      return 1;
+  }
+
+  while (fgets(line, sizeof(line), fp)) {
+      line_num++;
+      p = strchr(line, '#');
+      if (p)
+          *p = '\0';
+
+      ntok = 0;
+      for (p = strtok(line, " \t\r\n"); p && (ntok < HOST_DESC_MAX_TOKEN); p = strtok(NULL, " \t\r\n"))
+          tok[ntok++] = p;
+
+      if (ntok == 0)
+          continue;
+
+      if (host_desc_line(tok, ntok, &num_pe)) {
+          print(AVS_PRINT_ERR, "\n HOST: %s:%d: invalid directive\n", path, line_num);
+          fclose(fp);
+          return 1;
+      }
+  }
+
+  fclose(fp);
+  host_desc_pcie_hierarchy();
+  return 0;
+}
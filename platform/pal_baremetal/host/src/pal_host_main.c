@@ -0,0 +1,98 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include <unistd.h>
+
+#include "include/pal_common_support.h"
+#include "pal_host.h"
+
+extern uint32_t g_single_test;
+extern uint32_t g_single_module;
+
+int32_t ShellAppMainsbsa(void);
+
+static void
+host_usage(const char *prog)
+{
+  printf("Usage: %s [-f <platform description>] [-m <module>] [-t <test>]\n"
+         "       [-o <log file>] [-l <log verbosity>]\n", prog);
+}
+
+/**
+  @brief  Entry point of the host build. The calling thread runs as PE 0,
+          secondary PEs are started through the emulated PSCI CPU_ON.
+**/
+int
+main(int argc, char **argv)
+{
+  const char *desc = NULL;
+  const char *log = NULL;
+  uint32_t log_level = PLATFORM_OVERRIDE_PRINT_LEVEL;
+  int opt, ret;
+
+  while ((opt = getopt(argc, argv, "f:m:t:o:l:h")) != -1) {
+      switch (opt) {
+      case 'f':
+          desc = optarg;
+          break;
+      case 'm':
+          g_single_module = (uint32_t)strtoul(optarg, NULL, 0);
+          break;
+      case 't':
+          g_single_test = (uint32_t)strtoul(optarg, NULL, 0);
+          break;
+      case 'o':
+          log = optarg;
+          break;
+      case 'l':
+          log_level = (uint32_t)strtoul(optarg, NULL, 0);
+          break;
+      default:
+          host_usage(argv[0]);
+          return (opt == 'h') ? 0 : 1;
+      }
+  }
+
+  if (desc && pal_host_desc_load(desc))
+      return 1;
+
+  if (pal_host_pe_init() || pal_host_model_init()) {
+      print(AVS_PRINT_ERR, "\n HOST: failed to build the platform model\n", 0);
+      return 1;
+  }
+
+  pal_host_exception_init();
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  if (log) {
+      g_host_log_file = fopen(log, "w");
+      if (g_host_log_file == NULL) {
+          print(AVS_PRINT_ERR, "\n HOST: failed to open the log file\n", 0);
+          return 1;
+      }
+      val_log_init(log_level);
+  }
+
+  ret = ShellAppMainsbsa();
+
+  if (g_host_log_file) {
+      val_log_flush();
+      fclose(g_host_log_file);
+  }
+
+  return ret;
+}
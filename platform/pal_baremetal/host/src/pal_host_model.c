@@ -0,0 +1,462 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include "include/pal_common_support.h"
+#include "include/platform_override_struct.h"
+#include "pal_host.h"
+
+extern PE_INFO_TABLE platform_pe_cfg;
+extern PLATFORM_OVERRIDE_GIC_INFO_TABLE platform_gic_cfg;
+extern PLATFORM_OVERRIDE_IOVIRT_INFO_TABLE platform_iovirt_cfg;
+extern PLATFORM_OVERRIDE_SMMU_NODE_DATA platform_smmu_node_data;
+extern RAS_INFO_TABLE platform_ras_cfg;
+extern PLATFORM_OVERRIDE_RAS_NODE_INTERFACE_INFO platform_ras_node_interface;
+
+/* Regions sorted by base address, looked up with a binary search */
+static HOST_REGION *g_host_region[HOST_MAX_REGIONS];
+static uint32_t    g_host_num_region;
+
+#define HOST_GICD_SIZE           0x10000
+#define HOST_GICR_FRAME_SIZE     0x20000
+#define HOST_GITS_SIZE           0x20000
+#define HOST_SMMU_SIZE           0x20000
+#define HOST_RAS_SIZE            0x10000
+
+#define HOST_GIC_PIDR2           0xFFE8
+#define HOST_GIC_PIDR2_V3        0x3B
+
+/**
+  @brief  Registers an MMIO window backed by a zero initialised register file.
+
+  @param  base   Physical base address of the window
+  @param  size   Size of the window in bytes
+  @param  name   Name used in diagnostics
+  @param  read   Read hook, NULL for RAM-like behaviour
+  @param  write  Write hook, NULL for RAM-like behaviour
+  @param  ctx    Model private data
+
+  @return Region on success, NULL if the window overlaps another one
+**/
+HOST_REGION *
+pal_host_region_add(uint64_t base, uint64_t size, const char *name,
+                    HOST_REG_READ read, HOST_REG_WRITE write, void *ctx)
+{
+  HOST_REGION *region;
+  uint32_t i;
+
+  if ((g_host_num_region == HOST_MAX_REGIONS) || (size == 0))
+      return NULL;
+
+  for (i = 0; i < g_host_num_region; i++) {
+      if ((base < g_host_region[i]->base + g_host_region[i]->size) &&
+          (g_host_region[i]->base < base + size)) {
+          print(AVS_PRINT_WARN, "\n HOST: %s overlaps %s", name, g_host_region[i]->name);
+          return NULL;
+      }
+  }
+
+  region = calloc(1, sizeof(HOST_REGION));
+  if (region == NULL)
+      return NULL;
+
+  region->regs = calloc(1, size);
+  if (region->regs == NULL) {
+      free(region);
+      return NULL;
+  }
+
+  region->base  = base;
+  region->size  = size;
+  region->read  = read;
+  region->write = write;
+  region->ctx   = ctx;
+  region->name  = name;
+  pthread_mutex_init(&region->lock, NULL);
+
+  /* Keep the table sorted */
+  i = g_host_num_region;
+  while ((i > 0) && (g_host_region[i - 1]->base > base)) {
+      g_host_region[i] = g_host_region[i - 1];
+      i--;
+  }
+  g_host_region[i] = region;
+  g_host_num_region++;
+
+  return region;
+}
+
+/**
+  @brief  Returns the region containing the physical address addr.
+**/
+HOST_REGION *
+pal_host_region_find(uint64_t addr)
+{
+  uint32_t lo = 0, hi = g_host_num_region;
+  uint32_t mid;
+
+  while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (addr < g_host_region[mid]->base)
+          hi = mid;
+      else if (addr >= g_host_region[mid]->base + g_host_region[mid]->size)
+          lo = mid + 1;
+      else
+          return g_host_region[mid];
+  }
+
+  return NULL;
+}
+
+/**
+  @brief  Raw access to the register file of a region, no side effects.
+**/
+uint64_t
+pal_host_reg_get(HOST_REGION *region, uint64_t offset, uint32_t size)
+{
+  uint64_t data = 0;
+
+  if (offset + size > region->size)
+      return 0;
+
+  memcpy(&data, region->regs + offset, size);
+  return data;
+}
+
+void
+pal_host_reg_set(HOST_REGION *region, uint64_t offset, uint32_t size, uint64_t data)
+{
+  if (offset + size > region->size)
+      return;
+
+  memcpy(region->regs + offset, &data, size);
+}
+
+/**
+  @brief  Model entry points used by pal_mmio_*. Accesses outside every
+          modelled window read as zero and writes are dropped.
+**/
+uint64_t
+pal_host_mmio_read(uint64_t addr, uint32_t size)
+{
+  HOST_REGION *region = pal_host_region_find(addr);
+  uint64_t data;
+
+  if (region == NULL)
+      return 0;
+
+  pthread_mutex_lock(&region->lock);
+  if (region->read)
+      data = region->read(region, addr - region->base, size);
+  else
+      data = pal_host_reg_get(region, addr - region->base, size);
+  pthread_mutex_unlock(&region->lock);
+
+  return data;
+}
+
+void
+pal_host_mmio_write(uint64_t addr, uint32_t size, uint64_t data)
+{
+  HOST_REGION *region = pal_host_region_find(addr);
+
+  if (region == NULL)
+      return;
+
+  pthread_mutex_lock(&region->lock);
+  if (region->write)
+      region->write(region, addr - region->base, size, data);
+  else
+      pal_host_reg_set(region, addr - region->base, size, data);
+  pthread_mutex_unlock(&region->lock);
+}
+
+/* GIC set/clear register pairs share the state kept at the set offset */
+static uint32_t
+host_gic_set_clear_pair(uint64_t offset, uint32_t *clear)
+{
+  uint64_t reg = offset & 0xFFFF;
+
+  *clear = 0;
+  if ((reg >= 0x100) && (reg < 0x400)) {
+      *clear = ((reg & 0xFF) >= 0x80);
+      return 1;
+  }
+
+  return 0;
+}
+
+static uint64_t
+host_gic_read(HOST_REGION *region, uint64_t offset, uint32_t size)
+{
+  uint32_t clear;
+
+  if (host_gic_set_clear_pair(offset, &clear) && clear)
+      offset -= 0x80;
+
+  return pal_host_reg_get(region, offset, size);
+}
+
+static void
+host_gic_write(HOST_REGION *region, uint64_t offset, uint32_t size, uint64_t data)
+{
+  uint32_t clear;
+  uint64_t state;
+
+  if (host_gic_set_clear_pair(offset, &clear)) {
+      if (clear)
+          offset -= 0x80;
+      state = pal_host_reg_get(region, offset, size);
+      pal_host_reg_set(region, offset, size, clear ? (state & ~data) : (state | data));
+      return;
+  }
+
+  switch (offset) {
+  case 0x4:       /* GICD_TYPER */
+  case 0x8:       /* GICD_IIDR */
+  case HOST_GIC_PIDR2:
+      return;
+  default:
+      pal_host_reg_set(region, offset, size, data);
+  }
+}
+
+static void
+host_gicr_write(HOST_REGION *region, uint64_t offset, uint32_t size, uint64_t data)
+{
+  uint64_t reg = offset & (HOST_GICR_FRAME_SIZE - 1);
+
+  switch (reg) {
+  case 0x8:       /* GICR_TYPER */
+  case 0xC:
+  case HOST_GIC_PIDR2:
+      return;
+  case 0x14:      /* GICR_WAKER, ChildrenAsleep follows ProcessorSleep */
+      data &= 0x2;
+      pal_host_reg_set(region, offset, 4, data | (data << 1));
+      return;
+  default:
+      if (reg >= 0x10000)
+          host_gic_write(region, offset, size, data);
+      else
+          pal_host_reg_set(region, offset, size, data);
+  }
+}
+
+static void
+host_gits_write(HOST_REGION *region, uint64_t offset, uint32_t size, uint64_t data)
+{
+  switch (offset) {
+  case 0x0:       /* GITS_CTLR, always quiescent */
+      pal_host_reg_set(region, offset, 4, (data & 0x1) | (1u << 31));
+      return;
+  case 0x8:       /* GITS_TYPER */
+  case HOST_GIC_PIDR2:
+      return;
+  case 0x88:      /* GITS_CWRITER, commands complete immediately */
+      pal_host_reg_set(region, offset, size, data);
+      pal_host_reg_set(region, 0x90, size, data);
+      return;
+  default:
+      pal_host_reg_set(region, offset, size, data);
+  }
+}
+
+/**
+  @brief  Executes the commands between CMDQ_CONS and the new CMDQ_PROD. Only
+          CMD_SYNC has a visible effect: its MSI completion write, host VA
+          and PA being identical.
+**/
+static void
+host_smmu_cmdq_consume(HOST_REGION *region, uint32_t prod)
+{
+  uint64_t base = pal_host_reg_get(region, 0x90, 8);
+  uint32_t log2size = base & 0x1F;
+  uint32_t mask = (1u << (log2size + 1)) - 1;
+  uint32_t cons = (uint32_t)pal_host_reg_get(region, 0x9C, 4) & mask;
+  uint64_t *cmd;
+
+  base &= 0x000FFFFFFFFFFFE0ull;
+  if (base == 0)
+      return;
+
+  for (prod &= mask; cons != prod; cons = (cons + 1) & mask) {
+      cmd = (uint64_t *)(base + (uint64_t)(cons & ((1u << log2size) - 1)) * 16);
+      if (((cmd[0] & 0xFF) == 0x46) && (((cmd[0] >> 12) & 0x3) == 0x1))
+          *(volatile uint32_t *)(cmd[1] & 0x000FFFFFFFFFFFFCull) = (uint32_t)(cmd[0] >> 32);
+  }
+}
+
+static void
+host_smmu_write(HOST_REGION *region, uint64_t offset, uint32_t size, uint64_t data)
+{
+  if (offset < 0x20)      /* IDR0-5, IIDR, AIDR */
+      return;
+
+  pal_host_reg_set(region, offset, size, data);
+
+  switch (offset) {
+  case 0x20:      /* CR0 -> CR0ACK */
+      pal_host_reg_set(region, 0x24, 4, data);
+      break;
+  case 0x44:      /* GBPA, update completes immediately */
+      pal_host_reg_set(region, 0x44, 4, data & ~(1ull << 31));
+      break;
+  case 0x50:      /* IRQ_CTRL -> IRQ_CTRLACK */
+      pal_host_reg_set(region, 0x54, 4, data);
+      break;
+  case 0x98:      /* CMDQ_PROD, the queue drains immediately */
+      host_smmu_cmdq_consume(region, (uint32_t)data);
+      pal_host_reg_set(region, 0x9C, 4, data);
+      break;
+  default:
+      break;
+  }
+}
+
+static void
+host_ras_write(HOST_REGION *region, uint64_t offset, uint32_t size, uint64_t data)
+{
+  uint64_t status;
+
+  if ((offset < 0xE00) && ((offset & 0x3F) == 0x0))      /* ERR<n>FR */
+      return;
+
+  if ((offset < 0xE00) && ((offset & 0x3F) == 0x10)) {   /* ERR<n>STATUS */
+      status = pal_host_reg_get(region, offset, 4);
+      status = (status & ~(data & 0xFFF00000)) & 0xFFF00000;
+      pal_host_reg_set(region, offset, 4, status | (data & 0xFFFFF));
+      return;
+  }
+
+  pal_host_reg_set(region, offset, size, data);
+}
+
+static void
+host_gic_model_init(void)
+{
+  HOST_REGION *region;
+  uint64_t mpidr, aff;
+  uint32_t num_pe = platform_pe_cfg.header.num_of_pe;
+  uint32_t i, frame;
+
+  if (platform_gic_cfg.num_gicd) {
+      region = pal_host_region_add(platform_gic_cfg.gicd_base[0], HOST_GICD_SIZE, "GICD",
+                                   host_gic_read, host_gic_write, NULL);
+      if (region) {
+          /* IDbits 16, LPIS, 1020 SPIs */
+          pal_host_reg_set(region, 0x4, 4, (15u << 19) | (1u << 17) | 31u);
+          pal_host_reg_set(region, 0x8, 4, 0x0200043B);
+          pal_host_reg_set(region, HOST_GIC_PIDR2, 4, HOST_GIC_PIDR2_V3);
+      }
+  }
+
+  if (platform_gic_cfg.num_gicrd) {
+      region = pal_host_region_add(platform_gic_cfg.gicrd_base[0],
+                                   (uint64_t)num_pe * HOST_GICR_FRAME_SIZE, "GICR",
+                                   host_gic_read, host_gicr_write, NULL);
+      for (frame = 0; region && (frame < num_pe); frame++) {
+          mpidr = platform_pe_cfg.pe_info[frame].mpidr;
+          aff = (mpidr & 0xFFFFFF) | ((mpidr >> 8) & 0xFF000000);
+          pal_host_reg_set(region, (uint64_t)frame * HOST_GICR_FRAME_SIZE + 0x8, 8,
+                           (aff << 32) | ((uint64_t)frame << 8) |
+                           ((frame == num_pe - 1) ? 0x10 : 0) | 0x1);
+          pal_host_reg_set(region, (uint64_t)frame * HOST_GICR_FRAME_SIZE + 0x14, 4, 0x6);
+          pal_host_reg_set(region, (uint64_t)frame * HOST_GICR_FRAME_SIZE + HOST_GIC_PIDR2, 4,
+                           HOST_GIC_PIDR2_V3);
+      }
+  }
+
+  for (i = 0; i < platform_gic_cfg.num_gicits; i++) {
+      region = pal_host_region_add(platform_gic_cfg.gicits_base[i], HOST_GITS_SIZE, "GITS",
+                                   NULL, host_gits_write, NULL);
+      if (region == NULL)
+          continue;
+      pal_host_reg_set(region, 0x0, 4, 1u << 31);
+      pal_host_reg_set(region, 0x8, 8, 0x1 | (7u << 4) | (15u << 8) | (15u << 13));
+      pal_host_reg_set(region, 0x100, 8, (1ull << 56) | (7ull << 48));
+      pal_host_reg_set(region, 0x108, 8, (4ull << 56) | (7ull << 48));
+      pal_host_reg_set(region, HOST_GIC_PIDR2, 4, HOST_GIC_PIDR2_V3);
+  }
+}
+
+static void
+host_smmu_model_init(void)
+{
+  HOST_REGION *region;
+  uint32_t i, smmu = 0;
+
+  for (i = 0; i < platform_iovirt_cfg.node_count; i++) {
+      if (platform_iovirt_cfg.type[i] != IOVIRT_NODE_SMMU_V3)
+          continue;
+
+      region = pal_host_region_add(platform_smmu_node_data.smmu[smmu++].base, HOST_SMMU_SIZE,
+                                   "SMMUv3", NULL, host_smmu_write, NULL);
+      if (region == NULL)
+          continue;
+
+      /* 2-level stream table, AArch64 tables, S1 + S2, coherent, ATS, 16-bit ASID/VMID */
+      pal_host_reg_set(region, 0x0, 4, (1u << 27) | (1u << 26) | (1u << 19) | (1u << 18) |
+                                       (1u << 14) | (1u << 13) | (1u << 12) | (1u << 10) |
+                                       (1u << 9) | (2u << 6) | (1u << 5) | (1u << 4) |
+                                       (2u << 2) | 0x3);
+      pal_host_reg_set(region, 0x4, 4, (8u << 21) | (7u << 16) | (16u << 6) | 16u);
+      pal_host_reg_set(region, 0xC, 4, 1u << 10);
+      pal_host_reg_set(region, 0x14, 4, (1u << 6) | (1u << 4) | 0x5);
+      pal_host_reg_set(region, 0x1C, 4, 0x2);
+  }
+}
+
+static void
+host_ras_model_init(void)
+{
+  HOST_REGION *region;
+  PLATFORM_OVERRIDE_RAS_NODE_INTERFACE *intf;
+  uint32_t i, rec;
+
+  for (i = 0; i < platform_ras_cfg.num_nodes; i++) {
+      intf = &platform_ras_node_interface.intf_info[i];
+      /* Only memory mapped error record groups need a model */
+      if ((intf->intf_type != 1) || (intf->base_addr == 0))
+          continue;
+
+      region = pal_host_region_add(intf->base_addr, HOST_RAS_SIZE, "RAS",
+                                   NULL, host_ras_write, NULL);
+      if (region == NULL)
+          continue;
+
+      for (rec = 0; rec < intf->num_err_rec; rec++)
+          pal_host_reg_set(region, (uint64_t)rec * 64, 8, 0x2555);
+      pal_host_reg_set(region, 0xFC8, 4, intf->num_err_rec);
+      pal_host_reg_set(region, 0xFBC, 4, 0x47700A00);
+  }
+}
+
+/**
+  @brief  Builds the register models of every block described by the
+          platform configuration tables.
+
+  @return 0 on success
+**/
+int
+pal_host_model_init(void)
+{
+  host_gic_model_init();
+  host_smmu_model_init();
+  host_ras_model_init();
+
+  return pal_host_pcie_model_init();
+}
@@ -0,0 +1,372 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include "include/pal_common_support.h"
+#include "include/pal_pcie_enum.h"
+#include "include/platform_override_struct.h"
+#include "pal_host.h"
+
+extern PCIE_INFO_TABLE platform_pcie_cfg;
+extern PCIE_READ_TABLE platform_pcie_device_hierarchy;
+
+/* Device/port types of the PCI Express capability */
+#define HOST_PCIE_EP      0x0
+#define HOST_PCIE_RP      0x4
+#define HOST_PCIE_USP     0x5
+#define HOST_PCIE_DSP     0x6
+#define HOST_PCIE_RCIEP   0x9
+#define HOST_PCIE_RCEC    0xA
+
+#define HOST_PCIE_PM_CAP      0x40
+#define HOST_PCIE_EXP_CAP     0x50
+#define HOST_PCIE_AER_ECAP    0x100
+#define HOST_PCIE_ACS_ECAP    0x148
+
+/* Memory windows handed out by pal_pcie_enumerate, backed as RAM */
+#define HOST_PCIE_BAR_WINDOW  0x700000
+
+#define CFG_DW(off)           ((off) >> 2)
+
+typedef struct {
+  uint32_t cfg[PCIE_CFG_SIZE / 4];
+  uint32_t reset[PCIE_CFG_SIZE / 4];
+  uint32_t wmask[PCIE_CFG_SIZE / 4];
+  uint32_t w1cmask[PCIE_CFG_SIZE / 4];
+  HOST_PCIE_FUNC *desc;
+} HOST_PCIE_CFG;
+
+typedef struct {
+  uint32_t seg;
+  uint32_t start_bus;
+  uint32_t num_bus;
+  HOST_PCIE_CFG **func;
+} HOST_PCIE_ECAM;
+
+static HOST_PCIE_ECAM g_host_ecam[8];
+static uint32_t       g_host_num_ecam;
+
+static int
+host_pcie_is_bridge(uint32_t dp_type)
+{
+  return ((dp_type == HOST_PCIE_RP) || (dp_type == HOST_PCIE_USP) ||
+          (dp_type == HOST_PCIE_DSP));
+}
+
+static HOST_PCIE_CFG *
+host_pcie_func(HOST_PCIE_ECAM *ecam, uint32_t bus, uint32_t devfn)
+{
+  if ((bus < ecam->start_bus) || (bus >= ecam->start_bus + ecam->num_bus))
+      return NULL;
+
+  return ecam->func[(bus - ecam->start_bus) * 256 + devfn];
+}
+
+static void
+host_pcie_reg(HOST_PCIE_CFG *f, uint32_t offset, uint32_t value, uint32_t wmask, uint32_t w1c)
+{
+  f->cfg[CFG_DW(offset)]     = value;
+  f->wmask[CFG_DW(offset)]   = wmask;
+  f->w1cmask[CFG_DW(offset)] = w1c;
+}
+
+static void
+host_pcie_build_bars(HOST_PCIE_CFG *f)
+{
+  HOST_PCIE_FUNC *d = f->desc;
+  uint64_t mask;
+  uint32_t i, num_bar = host_pcie_is_bridge(d->dp_type) ? 2 : 6;
+
+  for (i = 0; i < num_bar; i++) {
+      if (d->bar_size[i] == 0)
+          continue;
+
+      mask = ~(d->bar_size[i] - 1);
+      host_pcie_reg(f, BAR0_OFFSET + 4 * i, d->bar_flags[i], (uint32_t)mask & ~0xFu, 0);
+
+      /* Upper half of a 64-bit BAR */
+      if (((d->bar_flags[i] >> 1) & 0x3) == 0x2) {
+          i++;
+          host_pcie_reg(f, BAR0_OFFSET + 4 * i, 0, (uint32_t)(mask >> 32), 0);
+      }
+  }
+}
+
+static void
+host_pcie_build_cfg(HOST_PCIE_CFG *f, uint32_t multi_func)
+{
+  HOST_PCIE_FUNC *d = f->desc;
+  uint32_t port = (d->dp_type == HOST_PCIE_RP) || (d->dp_type == HOST_PCIE_DSP);
+  uint32_t bridge = host_pcie_is_bridge(d->dp_type);
+  uint32_t devcap;
+
+  host_pcie_reg(f, 0x0, d->vendor_id | (d->device_id << 16), 0, 0);
+  /* Command, Status with Capabilities List */
+  host_pcie_reg(f, 0x4, 0x00100000, 0x0547, 0xF9000000);
+  host_pcie_reg(f, 0x8, (d->class_code << 8) | 0x1, 0, 0);
+  host_pcie_reg(f, 0xC, ((uint32_t)bridge << 16) | (multi_func << 23), 0xFF, 0);
+  host_pcie_reg(f, 0x34, HOST_PCIE_PM_CAP, 0, 0);
+
+  host_pcie_build_bars(f);
+
+  if (bridge) {
+      host_pcie_reg(f, 0x18, 0, 0xFFFFFFFF, 0);
+      host_pcie_reg(f, 0x1C, 0, 0x0000F0F0, 0xF9000000);
+      host_pcie_reg(f, 0x20, 0, 0xFFF0FFF0, 0);
+      host_pcie_reg(f, 0x24, 0x00010001, 0xFFF0FFF0, 0);
+      host_pcie_reg(f, 0x28, 0, 0xFFFFFFFF, 0);
+      host_pcie_reg(f, 0x2C, 0, 0xFFFFFFFF, 0);
+      /* Interrupt line/pin, Bridge Control (Parity, SERR, SBR) */
+      host_pcie_reg(f, 0x3C, 0x00000100, 0x004300FF, 0);
+  } else {
+      host_pcie_reg(f, 0x2C, d->vendor_id | (d->device_id << 16), 0, 0);
+      host_pcie_reg(f, 0x3C, 0x00000100, 0x000000FF, 0);
+  }
+
+  /* Power Management capability */
+  host_pcie_reg(f, HOST_PCIE_PM_CAP, 0x00030001 | (HOST_PCIE_EXP_CAP << 8), 0, 0);
+  host_pcie_reg(f, HOST_PCIE_PM_CAP + 0x4, 0x8, 0x0103, 0x8000);
+
+  /* PCI Express capability, version 2 */
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP, 0x10 | ((0x2 | (d->dp_type << 4) |
+                ((uint32_t)port << 8)) << 16), 0, 0);
+  devcap = 0x1 | (1u << 15);
+  if (d->flr)
+      devcap |= (1u << 28);
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x4, devcap, 0, 0);
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x8, 0x2810, 0x7FFF, 0x000F0000);
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0xC, 0x4 | (4u << 4) | ((uint32_t)port << 20), 0, 0);
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x10, (0x4 | (4u << 4) | ((uint32_t)port << 13)) << 16,
+                0x0FFB, 0xC0000000);
+  if (port) {
+      host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x14, 0, 0, 0);
+      host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x18, 0, 0xFFFF, 0x01FF0000);
+  }
+  if ((d->dp_type == HOST_PCIE_RP) || (d->dp_type == HOST_PCIE_RCEC)) {
+      host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x1C, 0, 0x1F, 0);
+      host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x20, 0, 0, 0x00010000);
+  }
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x24, 0x1F | ((uint32_t)port << 5) | (1u << 11) |
+                (1u << 16) | (1u << 17), 0, 0);
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x28, 0, 0xFFFF, 0);
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x2C, 0x1E, 0, 0);
+  host_pcie_reg(f, HOST_PCIE_EXP_CAP + 0x30, 0x4, 0xFFFF, 0);
+
+  /* AER extended capability, followed by ACS on downstream ports */
+  host_pcie_reg(f, HOST_PCIE_AER_ECAP, 0x00020001 | (port ? (HOST_PCIE_ACS_ECAP << 20) : 0),
+                0, 0);
+  host_pcie_reg(f, HOST_PCIE_AER_ECAP + 0x4, 0, 0, 0xFFFFFFFF);
+  host_pcie_reg(f, HOST_PCIE_AER_ECAP + 0x8, 0, 0xFFFFFFFF, 0);
+  host_pcie_reg(f, HOST_PCIE_AER_ECAP + 0xC, 0x00462030, 0xFFFFFFFF, 0);
+  host_pcie_reg(f, HOST_PCIE_AER_ECAP + 0x10, 0, 0, 0xFFFFFFFF);
+  host_pcie_reg(f, HOST_PCIE_AER_ECAP + 0x14, 0x0000E000, 0xFFFFFFFF, 0);
+  host_pcie_reg(f, HOST_PCIE_AER_ECAP + 0x18, 0, 0x0000015F, 0);
+  if (port) {
+      host_pcie_reg(f, HOST_PCIE_ACS_ECAP, 0x0001000D, 0, 0);
+      host_pcie_reg(f, HOST_PCIE_ACS_ECAP + 0x4, 0x5F, 0x005F0000, 0);
+  }
+
+  memcpy(f->reset, f->cfg, sizeof(f->cfg));
+}
+
+static void
+host_pcie_reset_bus_range(HOST_PCIE_ECAM *ecam, uint32_t sec_bus, uint32_t sub_bus)
+{
+  HOST_PCIE_CFG *f;
+  uint32_t bus, devfn;
+
+  for (bus = sec_bus; (bus <= sub_bus) && (bus != 0); bus++) {
+      for (devfn = 0; devfn < 256; devfn++) {
+          f = host_pcie_func(ecam, bus, devfn);
+          if (f)
+              memcpy(f->cfg, f->reset, sizeof(f->cfg));
+      }
+  }
+}
+
+static uint64_t
+host_ecam_read(HOST_REGION *region, uint64_t offset, uint32_t size)
+{
+  HOST_PCIE_ECAM *ecam = region->ctx;
+  HOST_PCIE_CFG *f;
+  uint32_t reg = (uint32_t)(offset & (PCIE_CFG_SIZE - 1));
+  uint64_t data;
+
+  f = host_pcie_func(ecam, ecam->start_bus + (uint32_t)(offset >> 20),
+                     (uint32_t)(offset >> 12) & 0xFF);
+  /* Config reads to absent functions complete as Unsupported Request */
+  if (f == NULL)
+      return (size == 8) ? ~0ull : ((1ull << (size * 8)) - 1);
+
+  data = f->cfg[CFG_DW(reg)];
+  if (size == 8)
+      data |= (uint64_t)f->cfg[CFG_DW(reg) + 1] << 32;
+  else
+      data = (data >> ((reg & 0x3) * 8)) & ((1ull << (size * 8)) - 1);
+
+  return data;
+}
+
+static void
+host_ecam_write_dw(HOST_PCIE_ECAM *ecam, HOST_PCIE_CFG *f, uint32_t reg, uint32_t data,
+                   uint32_t byte_mask)
+{
+  uint32_t dw = CFG_DW(reg);
+  uint32_t old = f->cfg[dw];
+  uint32_t wmask = f->wmask[dw] & byte_mask;
+  uint32_t w1c = f->w1cmask[dw] & byte_mask;
+  uint32_t val;
+
+  val = (old & ~wmask) | (data & wmask);
+  val &= ~(data & w1c);
+  f->cfg[dw] = val;
+
+  /* Initiate Function Level Reset */
+  if ((reg == HOST_PCIE_EXP_CAP + 0x8) && (data & byte_mask & 0x8000) && f->desc->flr) {
+      memcpy(f->cfg, f->reset, sizeof(f->cfg));
+      return;
+  }
+
+  /* Secondary Bus Reset asserted */
+  if ((reg == 0x3C) && host_pcie_is_bridge(f->desc->dp_type) &&
+      (val & (1u << 22)) && !(old & (1u << 22)))
+      host_pcie_reset_bus_range(ecam, (f->cfg[CFG_DW(0x18)] >> 8) & 0xFF,
+                                (f->cfg[CFG_DW(0x18)] >> 16) & 0xFF);
+}
+
+static void
+host_ecam_write(HOST_REGION *region, uint64_t offset, uint32_t size, uint64_t data)
+{
+  HOST_PCIE_ECAM *ecam = region->ctx;
+  HOST_PCIE_CFG *f;
+  uint32_t reg = (uint32_t)(offset & (PCIE_CFG_SIZE - 1));
+  uint32_t shift = (reg & 0x3) * 8;
+
+  f = host_pcie_func(ecam, ecam->start_bus + (uint32_t)(offset >> 20),
+                     (uint32_t)(offset >> 12) & 0xFF);
+  if (f == NULL)
+      return;
+
+  if (size == 8) {
+      host_ecam_write_dw(ecam, f, reg, (uint32_t)data, 0xFFFFFFFF);
+      host_ecam_write_dw(ecam, f, reg + 4, (uint32_t)(data >> 32), 0xFFFFFFFF);
+      return;
+  }
+
+  host_ecam_write_dw(ecam, f, reg & ~0x3u, (uint32_t)(data << shift),
+                     (uint32_t)(((1ull << (size * 8)) - 1) << shift));
+}
+
+/* Without pcie directives the model instantiates the functions of the
+ * platform hierarchy table as RCiEPs, so pal_pcie_check_device_list passes.
+ */
+static void
+host_pcie_default_desc(void)
+{
+  PCIE_READ_BLOCK *dev;
+  HOST_PCIE_FUNC *d;
+  uint32_t i;
+
+  for (i = 0; (i < platform_pcie_device_hierarchy.num_entries) &&
+              (i < HOST_MAX_PCIE_FUNC); i++) {
+      dev = &platform_pcie_device_hierarchy.device[i];
+      d = &g_host_desc.pcie_func[g_host_desc.num_pcie_func++];
+      memset(d, 0, sizeof(*d));
+      d->seg          = dev->seg;
+      d->bus          = dev->bus;
+      d->dev          = dev->dev;
+      d->func         = dev->func;
+      d->dp_type      = HOST_PCIE_RCIEP;
+      d->class_code   = (uint32_t)(dev->class_code >> 8);
+      d->vendor_id    = dev->vendor_id;
+      d->device_id    = dev->device_id;
+      d->flr          = 1;
+      d->bar_size[0]  = 0x10000;
+      d->bar_flags[0] = 0x4;
+  }
+}
+
+/**
+  @brief  Creates the config space models of every described function and
+          registers one ECAM window per PCIe info block.
+
+  @return 0 on success
+**/
+int
+pal_host_pcie_model_init(void)
+{
+  HOST_PCIE_ECAM *ecam;
+  HOST_PCIE_FUNC *d;
+  HOST_PCIE_CFG *f;
+  uint32_t i, j, multi_func;
+
+  if (g_host_desc.num_pcie_func == 0)
+      host_pcie_default_desc();
+
+  for (i = 0; (i < platform_pcie_cfg.num_entries) && (i < 8); i++) {
+      ecam = &g_host_ecam[g_host_num_ecam++];
+      ecam->seg       = platform_pcie_cfg.block[i].segment_num;
+      ecam->start_bus = platform_pcie_cfg.block[i].start_bus_num;
+      ecam->num_bus   = platform_pcie_cfg.block[i].end_bus_num - ecam->start_bus + 1;
+      ecam->func      = calloc((size_t)ecam->num_bus * 256, sizeof(HOST_PCIE_CFG *));
+      if (ecam->func == NULL)
+          return 1;
+
+      pal_host_region_add(platform_pcie_cfg.block[i].ecam_base +
+                          ((uint64_t)ecam->start_bus << 20),
+                          (uint64_t)ecam->num_bus << 20, "ECAM",
+                          host_ecam_read, host_ecam_write, ecam);
+  }
+
+  for (i = 0; i < g_host_desc.num_pcie_func; i++) {
+      d = &g_host_desc.pcie_func[i];
+      for (j = 0; j < g_host_num_ecam; j++) {
+          ecam = &g_host_ecam[j];
+          if ((ecam->seg == d->seg) && (d->bus >= ecam->start_bus) &&
+              (d->bus < ecam->start_bus + ecam->num_bus))
+              break;
+      }
+      if (j == g_host_num_ecam) {
+          print(AVS_PRINT_WARN, "\n HOST: no ECAM for %x:%x:%x.%x", d->seg, d->bus, d->dev,
+                d->func);
+          continue;
+      }
+
+      f = calloc(1, sizeof(HOST_PCIE_CFG));
+      if (f == NULL)
+          return 1;
+
+      multi_func = 0;
+      for (j = 0; j < g_host_desc.num_pcie_func; j++) {
+          if ((g_host_desc.pcie_func[j].seg == d->seg) && (g_host_desc.pcie_func[j].bus == d->bus) &&
+              (g_host_desc.pcie_func[j].dev == d->dev) && (g_host_desc.pcie_func[j].func != 0))
+              multi_func = 1;
+      }
+
+      f->desc = d;
+      host_pcie_build_cfg(f, multi_func);
+      ecam->func[(d->bus - ecam->start_bus) * 256 + (d->dev << 3) + d->func] = f;
+  }
+
+  pal_host_region_add(PLATFORM_OVERRIDE_PCIE_BAR32P_VAL, HOST_PCIE_BAR_WINDOW, "BAR32P",
+                      NULL, NULL, NULL);
+  pal_host_region_add(PLATFORM_OVERRIDE_PCIE_BAR32NP_VAL, HOST_PCIE_BAR_WINDOW, "BAR32NP",
+                      NULL, NULL, NULL);
+  pal_host_region_add(PLATFORM_OVERRIDE_PCIE_BAR64_VAL, HOST_PCIE_BAR_WINDOW, "BAR64",
+                      NULL, NULL, NULL);
+
+  return 0;
+}
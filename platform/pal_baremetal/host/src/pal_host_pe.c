@@ -0,0 +1,264 @@
+/** @file
+ * Copyright (c) 2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+#include <signal.h>
+#include <ucontext.h>
+#include <sched.h>
+
+#include "include/pal_common_support.h"
+#include "include/platform_override_struct.h"
+#include "pal_host.h"
+
+extern PE_INFO_TABLE platform_pe_cfg;
+
+#define PSCI_VERSION            0x84000000
+#define PSCI_CPU_SUSPEND        0xC4000001
+#define PSCI_CPU_OFF            0x84000002
+#define PSCI_CPU_ON             0xC4000003
+#define PSCI_AFFINITY_INFO      0xC4000004
+#define PSCI_SYSTEM_OFF         0x84000008
+#define PSCI_SYSTEM_RESET       0x84000009
+
+#define PSCI_RET_SUCCESS        0
+#define PSCI_RET_NOT_SUPPORTED  -1
+#define PSCI_RET_INVALID_PARAMS -2
+#define PSCI_RET_ALREADY_ON     -4
+#define PSCI_RET_INTERN_FAIL    -6
+
+/* Synchronous exception vector slot, see EXCEPT_AARCH64_SYNCHRONOUS_EXCEPTIONS */
+#define HOST_EXCEPT_SYNC        0
+
+static HOST_PE         g_host_pe[HOST_MAX_PE];
+static uint32_t        g_host_num_pe;
+static __thread HOST_PE *g_host_pe_self;
+
+typedef struct {
+  HOST_PE *pe;
+  void    (*entry)(void);
+} HOST_PE_START;
+
+/**
+  @brief  Creates the emulated PE state from the PE configuration table.
+          The calling thread becomes PE 0.
+
+  @return 0 on success
+**/
+int
+pal_host_pe_init(void)
+{
+  uint32_t i;
+
+  g_host_num_pe = platform_pe_cfg.header.num_of_pe;
+  if ((g_host_num_pe == 0) || (g_host_num_pe > HOST_MAX_PE))
+      return 1;
+
+  for (i = 0; i < g_host_num_pe; i++) {
+      g_host_pe[i].index = i;
+      g_host_pe[i].mpidr = platform_pe_cfg.pe_info[i].mpidr;
+      g_host_pe[i].state = HOST_PE_OFF;
+      pal_host_sysreg_init(&g_host_pe[i]);
+      if (g_host_pe[i].sysreg == NULL)
+          return 1;
+  }
+
+  g_host_pe[0].state = HOST_PE_ON;
+  g_host_pe[0].thread = pthread_self();
+  g_host_pe_self = &g_host_pe[0];
+
+  return 0;
+}
+
+HOST_PE *
+pal_host_pe_self(void)
+{
+  return g_host_pe_self ? g_host_pe_self : &g_host_pe[0];
+}
+
+HOST_PE *
+pal_host_pe_by_mpidr(uint64_t mpidr)
+{
+  uint32_t i;
+
+  mpidr &= 0xFF00FFFFFFULL;
+  for (i = 0; i < g_host_num_pe; i++) {
+      if ((g_host_pe[i].mpidr & 0xFF00FFFFFFULL) == mpidr)
+          return &g_host_pe[i];
+  }
+
+  return NULL;
+}
+
+static void *
+host_pe_start(void *arg)
+{
+  HOST_PE_START start = *(HOST_PE_START *)arg;
+
+  free(arg);
+  g_host_pe_self = start.pe;
+  __atomic_store_n(&start.pe->state, HOST_PE_ON, __ATOMIC_RELEASE);
+
+  start.entry();
+
+  /* The entry point returned without PSCI_CPU_OFF */
+  __atomic_store_n(&start.pe->state, HOST_PE_OFF, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static int64_t
+host_psci_cpu_on(uint64_t mpidr, uint64_t entry)
+{
+  HOST_PE *pe = pal_host_pe_by_mpidr(mpidr);
+  HOST_PE_START *start;
+  pthread_attr_t attr;
+  uint32_t off = HOST_PE_OFF;
+
+  if ((pe == NULL) || (entry == 0))
+      return PSCI_RET_INVALID_PARAMS;
+
+  if (!__atomic_compare_exchange_n(&pe->state, &off, HOST_PE_ON_PENDING, 0,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+      return PSCI_RET_ALREADY_ON;
+
+  start = malloc(sizeof(HOST_PE_START));
+  if (start == NULL) {
+      pe->state = HOST_PE_OFF;
+      return PSCI_RET_INTERN_FAIL;
+  }
+  start->pe = pe;
+  start->entry = (void (*)(void))entry;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  if (pthread_create(&pe->thread, &attr, host_pe_start, start)) {
+      pthread_attr_destroy(&attr);
+      free(start);
+      pe->state = HOST_PE_OFF;
+      return PSCI_RET_INTERN_FAIL;
+  }
+  pthread_attr_destroy(&attr);
+
+  return PSCI_RET_SUCCESS;
+}
+
+/**
+  @brief  Emulates the PSCI firmware interface. args holds x0-x3 on entry,
+          the return value is written back to args[0].
+**/
+void
+pal_host_psci_call(uint64_t *args)
+{
+  HOST_PE *pe;
+  int64_t ret = PSCI_RET_NOT_SUPPORTED;
+
+  switch ((uint32_t)args[0]) {
+  case PSCI_VERSION:
+      ret = 0x10001;
+      break;
+  case PSCI_CPU_SUSPEND:
+      sched_yield();
+      ret = PSCI_RET_SUCCESS;
+      break;
+  case PSCI_CPU_ON:
+      ret = host_psci_cpu_on(args[1], args[2]);
+      break;
+  case PSCI_CPU_OFF:
+      pe = pal_host_pe_self();
+      if (pe->index == 0) {
+          ret = PSCI_RET_NOT_SUPPORTED;
+          break;
+      }
+      __atomic_store_n(&pe->state, HOST_PE_OFF, __ATOMIC_RELEASE);
+      pthread_exit(NULL);
+      break;
+  case PSCI_AFFINITY_INFO:
+      pe = pal_host_pe_by_mpidr(args[1]);
+      ret = pe ? (int64_t)__atomic_load_n(&pe->state, __ATOMIC_ACQUIRE) : PSCI_RET_INVALID_PARAMS;
+      break;
+  case PSCI_SYSTEM_OFF:
+  case PSCI_SYSTEM_RESET:
+      fflush(stdout);
+      exit(0);
+  default:
+      break;
+  }
+
+  args[0] = (uint64_t)ret;
+}
+
+/* Handlers VAL installs through val_gic_sbsa_install_esr on baremetal targets */
+typedef void (*sbsa_fp)(uint64_t, void *);
+extern sbsa_fp g_esr_handler[4];
+
+static uint64_t
+host_pe_context_pc(void *uctx)
+{
+  ucontext_t *uc = uctx;
+
+#if defined(__x86_64__)
+  return (uint64_t)uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+  return uc->uc_mcontext.pc;
+#else
+  (void)uc;
+  return 0;
+#endif
+}
+
+/* Faulting accesses of a PE are delivered to its synchronous exception
+ * handler. The handler moves the return address through pal_pe_update_elr,
+ * which rewrites the program counter of the interrupted host context. A
+ * handler that leaves the program counter alone would fault again, so the
+ * fault is then treated as unhandled.
+ */
+static void
+host_pe_fault(int sig, siginfo_t *info, void *uctx)
+{
+  HOST_PE *pe = pal_host_pe_self();
+  void (*esr)(uint64_t, void *) = pe->esr[HOST_EXCEPT_SYNC];
+  uint64_t pc = host_pe_context_pc(uctx);
+
+  if (esr == NULL)
+      esr = g_esr_handler[HOST_EXCEPT_SYNC];
+
+  if (esr != NULL) {
+      /* Data Abort from the current EL, translation fault */
+      pe->fault_esr = (0x25ull << 26) | (1ull << 25) | 0x7;
+      pe->fault_far = (uint64_t)info->si_addr;
+      esr(HOST_EXCEPT_SYNC, uctx);
+      if (host_pe_context_pc(uctx) != pc)
+          return;
+  }
+
+  fprintf(stderr, "\n HOST: PE %u unhandled fault at %p\n", pe->index, info->si_addr);
+
+  /* The fault kills the process on return, save the buffered log first */
+  val_log_flush();
+  signal(sig, SIG_DFL);
+}
+
+void
+pal_host_exception_init(void)
+{
+  struct sigaction sa;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = host_pe_fault;
+  sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGSEGV, &sa, NULL);
+  sigaction(SIGBUS, &sa, NULL);
+}
@@ -0,0 +1,361 @@
+/** @file
+ * Copyright (c) 2020-2023, Arm Limited or its affiliates. All rights reserved.
+ * SPDX-License-Identifier : Apache-2.0
+
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+**/
+
+
+#include "include/pal_pcie_enum.h"
+#include "include/pal_common_support.h"
+#include "pal_host.h"
+
+extern void* g_sbsa_log_file_handle;
+
+uint8_t   *gSharedMemory;
+/**
+  @brief  Provides a single point of abstraction to read from all
+          Memory Mapped IO address
+
+  @param  addr 64-bit address
+
+  @return 8-bit data read from the input address
+**/
+uint8_t
+pal_mmio_read8(uint64_t addr)
+{
+  uint8_t data;
+
+  data = (uint8_t)pal_host_mmio_read(addr, 1);
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(AVS_PRINT_INFO, " pal_mmio_read8 Address = %llx  Data = %lx \n", addr, data);
+
+  return data;
+}
+
+/**
+  @brief  Provides a single point of abstraction to read from all
+          Memory Mapped IO address
+
+  @param  addr 64-bit address
+
+  @return 16-bit data read from the input address
+**/
+uint16_t
+pal_mmio_read16(uint64_t addr)
+{
+  uint16_t data;
+
+  data = (uint16_t)pal_host_mmio_read(addr, 2);
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(AVS_PRINT_INFO, " pal_mmio_read16 Address = %llx  Data = %lx \n", addr, data);
+
+  return data;
+}
+
+/**
+  @brief  Provides a single point of abstraction to read from all
+          Memory Mapped IO address
+
+  @param  addr 64-bit address
+
+  @return 64-bit data read from the input address
+**/
+uint64_t
+pal_mmio_read64(uint64_t addr)
+{
+  uint64_t data;
+
+  data = (uint64_t)pal_host_mmio_read(addr, 8);
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(AVS_PRINT_INFO, " pal_mmio_read64 Address = %llx  Data = %llx \n", addr, data);
+
+  return data;
+}
+
+/**
+  @brief  Provides a single point of abstraction to read from all
+          Memory Mapped IO address
+
+  @param  addr 64-bit address
+
+  @return 32-bit data read from the input address
+**/
+uint32_t
+pal_mmio_read(uint64_t addr)
+{
+
+  uint32_t data;
+
+  if (addr & 0x3) {
+      addr = addr & ~(0x3);  //make sure addr is aligned to 4 bytes
+  }
+
+  data = (uint32_t)pal_host_mmio_read(addr, 4);
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(AVS_PRINT_INFO, " pal_mmio_read Address = %8x  Data = %x \n", addr, data);
+
+  return data;
+
+}
+
+/**
+  @brief  Provides a single point of abstraction to write to all
+          Memory Mapped IO address
+
+  @param  addr  64-bit address
+  @param  data  8-bit data to write to address
+
+  @return None
+**/
+void
+pal_mmio_write8(uint64_t addr, uint8_t data)
+{
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(AVS_PRINT_INFO, " pal_mmio_write8 Address = %llx  Data = %lx \n", addr, data);
+
+  pal_host_mmio_write(addr, 1, data);
+}
+
+/**
+  @brief  Provides a single point of abstraction to write to all
+          Memory Mapped IO address
+
+  @param  addr  64-bit address
+  @param  data  16-bit data to write to address
+
+  @return None
+**/
+void
+pal_mmio_write16(uint64_t addr, uint16_t data)
+{
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(AVS_PRINT_INFO, " pal_mmio_write16 Address = %llx  Data = %lx \n", addr, data);
+
+  pal_host_mmio_write(addr, 2, data);
+}
+
+/**
+  @brief  Provides a single point of abstraction to write to all
+          Memory Mapped IO address
+
+  @param  addr  64-bit address
+  @param  data  64-bit data to write to address
+
+  @return None
+**/
+void
+pal_mmio_write64(uint64_t addr, uint64_t data)
+{
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(AVS_PRINT_INFO, " pal_mmio_write64 Address = %llx  Data = %llx \n", addr, data);
+
+  pal_host_mmio_write(addr, 8, data);
+}
+
+/**
+  @brief  Provides a single point of abstraction to write to all
+          Memory Mapped IO address
+
+  @param  addr  64-bit address
+  @param  data  32-bit data to write to address
+
+  @return None
+**/
+void
+pal_mmio_write(uint64_t addr, uint32_t data)
+{
+
+  if (addr & 0x3) {
+      print(AVS_PRINT_WARN, "\n  Error-Input address is not aligned. Masking the last 2 bits \n");
+      addr = addr & ~(0x3);  //make sure addr is aligned to 4 bytes
+  }
+
+  if (g_print_mmio || (g_curr_module & g_enable_module))
+      print(AVS_PRINT_INFO, " pal_mmio_write Address = %8x  Data = %x \n", addr, data);
+
+    pal_host_mmio_write(addr, 4, data);
+}
+
+/**
+  @brief  Sends a string to the output console without using Baremetal print function
+          This function will get COMM port address and directly writes to the addr char-by-char
+
+  @param  string  An ASCII string
+  @param  data    data for the formatted output
+
+  @return None
+**/
+void
+pal_print_raw(uint64_t addr, char *string, uint64_t data)
+{
+  /* There is no UART model, the console is the host stdout */
+  (void)addr;
+  printf(string, data);
+}
+
+/**
+  @brief  Compares two strings
+
+  @param  FirstString   The pointer to a Null-terminated ASCII string.
+  @param  SecondString  The pointer to a Null-terminated ASCII string.
+  @param  Length        The maximum number of ASCII characters for compare.
+
+  @return Zero if strings are identical, else non-zero value
+**/
+uint32_t
+pal_strncmp(char *FirstString, char *SecondString, uint32_t Length)
+{
+
+  return strncmp(FirstString, SecondString, Length);
+}
+
+/**
+  @brief  Free the memory allocated by UEFI Framework APIs
+  @param  Buffer the base address of the memory range to be freed
+
+  @return None
+**/
+void
+pal_mem_free(void *Buffer)
+{
+  free(Buffer);
+}
+
+/**
+  @brief  Compare the contents of the src and dest buffers
+  @param  Src   - source buffer to be compared
+  @param  Dest  - destination buffer to be compared
+  @param  Len   - Length of the comparison to be performed
+
+  @return Zero if the buffer contecnts are same, else Nonzero
+**/
+uint32_t
+pal_mem_compare(void *Src, void *Dest, uint32_t Len)
+{
+
+  return memcmp(Src, Dest, Len);
+}
+
+/**
+  @brief a buffer with a known specified input value
+  @param  Buf   - Pointer to the buffer to fill
+  @param  Size  - Number of bytes in buffer to fill
+  @param  Value - Value to fill buffer with
+
+  @return None
+**/
+void
+pal_mem_set(void *Buf, uint32_t Size, uint8_t Value)
+{
+  memset(Buf, Value, Size);
+}
+
+uint64_t
+pal_mem_get_shared_addr()
+{
+  return (uint64_t)(gSharedMemory);
+}
+
+/**
+  @brief  Free the shared memory region allocated above
+
+  @param  None
+
+  @return  None
+**/
+void
+pal_mem_free_shared()
+{
+  free ((void *)gSharedMemory);
+}
+
+/**
+  @brief  Allocates requested buffer size in bytes in a contiguous memory
+          and returns the base address of the range.
+
+  @param  Size         allocation size in bytes
+  @retval if SUCCESS   pointer to allocated memory
+  @retval if FAILURE   NULL
+**/
+void *
+pal_mem_alloc(uint32_t Size)
+{
+
+  return malloc(Size);
+}
+
+/**
+  @brief  Allocates requested buffer size in bytes with zeros in a contiguous memory
+          and returns the base address of the range.
+
+  @param  Size         allocation size in bytes
+  @retval if SUCCESS   pointer to allocated memory
+  @retval if FAILURE   NULL
+**/
+void *
+pal_mem_calloc(uint32_t num, uint32_t Size)
+{
+
+  return calloc(num, Size);
+}
+
+
+/**
+  @brief  Allocate memory which is to be used to share data across PEs
+
+  @param  num_pe      - Number of PEs in the system
+  @param  sizeofentry - Size of memory region allocated to each PE
+
+  @return None
+**/
+void
+pal_mem_allocate_shared(uint32_t num_pe, uint32_t sizeofentry)
+{
+   gSharedMemory = 0;
+   gSharedMemory = pal_mem_alloc(num_pe * sizeofentry);
+   pal_pe_data_cache_ops_by_va((uint64_t)&gSharedMemory, CLEAN_AND_INVALIDATE);
+}
+
+/**
+  Copies a source buffer to a destination buffer, and returns the destination buffer.
+
+  @param  DestinationBuffer   The pointer to the destination buffer of the memory copy.
+  @param  SourceBuffer        The pointer to the source buffer of the memory copy.
+  @param  Length              The number of bytes to copy from SourceBuffer to DestinationBuffer.
+
+  @return DestinationBuffer.
+
+**/
+void *
+pal_memcpy(void *DestinationBuffer, void *SourceBuffer, uint32_t Length)
+{
+
+  return memcpy(DestinationBuffer, SourceBuffer, Length);
+}
+
+/**
+  @brief   Checks if System information is passed using Baremetal (BM)
+           This api is also used to check if GIC/Interrupt Init ACS Code
+           is used or not. In case of BM, ACS Code is used for INIT
+
+  @param  None
+
+  @return True/False
+*/
+uint32_t
+pal_target_is_bm()
+{
+  return 1;
+}
+
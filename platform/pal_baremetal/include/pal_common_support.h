@@ -351,9 +351,15 @@ typedef struct {
   PCIE_READ_BLOCK device[];
 } PCIE_READ_TABLE;
 
+#define PCIE_CAP_INDEX_SIZE 20
+
 typedef struct {
   uint32_t bdf;
   uint32_t rp_bdf;
+  uint8_t  cap_state;                     ///< Capability index, owned by VAL
+  uint8_t  num_cap;
+  uint16_t reserved;
+  uint32_t cap[PCIE_CAP_INDEX_SIZE];
 } pcie_device_attr;
 
 typedef struct {
@@ -20,7 +20,7 @@
 
 extern PCIE_INFO_TABLE *g_pcie_info_table;
 
-uint32_t index = 0, enumerate = 1;
+uint32_t g_pcie_index = 0, enumerate = 1;
 /*64-bit address initialisation*/
 uint64_t g_bar64_p_start = PLATFORM_OVERRIDE_PCIE_BAR64_VAL;
 uint64_t g_bar64_p_max;
@@ -54,14 +54,14 @@ uint32_t pal_pci_cfg_read(uint32_t bus, uint32_t dev, uint32_t func, uint32_t of
          if ((bus >= g_pcie_info_table->block[i].start_bus_num) &&
               (bus <= g_pcie_info_table->block[i].end_bus_num))
          {
-                 index = i;
+                 g_pcie_index = i;
                  break;
          }
          i++;
       }
   }
 
-  uint64_t ecam_base = g_pcie_info_table->block[index].ecam_base;
+  uint64_t ecam_base = g_pcie_info_table->block[g_pcie_index].ecam_base;
 
   cfg_addr = (bus * PCIE_MAX_DEV * PCIE_MAX_FUNC * PCIE_CFG_SIZE) + (dev * PCIE_MAX_FUNC * PCIE_CFG_SIZE) + (func * PCIE_CFG_SIZE);
   *value = pal_mmio_read(ecam_base + cfg_addr + offset);
@@ -80,7 +80,7 @@ uint32_t pal_pci_cfg_read(uint32_t bus, uint32_t dev, uint32_t func, uint32_t of
 void pal_pci_cfg_write(uint32_t bus, uint32_t dev, uint32_t func, uint32_t offset, uint32_t data)
 {
 
-  uint64_t ecam_base = g_pcie_info_table->block[index].ecam_base;
+  uint64_t ecam_base = g_pcie_info_table->block[g_pcie_index].ecam_base;
 
   uint32_t cfg_addr;
 
@@ -381,7 +381,7 @@ uint32_t pal_pcie_enumerate_device(uint32_t bus, uint32_t sec_bus)
   uint32_t bar32_p_limit;
   uint32_t bar32_np_limit;
 
-  if (bus == (g_pcie_info_table->block[index].end_bus_num))
+  if (bus == (g_pcie_info_table->block[g_pcie_index].end_bus_num))
       return sub_bus;
 
   uint32_t bar32_p_base = g_bar32_p_start;
@@ -464,7 +464,7 @@ pal_clear_pri_bus()
     uint32_t header_value;
     uint32_t vendor_id;
 
-    for (bus = 0; bus <= g_pcie_info_table->block[index].end_bus_num; bus++)
+    for (bus = 0; bus <= g_pcie_info_table->block[g_pcie_index].end_bus_num; bus++)
     {
         for (dev = 0; dev < PCIE_MAX_DEV; dev++)
         {
@@ -496,16 +496,16 @@ void pal_pcie_enumerate(void)
     }
 
     print(AVS_PRINT_INFO, "\nStarting Enumeration \n", 0);
-    while (index < g_pcie_info_table->num_entries)
+    while (g_pcie_index < g_pcie_info_table->num_entries)
     {
-       pri_bus = g_pcie_info_table->block[index].start_bus_num;
+       pri_bus = g_pcie_info_table->block[g_pcie_index].start_bus_num;
        sec_bus = pri_bus + 1;
        pal_pcie_enumerate_device(pri_bus, sec_bus);
        pal_clear_pri_bus();
-       index++;
+       g_pcie_index++;
     }
     enumerate = 0;
-    index = 0;
+    g_pcie_index = 0;
 }
 
 /**
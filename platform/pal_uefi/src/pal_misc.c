@@ -198,18 +198,45 @@ pal_mmio_write(UINT64 addr, UINT32 data)
 VOID
 pal_print(CHAR8 *string, UINT64 data)
 {
-  if(g_sbsa_log_file_handle)
-  {
-    CHAR8 Buffer[1024];
-    UINTN BufferSize = 1;
-    EFI_STATUS Status = 0;
-    BufferSize = AsciiSPrint(Buffer, 1024, string, data);
-    AsciiPrint(Buffer);
-    Status = ShellWriteFile(g_sbsa_log_file_handle, &BufferSize, (VOID*)Buffer);
-    if(EFI_ERROR(Status))
-      sbsa_print(AVS_PRINT_ERR, L" Error in writing to log file\n");
-  } else
-      AsciiPrint(string, data);
+  AsciiPrint(string, data);
+}
+
+/**
+  @brief  Formats a string for the log file output
+
+  @param  buffer  Output buffer
+  @param  size    Size of the output buffer
+  @param  string  An ASCII string
+  @param  data    data for the formatted output
+
+  @return Number of characters written, excluding the terminating NULL
+**/
+UINT32
+pal_log_format(CHAR8 *buffer, UINT32 size, CHAR8 *string, UINT64 data)
+{
+  return (UINT32)AsciiSPrint(buffer, size, string, data);
+}
+
+/**
+  @brief  Writes a block of formatted output to the log file given with -f
+
+  @param  buffer  Formatted output
+  @param  size    Number of characters to write
+
+  @return None
+**/
+VOID
+pal_log_write(CHAR8 *buffer, UINT32 size)
+{
+  UINTN BufferSize = size;
+  EFI_STATUS Status;
+
+  if (!g_sbsa_log_file_handle || !size)
+    return;
+
+  Status = ShellWriteFile(g_sbsa_log_file_handle, &BufferSize, (VOID*)buffer);
+  if(EFI_ERROR(Status))
+    sbsa_print(AVS_PRINT_ERR, L" Error in writing to log file\n");
 }
 
 /**
@@ -18,7 +18,9 @@
 #include <stdlib.h>
 
 /**
-  @brief   This API generates a 32 bit random number.
+  @brief   This API generates a 32 bit random number. It is the software
+           fallback for platforms without FEAT_RNG or the SMCCC TRNG interface.
+           rand() returns at most 31 bits, so two calls are combined.
   @param   rng_buffer    - Pointer to store the random data
 
   @return  success/failure
@@ -26,7 +28,7 @@
 UINT32
 pal_nist_generate_rng(UINT32 *rng_buffer)
 {
-  *rng_buffer = rand();
+  *rng_buffer = ((UINT32)rand() << 16) ^ (UINT32)rand();
   return 0;
 
 }
@@ -81,6 +81,7 @@ payload(void)
   uint32_t page_size = val_memory_page_size();
   memory_region_descriptor_t mem_desc_array[2], *mem_desc;
   pgt_descriptor_t pgt_desc;
+  uint32_t pgt_arena_attr = PGT_ARENA_NORMAL;
   smmu_master_attributes_t master;
   uint64_t ttbr;
   uint32_t test_data_blk_size = page_size * TEST_DATA_NUM_PAGES;
@@ -200,10 +201,14 @@ payload(void)
           goto test_fail;
         }
 
-        /* set pgt_desc.pgt_base to NULL to create new translation table, val_pgt_create
+        /* Tables walked by an SMMU with coherent access need no cache maintenance */
+        pgt_arena_attr = val_smmu_get_info(SMMU_COHERENT_ACCESS, master.smmu_index) ?
+                         PGT_ARENA_CACHEABLE : PGT_ARENA_NORMAL;
+
+        /* set pgt_desc.pgt_base to NULL to create new translation table, val_pgt_create_in_arena
            will update pgt_desc.pgt_base to point to created translation table */
         pgt_desc.pgt_base = (uint64_t) NULL;
-        if (val_pgt_create(mem_desc, &pgt_desc)) {
+        if (val_pgt_create_in_arena(mem_desc, &pgt_desc, pgt_arena_attr)) {
           val_print(AVS_PRINT_ERR,
                     "\n       Unable to create page table with given attributes", 0);
           goto test_fail;
@@ -212,6 +217,8 @@ payload(void)
         pgt_base_array[instance] = pgt_desc.pgt_base;
 
         /* Configure the SMMU tables for this exerciser to use this page table for VA to PA translations*/
+        master.iova = mem_desc->virtual_address;
+        master.iova_size = mem_desc->length;
         if (val_smmu_map(master, pgt_desc))
         {
             val_print(AVS_PRINT_ERR,
@@ -99,6 +99,7 @@ payload(void)
   memory_region_descriptor_t mem_desc_array[2], *mem_desc;
   smmu_master_attributes_t master = {0, 0, 0, 0, 0};
   pgt_descriptor_t pgt_desc;
+  uint32_t pgt_arena_attr = PGT_ARENA_NORMAL;
   uint64_t ttbr;
   uint32_t exerciser_ssid_bits, status;
   uint64_t pgt_base_pasid1 = 0;
@@ -250,10 +251,14 @@ payload(void)
             goto test_fail;
         }
 
-        /* set pgt_desc.pgt_base to NULL to create new translation table, val_pgt_create
+        /* Tables walked by an SMMU with coherent access need no cache maintenance */
+        pgt_arena_attr = val_smmu_get_info(SMMU_COHERENT_ACCESS, master.smmu_index) ?
+                         PGT_ARENA_CACHEABLE : PGT_ARENA_NORMAL;
+
+        /* set pgt_desc.pgt_base to NULL to create new translation table, val_pgt_create_in_arena
            will update pgt_desc.pgt_base to point to created translation table */
         pgt_desc.pgt_base = (uint64_t) NULL;
-        if (val_pgt_create(mem_desc, &pgt_desc)) {
+        if (val_pgt_create_in_arena(mem_desc, &pgt_desc, pgt_arena_attr)) {
             val_print(AVS_PRINT_ERR,
                      "\n       Unable to create page table with given attributes", 0);
             goto test_fail;
@@ -262,6 +267,8 @@ payload(void)
         pgt_base_pasid1 = pgt_desc.pgt_base;
 
         master.substreamid = TEST_PASID1;
+        master.iova = mem_desc->virtual_address;
+        master.iova_size = mem_desc->length;
         if (val_smmu_map(master, pgt_desc))
         {
             val_print(AVS_PRINT_ERR, "\n       SMMU mapping failed (%d)     ", master.substreamid);
@@ -332,10 +339,10 @@ payload(void)
     mem_desc->length = test_data_blk_size;
     mem_desc->attributes |= PGT_STAGE1_AP_RW;
 
-    /* set pgt_desc.pgt_base to NULL to create new translation table, val_pgt_create
+    /* set pgt_desc.pgt_base to NULL to create new translation table, val_pgt_create_in_arena
        will update pgt_desc.pgt_base to point to created translation table */
     pgt_desc.pgt_base = (uint64_t) NULL;
-    if (val_pgt_create(mem_desc, &pgt_desc)) {
+    if (val_pgt_create_in_arena(mem_desc, &pgt_desc, pgt_arena_attr)) {
         val_print(AVS_PRINT_ERR, "\n       Unable to create page table with given attributes", 0);
         goto test_fail;
     }
@@ -343,6 +350,8 @@ payload(void)
     pgt_base_pasid2 = pgt_desc.pgt_base;
 
     master.substreamid = TEST_PASID2;
+    master.iova = mem_desc->virtual_address;
+    master.iova_size = mem_desc->length;
     if (val_smmu_map(master, pgt_desc))
     {
         val_print(AVS_PRINT_ERR, "\n       SMMU mapping failed (%d)     ", master.substreamid);
@@ -273,6 +273,9 @@ payload(void)
           reg_value = reg_value & ~BRIDGE_CTRL_SBR_SET;
           val_pcie_write_cfg(erp_bdf, TYPE01_ILR, reg_value);
 
+          /* Functions below the port were reset */
+          val_pcie_cap_index_invalidate_bus_range(erp_bdf);
+
           timeout = TIMEOUT_LARGE;
           while (--timeout)
           {};
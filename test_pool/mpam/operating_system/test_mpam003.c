@@ -150,9 +150,7 @@ static void payload(void)
 
                 /* wait for MAX_NRDY_USEC after msc config change */
                 nrdy_timeout = val_mpam_get_info(MPAM_MSC_NRDY, msc_index, 0);
-                while (nrdy_timeout) {
-                    --nrdy_timeout;
-                };
+                val_delay_us(nrdy_timeout);
 
                 /* perform memory operation */
                 val_memcpy(src_buf, dest_buf, BUFFER_SIZE);
@@ -202,9 +202,7 @@ static void payload(void)
 
                     /* wait for MAX_NRDY_USEC after msc config change */
                     nrdy_timeout = val_mpam_get_info(MPAM_MSC_NRDY, msc_index, 0);
-                    while (nrdy_timeout) {
-                        --nrdy_timeout;
-                    };
+                    val_delay_us(nrdy_timeout);
 
                     /*Perform first memory transaction */
                     val_memcpy(src_buf, dest_buf, buf_size);
@@ -237,9 +235,7 @@ static void payload(void)
 
                     /* wait for MAX_NRDY_USEC after msc config change */
                     nrdy_timeout = val_mpam_get_info(MPAM_MSC_NRDY, msc_index, 0);
-                    while (nrdy_timeout) {
-                        --nrdy_timeout;
-                    };
+                    val_delay_us(nrdy_timeout);
 
                     /*Perform second memory transaction */
                     val_memcpy(src_buf, dest_buf, buf_size);
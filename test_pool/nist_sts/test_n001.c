@@ -19,6 +19,7 @@
 #include <math.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdlib.h>
 
 #include "val/include/sbsa_avs_val.h"
 #include "val/include/val_interface.h"
@@ -29,8 +30,9 @@
 #define TEST_DESC  "NIST Statistical Test Suite      \n "
 
 #define BUFFER_SIZE     1000
-#define RND_FILE_SIZE   36428
+#define RND_STREAM_SIZE 36428   /* 32-bit words */
 #define REQ_OPEN_FILES  30
+#define MAX_STREAM_MBITS 214748364  /* Up to 2^31 - 1 bitstreams of 100000 bits */
 #define ALL_NIST_TEST   0xFFFE
 #define NIST_SUITE_1    0xFE
 #define NIST_SUITE_2    0xDE00   /* Test 1 - 7 */
@@ -123,49 +125,90 @@ print_nist_result(void)
   return AVS_STATUS_PASS;
 }
 
+static FILE *stream_archive;
+
+/* Reader for the streamed mode, generates the stream chunk by chunk */
+static
+uint32_t
+read_random_stream(uint8_t *buffer, uint64_t nbytes)
+{
+  if (val_nist_generate_rng_bulk(buffer, nbytes) != AVS_STATUS_PASS)
+      return AVS_STATUS_FAIL;
+
+  if (stream_archive != NULL && fwrite(buffer, 1, nbytes, stream_archive) != nbytes) {
+      val_print(AVS_PRINT_WARN, "\n       Unable to write file data.bin", 0);
+      fclose(stream_archive);
+      stream_archive = NULL;
+  }
+
+  return AVS_STATUS_PASS;
+}
+
 static
 int32_t
-create_random_file(void)
+create_streamed_stream(void)
 {
-  uint32_t  buffer, status = AVS_STATUS_FAIL;
-  FILE     *fp;
-  char      str[] = "data.txt";
-  int32_t   i, j, k, noofr = RND_FILE_SIZE;
-  char      one = '1', zero = '0';
+  uint64_t num_bits;
 
-  fp = fopen(str, "wb");
-  if (fp == NULL)
-  {
-      val_print(AVS_PRINT_ERR, "\n       Unable to create file", 0);
+  if (g_nist_stream_mbits > MAX_STREAM_MBITS) {
+      val_print(AVS_PRINT_ERR, "\n       Streams are limited to %d Mbit", MAX_STREAM_MBITS);
       return AVS_STATUS_FAIL;
   }
 
-  for (i = 0; i < noofr; i++)
-  {
-      /* Get a 32-bit random number */
-      status = val_nist_generate_rng(&buffer);
-      if (status != AVS_STATUS_PASS) {
-	  val_print(AVS_PRINT_ERR, "\n       Random number generation failed", 0);
-	  fclose(fp);
-          return AVS_STATUS_FAIL;
-      }
+  num_bits = (uint64_t)g_nist_stream_mbits * 1000000;
+  val_nist_set_stream_reader(read_random_stream, num_bits);
+  val_print(AVS_PRINT_INFO, "\nA random bitstream of %ld bits is streamed", num_bits);
 
-      /* Convert decimal random number to binary value and
-       * write it as ASCII value in the file
-       */
-      for (j = 31; j >= 0; j--) {
-          k = buffer >> j;
-          if (k & 1)
-	      fwrite(&one, sizeof(char), 1, fp);
-          else
-              fwrite(&zero, sizeof(char), 1, fp);
-      }
+  if (!g_nist_archive)
+      return AVS_STATUS_PASS;
+
+  stream_archive = fopen("data.bin", "wb");
+  if (stream_archive == NULL)
+      val_print(AVS_PRINT_WARN, "\n       Unable to create file data.bin", 0);
+
+  return AVS_STATUS_PASS;
+}
+
+static
+int32_t
+create_random_stream(uint8_t *stream)
+{
+  uint32_t          status;
+  FILE             *fp;
+  char              str[] = "data.bin";
+  NIST_RNG_STATS_t  stats;
+
+  status = val_nist_generate_rng_bulk(stream, RND_STREAM_SIZE * sizeof(uint32_t));
+  if (status != AVS_STATUS_PASS) {
+      val_print(AVS_PRINT_ERR, "\n       Random number generation failed", 0);
+      return AVS_STATUS_FAIL;
+  }
+
+  val_nist_get_rng_stats(&stats);
+  val_print(AVS_PRINT_INFO, "\n       RNG source          : %d", stats.source);
+  val_print(AVS_PRINT_INFO, "\n       RNG throughput (B/s): %ld", stats.throughput);
+  val_print(AVS_PRINT_INFO, "\n       RNG reseed failures : %ld", stats.reseed_failures);
+
+  val_nist_set_stream(stream, (uint64_t)RND_STREAM_SIZE * 32);
+  val_print(AVS_PRINT_INFO, "\nA random bitstream of %d bits created", RND_STREAM_SIZE * 32);
+
+  if (!g_nist_archive)
+      return AVS_STATUS_PASS;
+
+  /* Keep a copy in the STS binary input format for offline analysis */
+  fp = fopen(str, "wb");
+  if (fp == NULL) {
+      val_print(AVS_PRINT_WARN, "\n       Unable to create file data.bin", 0);
+      return AVS_STATUS_PASS;
   }
 
+  if (fwrite(stream, sizeof(uint32_t), RND_STREAM_SIZE, fp) != RND_STREAM_SIZE)
+      val_print(AVS_PRINT_WARN, "\n       Unable to write file data.bin", 0);
+
   fclose(fp);
-  val_print(AVS_PRINT_INFO, "\nA random file with sequence of ASCII 0's and 1's created", 0);
   return AVS_STATUS_PASS;
 }
+
 static
 void
 payload()
@@ -175,6 +218,7 @@ payload()
   char    *dirname = "experiments";
   uint32_t index = val_pe_get_index_mpid(val_pe_get_mpid());
   uint32_t test_list[] = {NIST_SUITE_1, NIST_SUITE_2};
+  uint8_t *stream;
   size_t   test_listsize = sizeof(test_list) / sizeof(test_list[0]);
 
   status = check_prerequisite_nist();
@@ -184,11 +228,26 @@ payload()
       val_print(AVS_PRINT_INFO, "\nSkipping test 8, 9 and 13 of NIST test suite", 0);
   }
 
-  /* Generate a Random file with binary ASCII values */
-  status = create_random_file();
+  /* Long streams are generated while the STS reads them, so that memory
+   * use does not grow with -nistlen. Otherwise the whole bitstream is
+   * generated up front and handed to the STS in memory.
+   */
+  stream = NULL;
+  if (g_nist_stream_mbits) {
+      status = create_streamed_stream();
+  } else {
+      stream = malloc(RND_STREAM_SIZE * sizeof(uint32_t));
+      if (stream == NULL) {
+          val_print(AVS_PRINT_ERR, "\n       Unable to allocate the random bitstream", 0);
+          val_set_status(index, RESULT_SKIP(g_sbsa_level, TEST_NUM, 01));
+          return;
+      }
+
+      status = create_random_stream(stream);
+  }
   if (status != AVS_STATUS_PASS) {
       val_set_status(index, RESULT_SKIP(g_sbsa_level, TEST_NUM, 01));
-      return;
+      goto release_stream;
   }
 
   /* Create the directories required for NIST test suite */
@@ -228,7 +287,7 @@ payload()
   if (status != AVS_STATUS_PASS) {
       val_print(AVS_PRINT_ERR, "\n       Directory not created", 0);
       val_set_status(index, RESULT_SKIP(g_sbsa_level, TEST_NUM, 01));
-      return;
+      goto release_stream;
   }
   else
       val_print(AVS_PRINT_INFO, "\n       Directory created", 0);
@@ -244,7 +303,7 @@ payload()
               val_set_status(index, RESULT_PASS(g_sbsa_level, TEST_NUM, 01));
           } else {
               val_set_status(index, RESULT_SKIP(g_sbsa_level, TEST_NUM, 01));
-              return;
+              goto release_stream;
           }
       }
   }
@@ -257,11 +316,19 @@ payload()
           val_set_status(index, RESULT_PASS(g_sbsa_level, TEST_NUM, 01));
       } else {
           val_set_status(index, RESULT_SKIP(g_sbsa_level, TEST_NUM, 01));
-          return;
+          goto release_stream;
       }
   }
 
   print_nist_result();
+
+release_stream:
+  val_nist_set_stream(NULL, 0);
+  free(stream);
+  if (stream_archive != NULL) {
+      fclose(stream_archive);
+      stream_archive = NULL;
+  }
   return;
 }
 
@@ -270,7 +337,10 @@ n001_entry(uint32_t num_pe)
 {
   uint32_t status = AVS_STATUS_FAIL;
 
-  num_pe = 1;  //This NIST test is run on single processor
+  /* The STS calls into the UEFI C library, which is not MP safe, so it runs
+   * on the primary PE.
+   */
+  num_pe = 1;
 
   status = val_initialize_test(TEST_NUM, TEST_DESC, num_pe, g_sbsa_level, TEST_RULE);
 
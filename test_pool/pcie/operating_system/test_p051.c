@@ -168,6 +168,9 @@ payload(void)
           reg_value = reg_value | BRIDGE_CTRL_SBR_SET;
           val_pcie_write_cfg(bdf,TYPE01_ILR, reg_value);
 
+          /* Functions below the iEP_RP are reset */
+          val_pcie_cap_index_invalidate_bus_range(bdf);
+
           /* Wait for Timeout */
           delay_status = val_time_delay_ms(100 * ONE_MILLISECOND);
           if (delay_status)
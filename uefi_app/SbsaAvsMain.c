@@ -35,6 +35,8 @@ UINT32 g_pcie_cache_present;
 UINT32  g_sbsa_level;
 UINT32  g_print_level;
 UINT32  g_execute_nist;
+UINT32  g_nist_archive;
+UINT32  g_nist_stream_mbits;
 UINT32  g_print_mmio = FALSE;
 UINT32  g_curr_module = 0;
 UINT32  g_enable_module = 0;
@@ -49,6 +51,9 @@ UINT64  g_stack_pointer;
 UINT64  g_exception_ret_addr;
 UINT64  g_ret_addr;
 UINT32  g_wakeup_timeout;
+UINT32  g_pe_pool;
+UINT32  g_profile_csv;
+UINT32  g_pcie_parallel_enum;
 SHELL_FILE_HANDLE g_sbsa_log_file_handle;
 
 STATIC VOID FlushImage (VOID)
@@ -411,6 +416,8 @@ VOID
 freeSbsaAvsMem()
 {
 
+  /* Releases the PE pool, which still walks the PE info table */
+  val_free_shared_mem();
   val_pe_free_info_table();
   val_gic_free_info_table();
   val_timer_free_info_table();
@@ -424,7 +431,6 @@ freeSbsaAvsMem()
   val_hmat_free_info_table();
   val_srat_free_info_table();
   val_ras2_free_info_table();
-  val_free_shared_mem();
 }
 
 VOID
@@ -432,8 +438,8 @@ HelpMsg (
   VOID
   )
 {
-   Print (L"\nUsage: Sbsa.efi [-v <n>] | [-l <n>] | [-f <filename>] | "
-         "[-skip <n>] | [-nist] | [-t <n>] | [-m <n>]\n"
+   Print (L"\nUsage: Sbsa.efi [-v <n>] | [-l <n>] | [-f <filename>] | [-fv <n>] | "
+         "[-skip <n>] | [-nist] | [-nistbin] | [-nistlen <n>] | [-t <n>] | [-m <n>]\n"
          "Options:\n"
          "-v      Verbosity of the Prints\n"
          "        1 shows all prints, 5 shows Errors\n"
@@ -443,17 +449,24 @@ HelpMsg (
          "-l      Level of compliance to be tested for\n"
          "        As per SBSA spec, 3 to 7\n"
          "-f      Name of the log file to record the test results in\n"
+         "-fv     Verbosity of the prints recorded in the log file, defaults to -v\n"
          "-skip   Test(s) to be skipped\n"
          "        Refer to section 4 of SBSA_ACS_User_Guide\n"
          "        To skip a module, use Model_ID as mentioned in user guide\n"
          "        To skip a particular test within a module, use the exact testcase number\n"
          "-nist   Enable the NIST Statistical test suite\n"
+         "-nistbin  Save the NIST input bitstream to data.bin, use with -nist\n"
+         "-nistlen  Evaluate a stream of <n> Mbit read in chunks, use with -nist\n"
          "-t      If set, will only run the specified test, all others will be skipped.\n"
          "-m      If set, will only run the specified module, all others will be skipped.\n"
          "-p2p    Pass this flag to indicate that PCIe Hierarchy Supports Peer-to-Peer\n"
          "-cache  Pass this flag to indicate that if the test system supports PCIe address translation cache\n"
          "-timeout  Set timeout multiple for wakeup tests\n"
          "        1 - min value  5 - max value\n"
+         "-pool   Keep secondary PEs parked between tests instead of PSCI CPU_OFF/CPU_ON\n"
+         "-profile  Print the time and MMIO/config/PSCI access counts of every test as CSV\n"
+         "        at the end of the run, use with -f to save them\n"
+         "-penum  Probe the PCIe ECAM regions on secondary PEs in parallel\n"
          "-p      Option deprecated. PCIe SBSA 7.1(RCiEP) compliance tests are run from SBSA L6+\n"
   );
 }
@@ -462,16 +475,22 @@ STATIC CONST SHELL_PARAM_ITEM ParamList[] = {
   {L"-v"    , TypeValue},    // -v    # Verbosity of the Prints. 1 shows all prints, 5 shows Errors
   {L"-l"    , TypeValue},    // -l    # Level of compliance to be tested for.
   {L"-f"    , TypeValue},    // -f    # Name of the log file to record the test results in.
+  {L"-fv"   , TypeValue},    // -fv   # Verbosity of the prints recorded in the log file.
   {L"-skip" , TypeValue},    // -skip # test(s) to skip execution
   {L"-help" , TypeFlag},     // -help # help : info about commands
   {L"-h"    , TypeFlag},     // -h    # help : info about commands
   {L"-nist" , TypeFlag},     // -nist # Binary Flag to enable the execution of NIST STS
+  {L"-nistbin" , TypeFlag},  // -nistbin # Save the NIST input bitstream as a binary file
+  {L"-nistlen" , TypeValue}, // -nistlen # Length of the streamed NIST bitstream in Mbit
   {L"-mmio" , TypeValue},    // -mmio # Enable pal_mmio prints
   {L"-t"    , TypeValue},    // -t    # Test to be run
   {L"-m"    , TypeValue},    // -m    # Module to be run
   {L"-p2p", TypeFlag},       // -p2p  # Peer-to-Peer is supported
   {L"-cache", TypeFlag},     // -cache# PCIe address translation cache is supported
   {L"-timeout" , TypeValue}, // -timeout # Set timeout multiple for wakeup tests
+  {L"-pool" , TypeFlag},     // -pool # Keep secondary PEs parked in a worker pool
+  {L"-profile" , TypeFlag},  // -profile # Print the per-test profile as CSV
+  {L"-penum" , TypeFlag},    // -penum # Parallel PCIe enumeration
   {NULL     , TypeMax}
   };
 
@@ -496,6 +515,7 @@ ShellAppMainsbsa (
   CHAR16             *ProbParam;
   UINT32             Status;
   UINT32             MmioVerbosity;
+  UINT32             LogLevel;
   UINT32             i;
   VOID               *branch_label;
 
@@ -594,11 +614,22 @@ ShellAppMainsbsa (
     }
   }
 
+  if (g_sbsa_log_file_handle) {
+    CmdLineArg  = ShellCommandLineGetValue (ParamPackage, L"-fv");
+    if (CmdLineArg == NULL) {
+      val_log_init(g_print_level);
+    } else {
+      LogLevel = StrDecimalToUintn(CmdLineArg);
+      val_log_init((LogLevel > 5) ? g_print_level : LogLevel);
+    }
+  }
+
 
   // Options with Flags
   if ((ShellCommandLineGetFlag (ParamPackage, L"-help")) || (ShellCommandLineGetFlag (ParamPackage, L"-h"))){
      HelpMsg();
-     return 0;
+     Status = 0;
+     goto exit_close;
   }
 
 
@@ -630,6 +661,24 @@ ShellAppMainsbsa (
     g_pcie_cache_present = FALSE;
   }
 
+  if (ShellCommandLineGetFlag (ParamPackage, L"-pool")) {
+    g_pe_pool = TRUE;
+  } else {
+    g_pe_pool = FALSE;
+  }
+
+  if (ShellCommandLineGetFlag (ParamPackage, L"-profile")) {
+    g_profile_csv = TRUE;
+  } else {
+    g_profile_csv = FALSE;
+  }
+
+  if (ShellCommandLineGetFlag (ParamPackage, L"-penum")) {
+    g_pcie_parallel_enum = TRUE;
+  } else {
+    g_pcie_parallel_enum = FALSE;
+  }
+
   // Options with Flags
   if (ShellCommandLineGetFlag (ParamPackage, L"-nist")) {
     g_execute_nist = TRUE;
@@ -640,6 +689,19 @@ ShellAppMainsbsa (
   if (g_sbsa_level == 7)
       g_execute_nist = TRUE;
 
+  if (ShellCommandLineGetFlag (ParamPackage, L"-nistbin")) {
+    g_nist_archive = TRUE;
+  } else {
+    g_nist_archive = FALSE;
+  }
+
+  CmdLineArg  = ShellCommandLineGetValue (ParamPackage, L"-nistlen");
+  if (CmdLineArg == NULL) {
+    g_nist_stream_mbits = 0;
+  } else {
+    g_nist_stream_mbits = StrDecimalToUintn(CmdLineArg);
+  }
+
   // Options with Values
   CmdLineArg  = ShellCommandLineGetValue (ParamPackage, L"-t");
   if (CmdLineArg != NULL) {
@@ -671,11 +733,11 @@ ShellAppMainsbsa (
 
   Status = createPeInfoTable();
   if (Status)
-    return Status;
+    goto exit_close;
 
   Status = createGicInfoTable();
   if (Status)
-    return Status;
+    goto exit_close;
 
   createTimerInfoTable();
   createWatchdogInfoTable();
@@ -700,13 +762,17 @@ ShellAppMainsbsa (
   if (Status)
     Print(L" Failed to created RAS2 feature info table \n");
 
+  /* Secondary PEs may take part in the PCIe enumeration, they run with
+     the MMU off and need the image in memory */
+  val_allocate_shared_mem();
+  if (g_pcie_parallel_enum)
+    FlushImage();
+
   createPcieVirtInfoTable();
   createPeripheralInfoTable();
   createPmuInfoTable();
   createRasInfoTable();
 
-  val_allocate_shared_mem();
-
   // Initialise exception vector, so any unexpected exception gets handled by default SBSA exception handler
   branch_label = &&print_test_status;
   val_pe_context_save(AA64ReadSp(), (uint64_t)branch_label);
@@ -775,6 +841,8 @@ print_test_status:
   val_print(AVS_PRINT_TEST, "  Tests Failed = %4d\n", g_sbsa_tests_fail);
   val_print(AVS_PRINT_TEST, "     --------------------------------------------------------- \n", 0);
 
+  val_test_profile_report();
+
   freeSbsaAvsMem();
 
   val_print(AVS_PRINT_TEST, "\n      **  For complete SBSA test coverage, it is ", 0);
@@ -782,12 +850,22 @@ print_test_status:
   val_print(AVS_PRINT_TEST, "\n      *** SBSA tests complete. Reset the system. *** \n\n", 0);
 
   if(g_sbsa_log_file_handle) {
+    val_log_flush();
     ShellCloseFile(&g_sbsa_log_file_handle);
   }
 
   val_pe_context_restore(AA64WriteSp(g_stack_pointer));
 
   return(0);
+
+exit_close:
+  /* Runs that stop before the tests still write out the buffered log */
+  if(g_sbsa_log_file_handle) {
+    val_log_flush();
+    ShellCloseFile(&g_sbsa_log_file_handle);
+  }
+
+  return Status;
 }
 
 #ifndef ENABLE_NIST
@@ -473,6 +473,8 @@ typedef struct {
     uint32_t substreamid;
     uint32_t ssid_bits;
     uint32_t stage2;
+    uint64_t iova;      /* IOVA range of the mapping, 0 size if not known */
+    uint64_t iova_size;
 } smmu_master_attributes_t;
 
 typedef struct {
@@ -663,6 +665,8 @@ uint64_t pal_memory_get_unpopulated_addr(uint64_t *addr, uint32_t instance);
 
 /* Common Definitions */
 void     pal_print(char8_t *string, uint64_t data);
+uint32_t pal_log_format(char8_t *buffer, uint32_t size, char8_t *string, uint64_t data);
+void     pal_log_write(char8_t *buffer, uint32_t size);
 void     pal_print_raw(uint64_t addr, char8_t *string, uint64_t data);
 uint32_t pal_strncmp(char8_t *str1, char8_t *str2, uint32_t len);
 void    *pal_memcpy(void *dest_buffer, void *src_buffer, uint32_t len);
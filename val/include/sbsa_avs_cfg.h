@@ -32,5 +32,10 @@ extern uint64_t g_ret_addr;
 extern uint32_t g_curr_module;
 extern uint32_t g_single_test;
 extern uint32_t g_single_module;
+extern uint32_t g_pe_pool;
+extern uint32_t g_profile_csv;
+extern uint32_t g_pcie_parallel_enum;
+extern uint32_t g_nist_archive;
+extern uint32_t g_nist_stream_mbits;
 
 #endif
@@ -126,6 +126,9 @@ val_run_test_payload(uint32_t test_num, uint32_t num_pe, void (*payload)(void),
 void
 val_data_cache_ops_by_va(addr_t addr, uint32_t type);
 
+void
+val_data_cache_ops_by_range(addr_t addr, uint64_t size, uint32_t type);
+
 /* Module specific print APIs */
 
 typedef enum {
@@ -18,10 +18,18 @@
 #ifndef __SBSA_AVS_IOVIRT_H__
 #define __SBSA_AVS_IOVIRT_H__
 
+typedef struct {
+  uint32_t device_id;
+  uint32_t stream_id;     /* ~0 when the function is not behind an SMMU */
+  uint32_t its_id;
+  uint32_t status;
+} IOVIRT_DEVICE_INFO;
+
 uint64_t val_iovirt_get_smmu_info(SMMU_INFO_e type, uint32_t index);
 uint32_t val_iovirt_check_unique_ctx_intid(uint32_t smmu_index);
 uint32_t val_iovirt_unique_rid_strid_map(uint32_t rc_index);
 int val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id, uint32_t *stream_id, uint32_t *its_id);
+uint32_t val_iovirt_get_device_info_all(IOVIRT_DEVICE_INFO *info);
 uint64_t val_iovirt_get_pcie_rc_info(PCIE_RC_INFO_e type, uint32_t index);
 uint64_t val_iovirt_get_named_comp_info(NAMED_COMP_INFO_e type, uint32_t index);
 uint64_t val_iovirt_get_pmcg_info(PMCG_INFO_e type, uint32_t index);
@@ -71,8 +71,24 @@
 #define BAR_MASK           0xFFFFFFF0
 #define MSI_BIR_MASK       0xFFFFFFF8
 
-/* Allows storage of 2048 valid BDFs */
-#define PCIE_DEVICE_BDF_TABLE_SZ 8192
+
+/* Functions found while probing one ECAM region for the BDF table. The
+   probe of a region may run on a secondary PE, see val_pcie_create_device_bdf_table */
+#define PCIE_SCAN_MAX_BDF      2048
+#define PCIE_SCAN_FULL         0x10000020     /* Shard has no room for another function */
+#define PCIE_SCAN_TIMEOUT_US   (10 * TIMEOUT_US_LARGE)
+
+typedef struct {
+  uint32_t seg_num;
+  uint32_t start_bus;
+  uint32_t end_bus;
+  uint32_t done;          /* Set once the region has been probed */
+  uint32_t status;        /* PCIE_SUCCESS, PCIE_NO_MAPPING or PCIE_SCAN_FULL */
+  uint32_t failed_bus;    /* Bus without ECAM mapping if status is PCIE_NO_MAPPING */
+  uint32_t cfg_reads;
+  uint32_t num_entries;
+  uint32_t bdf[PCIE_SCAN_MAX_BDF];
+} pcie_scan_shard;
 
 typedef enum {
   HEADER = 0,
@@ -126,6 +142,28 @@ typedef struct {
   char                   err_str2[ERR_STRING_SIZE];
 } pcie_cfgreg_bitfield_entry;
 
+/**
+  @brief    Bit-field entries of one config register, probed together by
+            val_pcie_register_bitfields_check
+  @reg_type         Register type of the entries, as in pcie_cfgreg_bitfield_entry
+  @cap_id           cap_id or ecap_id of the entries
+  @reg_offset       Word aligned register offset
+  @dev_port_bitmask Union of the device/port bitmasks of the entries
+  @status           Capability search status for the Function under test
+  @reg_value        Register value, after clearing the status bits
+  @probe_value      Register value read back after the combined toggle write
+**/
+
+typedef struct {
+  uint32_t reg_type;
+  uint32_t cap_id;
+  uint32_t reg_offset;
+  uint32_t dev_port_bitmask;
+  uint32_t status;
+  uint32_t reg_value;
+  uint32_t probe_value;
+} pcie_cfgreg_bitfield_group;
+
 typedef enum {
   MMIO = 0,
   IO = 1
@@ -141,9 +179,21 @@ typedef enum {
   PREFETCHABLE = 1
 } MEM_TYPE;
 
+/* Capability index of a function, filled on BDF table creation and used by
+   val_pcie_find_capability instead of walking the capability lists */
+#define PCIE_CAP_INDEX_SIZE      20
+#define PCIE_CAP_INDEX_ECAP      (1u << 31)    /* Entry is a PCIe extended capability */
+#define PCIE_CAP_INDEX_INVALID   0x0           /* Index must be rebuilt before use */
+#define PCIE_CAP_INDEX_VALID     0x1           /* Index holds every capability */
+#define PCIE_CAP_INDEX_PARTIAL   0x2           /* Index is full, walk the lists on a miss */
+
 typedef struct {
   uint32_t bdf;
   uint32_t rp_bdf;
+  uint8_t  cap_state;                     ///< PCIE_CAP_INDEX_INVALID, _VALID or _PARTIAL
+  uint8_t  num_cap;
+  uint16_t reserved;
+  uint32_t cap[PCIE_CAP_INDEX_SIZE];      ///< PCIE_CAP_INDEX_ECAP | offset << 16 | cap id
 } pcie_device_attr;
 
 typedef struct {
@@ -151,6 +201,16 @@ typedef struct {
   pcie_device_attr device[];         ///< in the format of Segment/Bus/Dev/Func
 } pcie_device_bdf_table;
 
+/* Allows storage of 1023 valid BDFs */
+#define PCIE_DEVICE_BDF_TABLE_ENTRIES 1023
+#define PCIE_DEVICE_BDF_TABLE_SZ (sizeof(pcie_device_bdf_table) + \
+                                  PCIE_DEVICE_BDF_TABLE_ENTRIES * sizeof(pcie_device_attr))
+
+/* Open addressed BDF -> table index hash, twice the table capacity */
+#define PCIE_BDF_HASH_BITS  11
+#define PCIE_BDF_HASH_SIZE  (1 << PCIE_BDF_HASH_BITS)
+#define PCIE_BDF_HASH_EMPTY 0xFFFF
+
 void     val_pcie_write_cfg(uint32_t bdf, uint32_t offset, uint32_t data);
 void     val_pcie_io_write_cfg(uint32_t bdf, uint32_t offset, uint32_t data);
 uint32_t val_pcie_read_cfg(uint32_t bdf, uint32_t offset, uint32_t *data);
@@ -31,6 +31,16 @@
 
 #define INVALID_PE_INFO 0xDEADDEAD
 
+/* Index of the running PE cached in TPIDR_ELx, set by val_pe_cache_index */
+#define PE_TPIDR_VALID           (0x1ull << 63)
+#define PE_TPIDR_MPID_SHIFT      16
+#define PE_TPIDR_INDEX_MASK      0xFFFF
+
+/* MPIDR -> PE index table size limit, in key bits. Wider affinity layouts fall
+   back to a linear search of the PE info table */
+#define PE_MPIDR_INDEX_MAX_BITS  16
+#define PE_MPIDR_INDEX_INVALID   0xFFFF
+
 //
 //  AARCH64 processor exception types.
 //
@@ -142,7 +152,8 @@ typedef enum {
   MAIR_ELx,
   TCR_ELx,
   TTBR_ELx,
-  ID_AA64ZFR0_EL1
+  ID_AA64ZFR0_EL1,
+  TPIDR_ELx
 }SBSA_AVS_PE_REGS;
 
 uint64_t ArmReadMpidr(void);
@@ -281,6 +292,14 @@ uint64_t AA64ReadTtbr1El1(void);
 
 uint64_t AA64ReadTtbr1El2(void);
 
+uint64_t AA64ReadTpidr1(void);
+
+uint64_t AA64ReadTpidr2(void);
+
+void AA64WriteTpidr1(uint64_t write_data);
+
+void AA64WriteTpidr2(uint64_t write_data);
+
 void AA64WritePmsirr(uint64_t write_data);
 
 void AA64WritePmscr2(uint64_t write_data);
@@ -303,8 +322,16 @@ uint64_t ArmRdvl(void);
 
 void ArmCallWFI(void);
 
+void ArmCallWFE(void);
+
+void ArmCallSEV(void);
+
 void ArmExecuteMemoryBarrier(void);
 
+uint64_t AA64FillRndr(uint64_t *buffer, uint64_t count);
+
+uint64_t AA64FillRndrrs(uint64_t *buffer, uint64_t count);
+
 uint64_t AA64ReadZfr0(void);
 
 void SpeProgramUnderProfiling(uint64_t interval, uint64_t address);
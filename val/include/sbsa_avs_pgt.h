@@ -47,10 +47,26 @@
 #define PGT_STAGE2_AP_RO (0x1ull << 6)
 #define PGT_STAGE2_AP_RW (0x3ull << 6)
 
+#define PGT_ENTRY_CONTIG_MASK (0x1ull << 52)
+
 #define PGT_LEVEL_MAX 4
 
+/* Memory backing the translation tables of val_pgt_create_in_arena */
+#define PGT_ARENA_NORMAL    0
+#define PGT_ARENA_CACHEABLE 1
+
+#define PGT_WALK_CACHE_SIZE 64
+
+#define PGT_ARENA_MAX       16
+#define PGT_ARENA_MAX_PAGES 256
+
 uint32_t val_pgt_create(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *pgt_desc);
+uint32_t val_pgt_create_in_arena(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *pgt_desc,
+                                 uint32_t arena_attr);
 void val_pgt_destroy(pgt_descriptor_t pgt_desc);
+uint32_t val_pgt_walk(uint64_t tt_base_phys, uint32_t ias, uint32_t page_size_log2,
+                      uint64_t virtual_address, uint64_t *desc, uint32_t *level);
+void val_pgt_walk_cache_invalidate(void);
 uint64_t val_pgt_get_attributes(pgt_descriptor_t pgt_desc, uint64_t virtual_address, uint64_t *attributes);
 
 #endif
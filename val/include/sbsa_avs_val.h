@@ -24,12 +24,73 @@
 #include "sbsa_avs_common.h"
 
 
+/* One slot per PE, split in three parts by writer. Each part is padded and
+   aligned to the cache writeback granule by val_allocate_shared_mem, so that
+   PEs never share a cache line and a line is never written by both the
+   primary PE and the PE running the payload. Secondary PEs may run with the
+   MMU off, and a write-back of the whole line by the primary PE would drop
+   their non-cacheable writes. Every part starts with a sequence number,
+   odd while the part is being written, see val_shared_mem_write_begin. */
+#define VAL_SHARED_MEM_PARTS  3
+
+/* Payload and worker pool commands, written by the primary PE only */
 typedef struct {
+  uint32_t    seq;        /* Odd during an update of the part */
+  uint32_t    dispatch;   /* Incremented for every payload published */
   uint64_t    data0;
   uint64_t    data1;
+  uint32_t    mbox_seq;   /* Bumped by the primary PE to hand over a new pool command */
+  uint32_t    mbox_cmd;   /* PE_POOL_CMD_RUN or PE_POOL_CMD_OFF */
+}VAL_SHARED_CMD_t;
+
+/* Test status, set to pending by the primary PE before the payload runs and
+   reported by the PE running it */
+typedef struct {
+  uint32_t    seq;
   uint32_t    status;
+}VAL_SHARED_STATUS_t;
+
+/* Payload events, written by the PE running the payload only */
+typedef struct {
+  uint32_t    seq;
+  uint32_t    dispatch;   /* Dispatch number of the payload picked up */
+  uint32_t    done;       /* Dispatch number of the last payload which returned */
+  uint32_t    parked;     /* Set while the PE waits in the worker pool for a command */
+  uint64_t    wake_ts;    /* System counter value when the PE picked up the payload */
+  uint64_t    done_ts;    /* System counter value when the payload returned */
+}VAL_SHARED_EVENT_t;
+
+/* Copy of the three parts of a slot, see val_get_shared_mem_snapshot */
+typedef struct {
+  VAL_SHARED_CMD_t     cmd;
+  VAL_SHARED_STATUS_t  status;
+  VAL_SHARED_EVENT_t   event;
 }VAL_SHARED_MEM_t;
 
+/* Events a PE records in its shared memory slot while running a dispatched payload */
+#define PE_DISPATCH_WAKE  0x1
+#define PE_DISPATCH_DONE  0x2
+
+/* Commands handed over to a secondary PE parked in the worker pool */
+#define PE_POOL_CMD_RUN   0x1
+#define PE_POOL_CMD_OFF   0x2
+
+/* Log file output is collected in a buffer and written out in chunks */
+#define VAL_LOG_BUFFER_SIZE   0x4000
+#define VAL_LOG_LINE_MAX      1024    /* Largest single formatted print */
+
+/* Wall-clock and access count record kept for every test, reported at the end of the run */
+#define VAL_MAX_TEST_PROFILE  512
+#define VAL_TEST_PROFILE_TOP  10      /* Number of tests listed in each sorted table */
+
+typedef struct {
+  uint32_t    test_num;
+  uint32_t    timeouts;   /* Number of VAL timeouts which expired while the test ran */
+  uint64_t    start_ts;   /* System counter value at val_initialize_test */
+  uint64_t    elapsed;    /* System counter ticks up to val_check_for_error */
+  uint32_t    count[PROFILE_COUNT_MAX];   /* Accesses made by the PE running the test */
+}VAL_TEST_PROFILE_t;
+
 uint64_t
 val_pe_reg_read(uint32_t reg_id);
 
@@ -57,5 +118,32 @@ val_set_status(uint32_t index, uint32_t status);
 uint32_t
 val_get_status(uint32_t id);
 
+VAL_SHARED_CMD_t *
+val_get_shared_mem_cmd(uint32_t index);
+
+VAL_SHARED_STATUS_t *
+val_get_shared_mem_status(uint32_t index);
+
+VAL_SHARED_EVENT_t *
+val_get_shared_mem_event(uint32_t index);
+
+void
+val_shared_mem_cache_ops(volatile void *part, uint32_t size, uint32_t type);
+
+void
+val_shared_mem_write_begin(volatile void *part, uint32_t size);
+
+void
+val_shared_mem_write_end(volatile void *part, uint32_t size);
+
+uint32_t
+val_get_shared_mem_snapshot(uint32_t index, VAL_SHARED_MEM_t *snapshot);
+
+void
+val_test_profile_start(uint32_t test_num);
+
+void
+val_test_profile_end(void);
+
 #endif
 
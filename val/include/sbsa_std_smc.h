@@ -96,6 +96,23 @@
 #define ARM_SMC_ID_PSCI_AFFINITY_INFO_OFF         1
 #define ARM_SMC_ID_PSCI_AFFINITY_INFO_ON_PENDING  2
 
+/*
+ * True Random Number Generator (TRNG) firmware interface calls, also in
+ * the Standard Service Call range.
+ */
+#define ARM_SMC_ID_TRNG_VERSION                0x84000050
+#define ARM_SMC_ID_TRNG_FEATURES               0x84000051
+#define ARM_SMC_ID_TRNG_RND_AARCH64            0xc4000053
+
+/* TRNG_RND64 returns up to 192 bits of entropy in x1-x3 */
+#define ARM_SMC_TRNG_RND64_MAX_BITS  192
+
+/* TRNG return error codes */
+#define ARM_SMC_TRNG_RET_SUCCESS            0
+#define ARM_SMC_TRNG_RET_NOT_SUPPORTED      -1
+#define ARM_SMC_TRNG_RET_INVALID_PARAMS     -2
+#define ARM_SMC_TRNG_RET_NO_ENTROPY         -3
+
 /**
   Trigger an SMC call
 
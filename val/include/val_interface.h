@@ -54,6 +54,27 @@
 #define SINGLE_TEST_SENTINEL   10000
 #define SINGLE_MODULE_SENTINEL 10001
 
+/* Timeouts in microseconds, measured on the generic timer system counter */
+#define TIMEOUT_US_LARGE   5000000   /* 5 s */
+#define TIMEOUT_US_MEDIUM  100000    /* 100 ms */
+#define TIMEOUT_US_SMALL   1000      /* 1 ms */
+
+typedef struct {
+  uint64_t start;   /* System counter value when the timeout was started */
+  uint64_t ticks;   /* Length in counter ticks, or in polls when no counter is available */
+  uint64_t polls;   /* Number of expiry checks so far */
+} VAL_TIMEOUT_t;
+
+/* Accesses counted for every test by the VAL wrappers */
+typedef enum {
+  PROFILE_MMIO_READ = 0,
+  PROFILE_MMIO_WRITE,
+  PROFILE_CFG_READ,
+  PROFILE_CFG_WRITE,
+  PROFILE_PSCI,
+  PROFILE_COUNT_MAX
+} VAL_PROFILE_COUNT_e;
+
 /* GENERIC VAL APIs */
 void val_allocate_shared_mem(void);
 void val_free_shared_mem(void);
@@ -61,8 +82,19 @@ void val_print(uint32_t level, char8_t *string, uint64_t data);
 void val_print_raw(uint64_t uart_address, uint32_t level, char8_t *string,
                                                                 uint64_t data);
 void val_print_test_end(uint32_t status, char8_t *string);
+void val_log_init(uint32_t level);
+void val_log_flush(void);
 void val_set_test_data(uint32_t index, uint64_t addr, uint64_t test_data);
 void val_get_test_data(uint32_t index, uint64_t *data0, uint64_t *data1);
+void val_set_test_event(uint32_t index, uint32_t event);
+void val_wait_for_test_completion(uint32_t test_num, uint32_t num_pe, uint64_t timeout_us);
+uint64_t val_get_timestamp(void);
+uint64_t val_ticks_to_us(uint64_t ticks);
+void val_timeout_start(VAL_TIMEOUT_t *timeout, uint64_t time_us);
+uint32_t val_timeout_expired(VAL_TIMEOUT_t *timeout);
+void val_delay_us(uint64_t time_us);
+void val_test_profile_count(VAL_PROFILE_COUNT_e type);
+void val_test_profile_report(void);
 uint32_t val_strncmp(char8_t *str1, char8_t *str2, uint32_t len);
 void    *val_memcpy(void *dest_buffer, void *src_buffer, uint32_t len);
 
@@ -84,6 +116,7 @@ uint64_t val_pe_get_mpid_index(uint32_t index);
 uint32_t val_pe_get_pmu_gsiv(uint32_t index);
 uint64_t val_pe_get_mpid(void);
 uint32_t val_pe_get_index_mpid(uint64_t mpid);
+uint32_t val_pe_cache_index(void);
 uint32_t val_pe_get_index_uid(uint32_t uid);
 uint32_t val_pe_get_uid(uint64_t mpidr);
 uint32_t val_pe_install_esr(uint32_t exception_type, void (*esr)(uint64_t, void *));
@@ -91,6 +124,10 @@ uint32_t val_pe_get_gmain_gsiv(uint32_t index);
 uint32_t val_pe_feat_check(PE_FEAT_NAME pe_feature);
 
 void     val_execute_on_pe(uint32_t index, void (*payload)(void), uint64_t args);
+uint32_t val_pe_cpu_on(uint32_t index);
+uint32_t val_pe_pool_handover(uint32_t index);
+void     val_pe_pool_signal(void);
+void     val_pe_pool_release(void);
 void     val_suspend_pe(uint32_t power_state, uint64_t entry, uint32_t context_id);
 
 /* GIC VAL APIs */
@@ -207,6 +244,8 @@ uint32_t val_pcie_is_onchip_peripheral(uint32_t bdf);
 uint32_t val_pcie_device_port_type(uint32_t bdf);
 uint32_t val_pcie_find_capability(uint32_t bdf, uint32_t cid_type,
                                            uint32_t cid, uint32_t *cid_offset);
+void val_pcie_cap_index_invalidate(uint32_t bdf);
+void val_pcie_cap_index_invalidate_bus_range(uint32_t bdf);
 void val_pcie_disable_bme(uint32_t bdf);
 void val_pcie_enable_bme(uint32_t bdf);
 void val_pcie_disable_msa(uint32_t bdf);
@@ -241,7 +280,8 @@ typedef enum {
   SMMU_IOVIRT_BLOCK,
   SMMU_SSID_BITS,
   SMMU_IN_ADDR_SIZE,
-  SMMU_OUT_ADDR_SIZE
+  SMMU_OUT_ADDR_SIZE,
+  SMMU_COHERENT_ACCESS
 }SMMU_INFO_e;
 
 typedef enum {
@@ -401,8 +441,64 @@ uint64_t val_memory_get_unpopulated_addr(addr_t *addr, uint32_t instance);
 uint32_t val_exerciser_execute_tests(uint32_t level);
 
 /* NIST Statistical tests */
+typedef enum {
+  NIST_RNG_SOURCE_UNKNOWN = 0,
+  NIST_RNG_SOURCE_RNDR,     /* FEAT_RNG RNDR, reseeded with RNDRRS */
+  NIST_RNG_SOURCE_TRNG,     /* SMCCC TRNG firmware interface */
+  NIST_RNG_SOURCE_PAL       /* pal_nist_generate_rng software fallback */
+} NIST_RNG_SOURCE_e;
+
+typedef struct {
+  uint32_t source;           /* NIST_RNG_SOURCE_e used for the last request */
+  uint64_t bytes;            /* Bytes generated by the last request */
+  uint64_t time_us;          /* Time taken by the last request */
+  uint64_t throughput;       /* Bytes per second, 0 if the time is unknown */
+  uint64_t reseed_failures;  /* Reads that returned no entropy and were retried */
+} NIST_RNG_STATS_t;
+
+/* Fills a buffer with the next bytes of a streamed bitstream */
+typedef uint32_t (*NIST_STREAM_READER)(uint8_t *buffer, uint64_t nbytes);
+
+/* Running counts of a streamed sequence, see val_nist_stream_update */
+typedef struct {
+  uint64_t bits;          /* Bits added so far */
+  uint64_t ones;
+  uint64_t runs;
+  uint32_t last_bit;      /* Last bit added, to join runs across ranges */
+  int64_t  sum;           /* Cumulative sum of the +1/-1 form */
+  int64_t  sum_max;       /* Highest partial sum, at least 0 */
+  int64_t  sum_min;       /* Lowest partial sum, at most 0 */
+  uint64_t block_len;     /* Block frequency block length M */
+  uint64_t block_fill;    /* Bits in the current block */
+  uint64_t block_ones;    /* Ones in the current block */
+  uint64_t blocks;        /* Whole blocks */
+  uint64_t block_dev;     /* Sum of (2 * ones - M)^2 over the whole blocks */
+  uint32_t pattern_len;   /* Serial test pattern length m */
+  uint32_t window;        /* Last m bits */
+  uint32_t head;          /* First m - 1 bits */
+  uint32_t *counts;       /* 2^m overlapping pattern counters */
+} NIST_STREAM_STATE_t;
+
 uint32_t val_nist_execute_tests(uint32_t level, uint32_t num_pe);
 uint32_t val_nist_generate_rng(uint32_t *rng_buffer);
+uint32_t val_nist_generate_rng_bulk(void *buffer, uint64_t nbytes);
+void     val_nist_get_rng_stats(NIST_RNG_STATS_t *stats);
+void     val_nist_set_stream(const uint8_t *data, uint64_t num_bits);
+uint64_t val_nist_get_stream(const uint8_t **data);
+void     val_nist_set_stream_reader(NIST_STREAM_READER reader, uint64_t num_bits);
+uint32_t val_nist_read_stream(uint8_t *buffer, uint64_t nbytes);
+uint64_t val_nist_count_ones(const uint8_t *data, uint64_t start, uint64_t n);
+uint64_t val_nist_count_runs(const uint8_t *data, uint64_t start, uint64_t n);
+uint32_t val_nist_longest_run(const uint8_t *data, uint64_t start, uint64_t n);
+void     val_nist_cusum(const uint8_t *data, uint64_t start, uint64_t n,
+                        int64_t *sum, int64_t *max, int64_t *min);
+void     val_nist_count_patterns(const uint8_t *data, uint64_t start, uint64_t n,
+                                 uint32_t m, uint32_t *counts);
+void     val_nist_stream_init(NIST_STREAM_STATE_t *state, uint32_t block_len,
+                             uint32_t pattern_len, uint32_t *counts);
+void     val_nist_stream_update(NIST_STREAM_STATE_t *state, const uint8_t *data,
+                               uint64_t start, uint64_t n);
+void     val_nist_stream_finish(NIST_STREAM_STATE_t *state);
 
 /* PMU test related APIS*/
 void     val_pmu_create_info_table(uint64_t *pmu_info_table);
@@ -19,10 +19,42 @@
 #include "include/sbsa_avs_common.h"
 #include "include/sbsa_avs_iovirt.h"
 #include "include/sbsa_avs_smmu.h"
+#include "include/sbsa_avs_pcie.h"
+#include "include/sbsa_avs_memory.h"
 
 IOVIRT_INFO_TABLE *g_iovirt_info_table;
 uint32_t g_num_smmus;
 
+extern pcie_device_bdf_table *g_pcie_bdf_table;
+
+/* Resolution of one RID range, every RID of the range maps at the same offset */
+typedef struct {
+  uint32_t segment;
+  uint32_t rid_base;
+  uint32_t rid_last;     /* Inclusive */
+  uint32_t sid_base;     /* ~0 when the RC maps straight to an ITS group */
+  uint32_t did_base;
+  uint32_t its_id;
+  uint32_t status;       /* IOVIRT_RID_MAP_OK or the lookup failure */
+} IOVIRT_RID_MAP;
+
+#define IOVIRT_RID_MAP_OK          0
+#define IOVIRT_RID_MAP_INVALID_REF 1
+#define IOVIRT_RID_MAP_NO_DEVID    2
+#define IOVIRT_RID_MAP_NOT_FOUND   3
+
+#define IOVIRT_RID_MAP_INIT_SIZE   64
+
+/* RID -> StreamID -> DeviceID chain of every RC ID mapping, sorted by segment
+   and RID with no overlap. Built by val_iovirt_create_info_table, lookups walk
+   the IoVirt info table instead when the build failed. */
+static IOVIRT_RID_MAP *g_iovirt_rid_map;
+static uint32_t g_iovirt_rid_map_count;
+static uint32_t g_iovirt_rid_map_size;
+static uint32_t g_iovirt_rid_map_valid;
+
+typedef void (*IOVIRT_EMIT_FN)(void *ctx, ID_MAP *map, uint32_t id_base, uint32_t id_last);
+
 /**
   @brief   This API is a single point of entry to retrieve
            SMMU information stored in the IoVirt Info table
@@ -274,34 +306,315 @@ val_iovirt_unique_rid_strid_map(uint32_t rc_index)
 }
 
 /**
-  @brief  Calculate the device id and stream id orresponding to the requestor id
-  @param  rid          Requestor ID
-  @param  segment      pci_segment_number
-  @param  *device_id   Pointer to device id
-  @param  *stream_id   Pointer to stream id
-  @param  *its_id      Pointer to its id
-  @return status
+  @brief  Append a resolved range to the RID map, extending the previous range when
+          this one continues it.
+  @param  ent  resolved range
+  @return 0 on success, AVS_STATUS_ERR if the map cannot grow
 **/
+static uint32_t
+iovirt_rid_map_add(IOVIRT_RID_MAP *ent)
+{
+  uint32_t i, len;
+  IOVIRT_RID_MAP *prev, *map;
+
+  if (g_iovirt_rid_map_count) {
+      prev = &g_iovirt_rid_map[g_iovirt_rid_map_count - 1];
+      len = prev->rid_last - prev->rid_base + 1;
+      if (prev->segment == ent->segment && prev->status == ent->status &&
+          prev->its_id == ent->its_id && prev->rid_last + 1 == ent->rid_base &&
+          prev->did_base + len == ent->did_base &&
+          (prev->sid_base == ~((uint32_t)0) ? ent->sid_base == ~((uint32_t)0) :
+                                              prev->sid_base + len == ent->sid_base)) {
+          prev->rid_last = ent->rid_last;
+          return 0;
+      }
+  }
 
-int
-val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
-                           uint32_t *stream_id, uint32_t *its_id)
+  if (g_iovirt_rid_map_count == g_iovirt_rid_map_size) {
+      len = g_iovirt_rid_map_size ? 2 * g_iovirt_rid_map_size : IOVIRT_RID_MAP_INIT_SIZE;
+      map = val_memory_calloc(len, sizeof(IOVIRT_RID_MAP));
+      if (map == NULL)
+          return AVS_STATUS_ERR;
+      for (i = 0; i < g_iovirt_rid_map_count; i++)
+          map[i] = g_iovirt_rid_map[i];
+      if (g_iovirt_rid_map)
+          val_memory_free(g_iovirt_rid_map);
+      g_iovirt_rid_map = map;
+      g_iovirt_rid_map_size = len;
+  }
+
+  g_iovirt_rid_map[g_iovirt_rid_map_count++] = *ent;
+  return 0;
+}
+
+/**
+  @brief  Split an ID range into the pieces translated by a list of ID mappings. An
+          ID takes the first mapping of the list that covers it, which is the order
+          the linear IORT walk resolves overlapping mappings in.
+  @param  maps     ID mappings in priority order
+  @param  num      number of mappings
+  @param  id_base  first ID of the range
+  @param  id_last  last ID of the range
+  @param  emit     called in ascending ID order for every piece, with NULL for the
+                   pieces no mapping covers
+  @param  ctx      passed to emit
+  @return None
+**/
+static void
+iovirt_split_range(ID_MAP **maps, uint32_t num, uint32_t id_base, uint32_t id_last,
+                   IOVIRT_EMIT_FN emit, void *ctx)
+{
+  uint32_t i;
+  uint64_t map_last;
+
+  for (i = 0; i < num; i++) {
+      map_last = (uint64_t)maps[i]->input_base + maps[i]->id_count;
+      if (maps[i]->input_base <= id_last && map_last >= id_base)
+          break;
+  }
+
+  if (i == num) {
+      emit(ctx, NULL, id_base, id_last);
+      return;
+  }
+
+  /* Parts of the range outside this mapping go to the mappings after it */
+  if (maps[i]->input_base > id_base)
+      iovirt_split_range(&maps[i + 1], num - i - 1, id_base, maps[i]->input_base - 1,
+                         emit, ctx);
+
+  emit(ctx, maps[i], (maps[i]->input_base > id_base) ? maps[i]->input_base : id_base,
+       (map_last < id_last) ? (uint32_t)map_last : id_last);
+
+  if (map_last < id_last)
+      iovirt_split_range(&maps[i + 1], num - i - 1, (uint32_t)map_last + 1, id_last,
+                         emit, ctx);
+}
+
+/* State of the RID map build for one RC ID mapping piece */
+typedef struct {
+  uint32_t segment;
+  uint32_t rid_base;     /* RID of the first StreamID of the piece */
+  uint32_t sid_base;
+  ID_MAP **smmu_maps;    /* Scratch list of the SMMU ID mappings */
+  uint32_t status;
+} IOVIRT_RID_MAP_CTX;
+
+/**
+  @brief  Emit callback for StreamID pieces, translate them through the SMMU ID
+          mappings to DeviceID and ITS group.
+**/
+static void
+iovirt_emit_smmu_piece(void *ctx, ID_MAP *map, uint32_t sid_base, uint32_t sid_last)
+{
+  IOVIRT_RID_MAP_CTX *rc = ctx;
+  IOVIRT_RID_MAP ent;
+  IOVIRT_BLOCK *block;
+
+  ent.segment = rc->segment;
+  ent.rid_base = rc->rid_base + (sid_base - rc->sid_base);
+  ent.rid_last = rc->rid_base + (sid_last - rc->sid_base);
+  ent.sid_base = sid_base;
+  ent.did_base = 0;
+  ent.its_id = 0;
+  ent.status = IOVIRT_RID_MAP_NO_DEVID;
+
+  if (map) {
+      ent.did_base = (sid_base - map->input_base) + map->output_base;
+      ent.status = IOVIRT_RID_MAP_OK;
+      block = (IOVIRT_BLOCK *)((uint8_t *)g_iovirt_info_table + map->output_ref);
+      if (block->type == IOVIRT_NODE_ITS_GROUP)
+          ent.its_id = block->data_map[0].id[0];
+  }
+
+  if (iovirt_rid_map_add(&ent))
+      rc->status = AVS_STATUS_ERR;
+}
+
+/**
+  @brief  Emit callback for RID pieces, follow the RC ID mapping output reference
+          to an ITS group or an SMMU.
+**/
+static void
+iovirt_emit_rc_piece(void *ctx, ID_MAP *map, uint32_t rid_base, uint32_t rid_last)
+{
+  IOVIRT_RID_MAP_CTX *rc = ctx;
+  IOVIRT_RID_MAP ent;
+  IOVIRT_BLOCK *block;
+  uint32_t i;
+
+  /* RIDs outside every mapping are left out of the map */
+  if (map == NULL)
+      return;
+
+  ent.segment = rc->segment;
+  ent.rid_base = rid_base;
+  ent.rid_last = rid_last;
+  ent.sid_base = ~((uint32_t)0);
+  ent.did_base = (rid_base - map->input_base) + map->output_base;
+  ent.its_id = 0;
+  ent.status = IOVIRT_RID_MAP_OK;
+
+  block = (IOVIRT_BLOCK *)((uint8_t *)g_iovirt_info_table + map->output_ref);
+  if (block->type == IOVIRT_NODE_ITS_GROUP) {
+      ent.its_id = block->data_map[0].id[0];
+  }
+  else if (block->type == IOVIRT_NODE_SMMU || block->type == IOVIRT_NODE_SMMU_V3) {
+      for (i = 0; i < block->num_data_map; i++)
+          rc->smmu_maps[i] = &block->data_map[i].map;
+      rc->rid_base = rid_base;
+      rc->sid_base = ent.did_base;
+      iovirt_split_range(rc->smmu_maps, block->num_data_map, ent.did_base, ent.did_base + (rid_last - rid_base),
+                         iovirt_emit_smmu_piece, rc);
+      return;
+  }
+  else {
+      ent.did_base = 0;
+      ent.status = IOVIRT_RID_MAP_INVALID_REF;
+  }
+
+  if (iovirt_rid_map_add(&ent))
+      rc->status = AVS_STATUS_ERR;
+}
+
+/**
+  @brief  Build the sorted RID map from the RC and SMMU ID mappings of the IoVirt
+          info table, so RID lookups are a binary search.
+  @return 0 on success, AVS_STATUS_ERR on allocation failure
+**/
+static uint32_t
+iovirt_rid_map_build(void)
+{
+  uint32_t i, j, num_rc, num_maps, num_smmu_maps, segment, next_segment;
+  IOVIRT_BLOCK *block;
+  IOVIRT_BLOCK **rc_blocks;
+  ID_MAP **maps;
+  IOVIRT_RID_MAP_CTX ctx;
+
+  g_iovirt_rid_map_count = 0;
+
+  num_rc = 0;
+  num_maps = 0;
+  num_smmu_maps = 0;
+  block = &g_iovirt_info_table->blocks[0];
+  for (i = 0; i < g_iovirt_info_table->num_blocks; i++, block = IOVIRT_NEXT_BLOCK(block)) {
+      if (block->type == IOVIRT_NODE_PCI_ROOT_COMPLEX) {
+          num_rc++;
+          num_maps += block->num_data_map;
+      }
+      else if ((block->type == IOVIRT_NODE_SMMU || block->type == IOVIRT_NODE_SMMU_V3) &&
+               block->num_data_map > num_smmu_maps)
+          num_smmu_maps = block->num_data_map;
+  }
+  if (num_maps == 0)
+      return 0;
+
+  rc_blocks = val_memory_calloc(num_rc, sizeof(IOVIRT_BLOCK *));
+  maps = val_memory_calloc(num_maps + num_smmu_maps, sizeof(ID_MAP *));
+  if (rc_blocks == NULL || maps == NULL) {
+      if (rc_blocks)
+          val_memory_free(rc_blocks);
+      if (maps)
+          val_memory_free(maps);
+      return AVS_STATUS_ERR;
+  }
+  ctx.smmu_maps = &maps[num_maps];
+
+  num_rc = 0;
+  block = &g_iovirt_info_table->blocks[0];
+  for (i = 0; i < g_iovirt_info_table->num_blocks; i++, block = IOVIRT_NEXT_BLOCK(block)) {
+      if (block->type == IOVIRT_NODE_PCI_ROOT_COMPLEX)
+          rc_blocks[num_rc++] = block;
+  }
+
+  ctx.status = 0;
+  segment = 0;
+  while (ctx.status == 0) {
+      /* The RID map is sorted by segment, take the segments in ascending order */
+      next_segment = ~((uint32_t)0);
+      for (i = 0; i < num_rc; i++) {
+          if (rc_blocks[i]->data.rc.segment >= segment &&
+              rc_blocks[i]->data.rc.segment < next_segment)
+              next_segment = rc_blocks[i]->data.rc.segment;
+      }
+      if (next_segment == ~((uint32_t)0))
+          break;
+      segment = next_segment;
+
+      /* A later RC block of the segment overrides an earlier one, within a block
+         the first mapping wins */
+      num_maps = 0;
+      for (i = num_rc; i-- > 0; ) {
+          if (rc_blocks[i]->data.rc.segment != segment)
+              continue;
+          for (j = 0; j < rc_blocks[i]->num_data_map; j++)
+              maps[num_maps++] = &rc_blocks[i]->data_map[j].map;
+      }
+
+      ctx.segment = segment;
+      iovirt_split_range(maps, num_maps, 0, ~((uint32_t)0), iovirt_emit_rc_piece, &ctx);
+      segment++;
+  }
+
+  val_memory_free(maps);
+  val_memory_free(rc_blocks);
+  return ctx.status;
+}
+
+/**
+  @brief  Find the RID map range holding a requestor id
+  @param  rid      Requestor ID
+  @param  segment  PCIe segment number
+  @param  hint     range to try before the binary search, may be NULL
+  @return range, NULL if no RC ID mapping covers the requestor id
+**/
+static IOVIRT_RID_MAP *
+iovirt_rid_map_find(uint32_t rid, uint32_t segment, IOVIRT_RID_MAP *hint)
+{
+  uint32_t lo, hi, mid;
+  IOVIRT_RID_MAP *ent;
+
+  if (hint && hint->segment == segment && rid >= hint->rid_base && rid <= hint->rid_last)
+      return hint;
+
+  lo = 0;
+  hi = g_iovirt_rid_map_count;
+  while (lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      ent = &g_iovirt_rid_map[mid];
+      if (ent->segment < segment || (ent->segment == segment && ent->rid_last < rid))
+          lo = mid + 1;
+      else
+          hi = mid;
+  }
+
+  if (lo == g_iovirt_rid_map_count)
+      return NULL;
+
+  ent = &g_iovirt_rid_map[lo];
+  if (ent->segment != segment || rid < ent->rid_base)
+      return NULL;
+
+  return ent;
+}
+
+/**
+  @brief  Resolve a requestor id by walking the RC and SMMU ID mappings of the
+          IoVirt info table, used when the RID map could not be built
+  @param  rid      Requestor ID
+  @param  segment  PCIe segment number
+  @param  info     filled with the device id, stream id and ITS id on success
+  @return IOVIRT_RID_MAP_OK or the lookup failure
+**/
+static uint32_t
+iovirt_walk_device_info(uint32_t rid, uint32_t segment, IOVIRT_DEVICE_INFO *info)
 {
   uint32_t i, j, id = 0;
-  uint32_t sid, did, oref;
+  uint32_t sid, did = 0, oref = 0;
   uint32_t itsid = 0;
   uint32_t mapping_found;
   IOVIRT_BLOCK *block;
   NODE_DATA_MAP *map;
-  if (g_iovirt_info_table == NULL)
-  {
-      val_print(AVS_PRINT_ERR, "GET_DEVICE_ID: iovirt info table is not created \n", 0);
-      return AVS_STATUS_ERR;
-  }
-  if (!device_id) {
-      val_print(AVS_PRINT_ERR, "GET_DEVICE_ID: Invalid parameters\n", 0);
-      return AVS_STATUS_ERR;
-  }
 
   /* Search for root complex block with same segment number, and in whose id */
   /* mapping range 'rid' falls. Calculate the output id */
@@ -325,11 +638,9 @@ val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
           }
       }
   }
-  if (!mapping_found) {
-      val_print(AVS_PRINT_ERR,
-               "GET_DEVICE_ID: Requestor ID to Stream ID/Device ID mapping not found\n", 0);
-      return AVS_STATUS_ERR;
-  }
+  if (!mapping_found)
+      return IOVIRT_RID_MAP_NOT_FOUND;
+
   /* If output reference node is to ITS group, 'id' is device id */
   block = (IOVIRT_BLOCK*)((uint8_t*)g_iovirt_info_table + oref);
   if(block->type == IOVIRT_NODE_ITS_GROUP)
@@ -343,7 +654,6 @@ val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
   else if(block->type == IOVIRT_NODE_SMMU || block->type == IOVIRT_NODE_SMMU_V3)
   {
       sid = id;
-      id = 0;
       mapping_found = 0;
       for(i = 0, map = &block->data_map[0]; i < block->num_data_map; i++, map++)
       {
@@ -356,30 +666,142 @@ val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
               break;
           }
       }
+      if (!mapping_found)
+          return IOVIRT_RID_MAP_NO_DEVID;
+
       /* If output reference node is to ITS group */
       block = (IOVIRT_BLOCK*)((uint8_t*)g_iovirt_info_table + oref);
       if(block->type == IOVIRT_NODE_ITS_GROUP)
           itsid = block->data_map[0].id[0];
   }
   else
+      return IOVIRT_RID_MAP_INVALID_REF;
+
+  info->device_id = did;
+  info->stream_id = sid;
+  info->its_id = itsid;
+  return IOVIRT_RID_MAP_OK;
+}
+
+/**
+  @brief  Resolve a requestor id through the RID map, or the IoVirt info table
+          walk when the map could not be built
+  @param  rid      Requestor ID
+  @param  segment  PCIe segment number
+  @param  hint     in: range of the previous lookup, may hold NULL. out: range of
+                   this lookup
+  @param  info     filled with the device id, stream id and ITS id on success
+  @return IOVIRT_RID_MAP_OK or the lookup failure
+**/
+static uint32_t
+iovirt_resolve_rid(uint32_t rid, uint32_t segment, IOVIRT_RID_MAP **hint,
+                   IOVIRT_DEVICE_INFO *info)
+{
+  IOVIRT_RID_MAP *ent;
+
+  if (!g_iovirt_rid_map_valid)
+      return iovirt_walk_device_info(rid, segment, info);
+
+  /* Find the root complex ID mapping range of 'rid' in the segment, the range
+     holds the whole RID -> StreamID -> DeviceID translation */
+  ent = iovirt_rid_map_find(rid, segment, *hint);
+  *hint = ent;
+  if (ent == NULL)
+      return IOVIRT_RID_MAP_NOT_FOUND;
+  if (ent->status != IOVIRT_RID_MAP_OK)
+      return ent->status;
+
+  info->device_id = ent->did_base + (rid - ent->rid_base);
+  /* No stream id when the RC is not behind an SMMU */
+  info->stream_id = (ent->sid_base == ~((uint32_t)0)) ? ent->sid_base :
+                    ent->sid_base + (rid - ent->rid_base);
+  info->its_id = ent->its_id;
+  return IOVIRT_RID_MAP_OK;
+}
+
+/**
+  @brief  Calculate the device id and stream id orresponding to the requestor id
+  @param  rid          Requestor ID
+  @param  segment      pci_segment_number
+  @param  *device_id   Pointer to device id
+  @param  *stream_id   Pointer to stream id
+  @param  *its_id      Pointer to its id
+  @return status
+**/
+
+int
+val_iovirt_get_device_info(uint32_t rid, uint32_t segment, uint32_t *device_id,
+                           uint32_t *stream_id, uint32_t *its_id)
+{
+  IOVIRT_RID_MAP *ent = NULL;
+  IOVIRT_DEVICE_INFO info;
+
+  if (g_iovirt_info_table == NULL)
   {
-    val_print(AVS_PRINT_ERR, "GET_DEVICE_ID: Invalid mapping for RC in IORT\n", 0);
-    return AVS_STATUS_ERR;
+      val_print(AVS_PRINT_ERR, "GET_DEVICE_ID: iovirt info table is not created \n", 0);
+      return AVS_STATUS_ERR;
   }
-  if (!mapping_found)
-  {
-    val_print(AVS_PRINT_ERR, "GET_DEVICE_ID: Stream ID to Device ID mapping not found\n", 0);
-    return AVS_STATUS_ERR;
+  if (!device_id) {
+      val_print(AVS_PRINT_ERR, "GET_DEVICE_ID: Invalid parameters\n", 0);
+      return AVS_STATUS_ERR;
+  }
+
+  switch (iovirt_resolve_rid(rid, segment, &ent, &info)) {
+  case IOVIRT_RID_MAP_OK:
+      break;
+  case IOVIRT_RID_MAP_INVALID_REF:
+      val_print(AVS_PRINT_ERR, "GET_DEVICE_ID: Invalid mapping for RC in IORT\n", 0);
+      return AVS_STATUS_ERR;
+  case IOVIRT_RID_MAP_NO_DEVID:
+      val_print(AVS_PRINT_ERR, "GET_DEVICE_ID: Stream ID to Device ID mapping not found\n", 0);
+      return AVS_STATUS_ERR;
+  default:
+      val_print(AVS_PRINT_ERR,
+               "GET_DEVICE_ID: Requestor ID to Stream ID/Device ID mapping not found\n", 0);
+      return AVS_STATUS_ERR;
   }
 
   if (its_id)
-      *its_id = itsid;
+      *its_id = info.its_id;
   if (stream_id)
-      *stream_id = sid;
-  *device_id = did;
+      *stream_id = info.stream_id;
+  *device_id = info.device_id;
   return 0;
 }
 
+/**
+  @brief  Resolve the device id, stream id and ITS id of every function of the PCIe
+          BDF table in one pass. Neighbouring functions mostly share a mapping range,
+          so the range of the previous function is tried before searching.
+          1. Caller       -  Test Suite
+          2. Prerequisite -  val_iovirt_create_info_table, val_pcie_create_device_bdf_table
+  @param  info  array of g_pcie_bdf_table->num_entries entries, filled in table order.
+                status is 0 for a resolved function, AVS_STATUS_ERR otherwise
+  @return number of functions resolved
+**/
+uint32_t
+val_iovirt_get_device_info_all(IOVIRT_DEVICE_INFO *info)
+{
+  uint32_t i, bdf, count = 0;
+  IOVIRT_RID_MAP *ent = NULL;
+
+  if (g_iovirt_info_table == NULL || g_pcie_bdf_table == NULL || info == NULL)
+      return 0;
+
+  for (i = 0; i < g_pcie_bdf_table->num_entries; i++) {
+      bdf = g_pcie_bdf_table->device[i].bdf;
+      info[i].status = AVS_STATUS_ERR;
+      if (iovirt_resolve_rid(PCIE_CREATE_BDF_PACKED(bdf), PCIE_EXTRACT_BDF_SEG(bdf),
+                             &ent, &info[i]) != IOVIRT_RID_MAP_OK)
+          continue;
+
+      info[i].status = 0;
+      count++;
+  }
+
+  return count;
+}
+
 /**
   @brief   This API will call PAL layer to fill in the IO Virt information
            into the g_iovirt_info_table pointer.
@@ -402,6 +824,13 @@ val_iovirt_create_info_table(uint64_t *iovirt_info_table)
 
   pal_iovirt_create_info_table(g_iovirt_info_table);
 
+  g_iovirt_rid_map_valid = (iovirt_rid_map_build() == 0);
+  if (g_iovirt_rid_map_valid)
+      val_print(AVS_PRINT_INFO, " IOVIRT_INFO: RID map ranges         :    %d \n",
+                g_iovirt_rid_map_count);
+  else
+      val_print(AVS_PRINT_WARN, "\n   Failed to build the IoVirt RID map, walking the IORT \n", 0);
+
   g_num_smmus = val_iovirt_get_smmu_info(SMMU_NUM_CTRL, 0);
   val_print(AVS_PRINT_TEST,
             " SMMU_INFO: Number of SMMU CTRL       :    %x \n", g_num_smmus);
@@ -417,6 +846,13 @@ val_iovirt_check_unique_ctx_intid(uint32_t smmu_index)
 void
 val_iovirt_free_info_table()
 {
+  if (g_iovirt_rid_map)
+      val_memory_free(g_iovirt_rid_map);
+  g_iovirt_rid_map = NULL;
+  g_iovirt_rid_map_count = 0;
+  g_iovirt_rid_map_size = 0;
+  g_iovirt_rid_map_valid = 0;
+
   pal_mem_free((void *)g_iovirt_info_table);
 }
 
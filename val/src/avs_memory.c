@@ -18,10 +18,24 @@
 #include "include/sbsa_avs_val.h"
 #include "include/sbsa_avs_peripherals.h"
 #include "include/sbsa_avs_common.h"
+#include "include/sbsa_avs_pgt.h"
 
 
 MEMORY_INFO_TABLE  *g_memory_info_table;
 
+/**
+  @brief   Drop translations cached by the table walker, the PAL memory
+           calls below may remap memory or change its attributes.
+  @return  None
+**/
+static void
+memory_tables_changed(void)
+{
+#ifndef TARGET_LINUX
+  val_pgt_walk_cache_invalidate();
+#endif
+}
+
 #ifndef TARGET_LINUX
 /**
   @brief   This API will execute all Memory tests designated for a given compliance level
@@ -191,12 +205,14 @@ val_memory_get_info(addr_t addr, uint64_t *attr)
 addr_t
 val_memory_ioremap(void *addr, uint32_t size, uint64_t attr)
 {
+  memory_tables_changed();
   return (pal_memory_ioremap(addr, size, attr));
 }
 
 void
 val_memory_unmap(void *ptr)
 {
+  memory_tables_changed();
   pal_memory_unmap(ptr);
 }
 
@@ -215,6 +231,8 @@ val_memory_calloc(uint32_t num, uint32_t size)
 void *
 val_memory_alloc_cacheable(uint32_t bdf, uint32_t size, void **pa)
 {
+  /* The PAL may change the memory attributes in the translation tables */
+  memory_tables_changed();
   return pal_mem_alloc_cacheable(bdf, size, pa);
 }
 
@@ -239,6 +257,7 @@ val_memory_set(void *buf, uint32_t size, uint8_t value)
 void
 val_memory_free_cacheable(uint32_t bdf, uint32_t size, void *va, void *pa)
 {
+  memory_tables_changed();
   pal_mem_free_cacheable(bdf, size, va, pa);
 }
 
@@ -37,10 +37,7 @@ val_mmu_check_for_entry(uint64_t addr)
 {
   PE_TCR_BF tcr;
   uint64_t ttbr, ttable_entry;
-  uint64_t tt_base_phys, *tt_base_virt;
-  uint32_t ias, index, num_pgt_levels, this_level;
-  uint32_t page_size_log2, bits_per_level, page_size;
-  uint32_t bits_at_this_level, bits_remaining;
+  uint32_t ias, level, page_size_log2;
 
   /* Get translation attributes from TCR and translation table base from TTBR
      TTBR0 is used since we are accessing lower address region */
@@ -54,88 +51,23 @@ val_mmu_check_for_entry(uint64_t addr)
       return 1;
   }
 
-    /* obtain page size */
-    page_size = val_memory_page_size();
-    /* number of bits required to index byte location inside the page */
-    page_size_log2 = log2_func(page_size);
-    /* calculate input addr size */
-    ias = 64 - tcr.tsz;
-    /* calculate bits resolved per level for all granule sizes */
-    bits_per_level = page_size_log2 - 3;
-    /* calculate max num of translation levels possible */
-    num_pgt_levels = (ias - page_size_log2 + bits_per_level - 1)/bits_per_level;
-    /* start translation from lowest level */
-    this_level = PGT_LEVEL_MAX - num_pgt_levels;
-    /* bits to translate after first translation */
-    bits_remaining = (num_pgt_levels - 1) * bits_per_level + page_size_log2;
-    /* bits translated at current level */
-    bits_at_this_level = ias - bits_remaining;
-    /* address to first translation table comes from TTBR0 register */
-    tt_base_phys = ttbr & AARCH64_TTBR_ADDR_MASK;
-
-    while (this_level < PGT_LEVEL_MAX) {
-        /* translation starts from most siginificant bits of VA */
-        index = (addr >> bits_remaining) & ((0x1u << bits_at_this_level) - 1);
-        tt_base_virt = (uint64_t *)val_memory_phys_to_virt(tt_base_phys);
-        /* index the translation table and read the entry */
-        ttable_entry = tt_base_virt[index];
-
-        val_print(AVS_PRINT_INFO, "\n   Translation table level         = %d", this_level);
-        val_print(AVS_PRINT_INFO, "\n   Table base address              = 0x%llx",
-                  (uint64_t)tt_base_virt);
-        val_print(AVS_PRINT_INFO, "\n   Table entry index               = %d", index);
-        val_print(AVS_PRINT_INFO, "\n   Table entry                     = 0x%llx",
-                  ttable_entry);
-        val_print(AVS_PRINT_INFO, "\n   VA bits remaining to be resolve = %d", bits_remaining);
-
-        /* check whether the table entry is invalid */
-        if (IS_PGT_ENTRY_INVALID(ttable_entry)) {
-            val_print(AVS_PRINT_DEBUG, "\n   VA not mapped in translation table", 0);
-            return 1;
-        }
-
-        /* As per Arm ARM, entry of type "table descriptor" is only
-           valid at translation level 0 */
-        if (this_level == 0 && !IS_PGT_ENTRY_TABLE(ttable_entry)) {
-            val_print(AVS_PRINT_DEBUG,
-                      "\n   VA not mapped correctly in translation table", 0);
-            return 1;
-        }
-
-        if (this_level == 3) {
-            /* at level 3 table entry should be of type "page descriptor" with
-               ttable_entry[1:0] bits = b11 */
-            if (!IS_PGT_ENTRY_PAGE(ttable_entry)) {
-                val_print(AVS_PRINT_DEBUG,
-                          "\n   VA not mapped correctly in translation table", 0);
-                return 1;
-            }
-            else {
-                val_print(AVS_PRINT_DEBUG, "\n   VA translation successful", 0);
-                return 0;
-            }
-        }
-
-        /* check whether table walk hit a block descriptor entry
-           Note : level 0 table entry can't describe a page or a block
-                  level 3 can only have entry of type page descriptor
-                  (Refer Arm ARM for more info) */
-        if (IS_PGT_ENTRY_BLOCK(ttable_entry) && this_level != 0) {
-            val_print(AVS_PRINT_DEBUG, "\n   VA translation successful", 0);
-            return 0;
-        }
-
-        /* point to next translation table if table walk still not hit
-           a page or a block descriptor entry */
-        tt_base_phys = ttable_entry & (((0x1ull << (ias - page_size_log2)) - 1) << page_size_log2);
-
-        /* update level and remaining VA bits to resolve */
-        ++this_level;
-        bits_remaining -= bits_at_this_level;
-        bits_at_this_level = bits_per_level;
-    }
-    /* execution should don't reach here */
-    return 1;
+  /* obtain page size */
+  page_size_log2 = log2_func(val_memory_page_size());
+  /* calculate input addr size */
+  ias = 64 - tcr.tsz;
+
+  /* walk the tables from TTBR0, the walk fails on any entry that is invalid
+     or of the wrong type for its level (Refer Arm ARM for more info) */
+  if (val_pgt_walk(ttbr & AARCH64_TTBR_ADDR_MASK, ias, page_size_log2, addr,
+                   &ttable_entry, &level)) {
+      val_print(AVS_PRINT_DEBUG, "\n   VA not mapped in translation table", 0);
+      return 1;
+  }
+
+  val_print(AVS_PRINT_INFO, "\n   Translation table level         = %d", level);
+  val_print(AVS_PRINT_INFO, "\n   Table entry                     = 0x%llx", ttable_entry);
+  val_print(AVS_PRINT_DEBUG, "\n   VA translation successful", 0);
+  return 0;
 }
 
 /**
@@ -151,12 +83,14 @@ uint32_t
 val_mmu_add_entry(uint64_t base_addr, uint64_t size)
 {
   pgt_descriptor_t pgt_desc;
-  memory_region_descriptor_t mem_desc;
+  memory_region_descriptor_t mem_desc_array[2], *mem_desc;
   uint64_t ttbr;
   const uint32_t oas_bit_arr[7] = {32, 36, 40, 42, 44, 48, 52}; /* Physical address sizes */
 
   /* init descriptors */
-  val_memory_set(&mem_desc, sizeof(mem_desc), 0);
+  /* val_pgt_create walks the descriptors up to a zero length terminator */
+  val_memory_set(mem_desc_array, sizeof(mem_desc_array), 0);
+  mem_desc = &mem_desc_array[0];
   val_memory_set(&pgt_desc, sizeof(pgt_desc), 0);
 
   /* Get translation attributes from TCR and translation table base from TTBR */
@@ -181,13 +115,13 @@ val_mmu_add_entry(uint64_t base_addr, uint64_t size)
   val_print(AVS_PRINT_DEBUG, "\n   Output addr size in bits (oas) = %d\n", pgt_desc.oas);
 
   /* populate mem descriptor structure with addr region to be mapped and attributes */
-  mem_desc.virtual_address = base_addr;
-  mem_desc.physical_address = base_addr;
-  mem_desc.length = size;
-  mem_desc.attributes = ATTR_DEVICE_nGnRnE | (1ull << MEM_ATTR_AF_SHIFT);
+  mem_desc->virtual_address = base_addr;
+  mem_desc->physical_address = base_addr;
+  mem_desc->length = size;
+  mem_desc->attributes = ATTR_DEVICE_nGnRnE | (1ull << MEM_ATTR_AF_SHIFT);
 
   /* update translation table entry(s) for addr region defined by memory descriptor structure  */
-  if (val_pgt_create(&mem_desc, &pgt_desc)) {
+  if (val_pgt_create(mem_desc, &pgt_desc)) {
       val_print(AVS_PRINT_ERR, "   Failed to create MMU translation entry(s)\n", 0);
       return 1;
   }
@@ -18,8 +18,21 @@
 #include "include/sbsa_avs_val.h"
 #include "include/sbsa_avs_nist.h"
 #include "include/sbsa_avs_common.h"
+#include "include/sbsa_avs_pe.h"
+#include "include/sbsa_std_smc.h"
 #include <math.h>
 
+/* Consecutive failed reads tolerated before a bulk request gives up */
+#define NIST_RNG_MAX_RETRIES  1000
+
+/* RNDR words read between RNDRRS reseeds */
+#define NIST_RNG_RESEED_WORDS 1024
+
+/* Words staged on the stack when the caller's buffer is not 8-byte aligned */
+#define NIST_RNG_CHUNK_WORDS  32
+
+extern int32_t gPsciConduit;
+
 /**
   @brief   This API executes all the PCIe tests sequentially
   @param   level  - level of compliance being tested for.
@@ -70,6 +83,727 @@ val_nist_generate_rng(uint32_t *rng_buffer)
   return status;
 }
 
+static NIST_RNG_STATS_t g_nist_rng_stats;
+static uint32_t         g_nist_rng_source = NIST_RNG_SOURCE_UNKNOWN;
+
+/**
+  @brief   This API picks the random number source for bulk requests. FEAT_RNG
+           is preferred, then the SMCCC TRNG firmware interface. Otherwise
+           pal_nist_generate_rng is used, which on UEFI is the C library
+           rand() and so only exercises the STS, not a hardware entropy source.
+  @param   None
+
+  @return  NIST_RNG_SOURCE_e value.
+**/
+static
+uint32_t
+val_nist_rng_probe(void)
+{
+  ARM_SMC_ARGS smc_args;
+
+  /* ID_AA64ISAR0_EL1.RNDR */
+  if (VAL_EXTRACT_BITS(val_pe_reg_read(ID_AA64ISAR0_EL1), 60, 63) != 0)
+      return NIST_RNG_SOURCE_RNDR;
+
+  smc_args.Arg0 = ARM_SMC_ID_TRNG_VERSION;
+  smc_args.Arg1 = 0;
+  smc_args.Arg2 = 0;
+  smc_args.Arg3 = 0;
+  pal_pe_call_smc(&smc_args, gPsciConduit);
+
+  /* Major revision in bits [30:16], 1.0 is the first TRNG release */
+  if ((int32_t)smc_args.Arg0 > 0 && (smc_args.Arg0 >> 16) >= 1) {
+      smc_args.Arg0 = ARM_SMC_ID_TRNG_FEATURES;
+      smc_args.Arg1 = ARM_SMC_ID_TRNG_RND_AARCH64;
+      pal_pe_call_smc(&smc_args, gPsciConduit);
+      if ((int32_t)smc_args.Arg0 == ARM_SMC_TRNG_RET_SUCCESS)
+          return NIST_RNG_SOURCE_TRNG;
+  }
+
+  return NIST_RNG_SOURCE_PAL;
+}
+
+/**
+  @brief   This API fills 64-bit words from RNDR. Every NIST_RNG_RESEED_WORDS
+           words, one word is read from RNDRRS instead, which reseeds the
+           generator RNDR reads from. Failed reads are retried.
+  @param   buffer  - Buffer to fill.
+  @param   count   - Number of words.
+
+  @return  success/failure.
+**/
+static
+uint32_t
+val_nist_rng_fill_rndr(uint64_t *buffer, uint64_t count)
+{
+  uint64_t filled, want, left = 0;
+  uint32_t retries = 0;
+
+  while (count) {
+      if (left == 0) {
+          want = 1;
+          filled = AA64FillRndrrs(buffer, want);
+          if (filled)
+              left = NIST_RNG_RESEED_WORDS;
+      } else {
+          want = (count < left) ? count : left;
+          filled = AA64FillRndr(buffer, want);
+          left -= filled;
+      }
+
+      buffer += filled;
+      count -= filled;
+      if (filled == want)
+          continue;
+
+      g_nist_rng_stats.reseed_failures++;
+      if (filled)
+          retries = 0;
+      if (++retries > NIST_RNG_MAX_RETRIES)
+          return AVS_STATUS_FAIL;
+  }
+
+  return AVS_STATUS_PASS;
+}
+
+/**
+  @brief   This API fills 64-bit words with TRNG_RND64, 192 bits per call.
+           Calls that report no entropy are retried.
+  @param   buffer  - Buffer to fill.
+  @param   count   - Number of words.
+
+  @return  success/failure.
+**/
+static
+uint32_t
+val_nist_rng_fill_trng(uint64_t *buffer, uint64_t count)
+{
+  ARM_SMC_ARGS smc_args;
+  uint64_t     rnd[3];
+  uint32_t     i, retries = 0;
+
+  while (count) {
+      smc_args.Arg0 = ARM_SMC_ID_TRNG_RND_AARCH64;
+      smc_args.Arg1 = ARM_SMC_TRNG_RND64_MAX_BITS;
+      smc_args.Arg2 = 0;
+      smc_args.Arg3 = 0;
+      pal_pe_call_smc(&smc_args, gPsciConduit);
+
+      if ((int32_t)smc_args.Arg0 == ARM_SMC_TRNG_RET_NO_ENTROPY) {
+          g_nist_rng_stats.reseed_failures++;
+          if (++retries > NIST_RNG_MAX_RETRIES)
+              return AVS_STATUS_FAIL;
+          continue;
+      }
+
+      if ((int32_t)smc_args.Arg0 != ARM_SMC_TRNG_RET_SUCCESS)
+          return AVS_STATUS_FAIL;
+
+      /* x3 holds bits [63:0], x2 bits [127:64] and x1 bits [191:128] */
+      rnd[0] = smc_args.Arg3;
+      rnd[1] = smc_args.Arg2;
+      rnd[2] = smc_args.Arg1;
+      for (i = 0; i < 3 && count; i++, count--)
+          *buffer++ = rnd[i];
+
+      retries = 0;
+  }
+
+  return AVS_STATUS_PASS;
+}
+
+/**
+  @brief   This API fills 64-bit words from pal_nist_generate_rng.
+  @param   buffer  - Buffer to fill.
+  @param   count   - Number of words.
+
+  @return  success/failure.
+**/
+static
+uint32_t
+val_nist_rng_fill_pal(uint64_t *buffer, uint64_t count)
+{
+  uint32_t hi, lo;
+
+  while (count--) {
+      if (pal_nist_generate_rng(&hi) != AVS_STATUS_PASS ||
+          pal_nist_generate_rng(&lo) != AVS_STATUS_PASS)
+          return AVS_STATUS_FAIL;
+
+      *buffer++ = ((uint64_t)hi << 32) | lo;
+  }
+
+  return AVS_STATUS_PASS;
+}
+
+static
+uint32_t
+val_nist_rng_fill(uint64_t *buffer, uint64_t count)
+{
+  switch (g_nist_rng_source) {
+  case NIST_RNG_SOURCE_RNDR:
+      return val_nist_rng_fill_rndr(buffer, count);
+  case NIST_RNG_SOURCE_TRNG:
+      return val_nist_rng_fill_trng(buffer, count);
+  default:
+      return val_nist_rng_fill_pal(buffer, count);
+  }
+}
+
+/**
+  @brief   This API fills a buffer with random data in one call, from the
+           source picked by val_nist_rng_probe. The time taken, throughput
+           and number of retried reads are kept for val_nist_get_rng_stats.
+  @param   buffer  - Buffer to fill.
+  @param   nbytes  - Size of the buffer in bytes.
+
+  @return  success/failure.
+**/
+uint32_t
+val_nist_generate_rng_bulk(void *buffer, uint64_t nbytes)
+{
+  uint8_t  *dest = buffer;
+  uint64_t  chunk[NIST_RNG_CHUNK_WORDS];
+  uint64_t  start, count, words;
+  uint32_t  status = AVS_STATUS_PASS;
+
+  if (buffer == NULL)
+      return AVS_STATUS_FAIL;
+
+  if (g_nist_rng_source == NIST_RNG_SOURCE_UNKNOWN)
+      g_nist_rng_source = val_nist_rng_probe();
+
+  g_nist_rng_stats.source = g_nist_rng_source;
+  g_nist_rng_stats.reseed_failures = 0;
+  start = val_get_timestamp();
+
+  count = nbytes / sizeof(uint64_t);
+  if (((addr_t)dest & (sizeof(uint64_t) - 1)) == 0) {
+      status = val_nist_rng_fill((uint64_t *)dest, count);
+      dest += count * sizeof(uint64_t);
+  } else {
+      while (count && status == AVS_STATUS_PASS) {
+          words = (count < NIST_RNG_CHUNK_WORDS) ? count : NIST_RNG_CHUNK_WORDS;
+          status = val_nist_rng_fill(chunk, words);
+          val_memcpy(dest, chunk, (uint32_t)(words * sizeof(uint64_t)));
+          dest += words * sizeof(uint64_t);
+          count -= words;
+      }
+  }
+
+  if (status == AVS_STATUS_PASS && (nbytes % sizeof(uint64_t))) {
+      status = val_nist_rng_fill(chunk, 1);
+      val_memcpy(dest, chunk, (uint32_t)(nbytes % sizeof(uint64_t)));
+  }
+
+  g_nist_rng_stats.bytes = nbytes;
+  g_nist_rng_stats.time_us = val_ticks_to_us(val_get_timestamp() - start);
+  g_nist_rng_stats.throughput = g_nist_rng_stats.time_us ?
+                                (nbytes * 1000000) / g_nist_rng_stats.time_us : 0;
+
+  if (status != AVS_STATUS_PASS)
+      val_print(AVS_PRINT_ERR, "\n       RNG source %d stopped returning data",
+                g_nist_rng_source);
+
+  return status;
+}
+
+/**
+  @brief   This API returns the statistics of the last bulk request.
+  @param   stats  - Pointer to store the statistics.
+
+  @return  None
+**/
+void
+val_nist_get_rng_stats(NIST_RNG_STATS_t *stats)
+{
+  *stats = g_nist_rng_stats;
+}
+
+static const uint8_t *g_nist_stream;
+static uint64_t       g_nist_stream_bits;
+static NIST_STREAM_READER g_nist_stream_reader;
+
+/*
+ * Bit-packed kernels for the counting NIST tests. Bit i of a packed stream
+ * is bit (7 - i % 8) of byte i / 8, the order readPackedBitStream feeds the
+ * STS in. The kernels never read bytes past the last bit they are asked for.
+ */
+#define NIST_BIT(data, i)  ((uint32_t)((data)[(i) >> 3] >> (7 - ((i) & 7))) & 1)
+
+/* Per byte cumulative sum step, and the highest and lowest partial sums */
+static int8_t g_nist_cusum_delta[256];
+static int8_t g_nist_cusum_max[256];
+static int8_t g_nist_cusum_min[256];
+
+static
+void
+val_nist_cusum_init(void)
+{
+  uint32_t b, j;
+  int32_t  sum, max, min;
+
+  for (b = 0; b < 256; b++) {
+      sum = 0;
+      max = -8;
+      min = 8;
+      for (j = 0; j < 8; j++) {
+          sum += ((b >> (7 - j)) & 1) ? 1 : -1;
+          max = (sum > max) ? sum : max;
+          min = (sum < min) ? sum : min;
+      }
+      g_nist_cusum_delta[b] = (int8_t)sum;
+      g_nist_cusum_max[b] = (int8_t)max;
+      g_nist_cusum_min[b] = (int8_t)min;
+  }
+}
+
+static
+uint32_t
+val_nist_popcount(uint64_t x)
+{
+#ifdef __ARM_NEON
+  /* CNT and ADDV on the SIMD unit */
+  return (uint32_t)__builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (uint32_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* 64 bits starting at bit pos, with bit pos in bit 63 */
+static
+uint64_t
+val_nist_load64(const uint8_t *data, uint64_t pos)
+{
+  const uint8_t *p = data + (pos >> 3);
+  uint32_t       shift = (uint32_t)(pos & 7);
+  uint64_t       w = 0;
+  uint32_t       i;
+
+  for (i = 0; i < 8; i++)
+      w = (w << 8) | p[i];
+
+  if (shift)
+      w = (w << shift) | (uint64_t)(p[8] >> (8 - shift));
+
+  return w;
+}
+
+/* count < 64 bits starting at bit pos, right aligned */
+static
+uint64_t
+val_nist_load_bits(const uint8_t *data, uint64_t pos, uint32_t count)
+{
+  uint64_t w = 0;
+
+  while (count--) {
+      w = (w << 1) | NIST_BIT(data, pos);
+      pos++;
+  }
+
+  return w;
+}
+
+/**
+  @brief   This API counts the ones in a range of a packed bitstream.
+  @param   data   - Packed bitstream.
+  @param   start  - First bit of the range.
+  @param   n      - Number of bits in the range.
+
+  @return  Number of ones.
+**/
+uint64_t
+val_nist_count_ones(const uint8_t *data, uint64_t start, uint64_t n)
+{
+  uint64_t pos = start, end = start + n, ones = 0;
+
+  for (; pos + 64 <= end; pos += 64)
+      ones += val_nist_popcount(val_nist_load64(data, pos));
+
+  return ones + val_nist_popcount(val_nist_load_bits(data, pos, (uint32_t)(end - pos)));
+}
+
+/**
+  @brief   This API counts the runs, maximal blocks of identical bits, in a
+           range of a packed bitstream.
+  @param   data   - Packed bitstream.
+  @param   start  - First bit of the range.
+  @param   n      - Number of bits in the range, at least 1.
+
+  @return  Number of runs.
+**/
+uint64_t
+val_nist_count_runs(const uint8_t *data, uint64_t start, uint64_t n)
+{
+  uint64_t pos = start + 1, end = start + n, runs = 1;
+
+  /* Each bit that differs from the one before it starts a new run */
+  for (; pos + 64 <= end; pos += 64)
+      runs += val_nist_popcount(val_nist_load64(data, pos) ^ val_nist_load64(data, pos - 1));
+
+  for (; pos < end; pos++)
+      runs += NIST_BIT(data, pos) ^ NIST_BIT(data, pos - 1);
+
+  return runs;
+}
+
+/**
+  @brief   This API returns the longest run of ones in a range of a packed
+           bitstream.
+  @param   data   - Packed bitstream.
+  @param   start  - First bit of the range.
+  @param   n      - Number of bits in the range.
+
+  @return  Length of the longest run of ones.
+**/
+uint32_t
+val_nist_longest_run(const uint8_t *data, uint64_t start, uint64_t n)
+{
+  uint64_t pos = start, end = start + n, v, x, mask;
+  uint32_t count, cur = 0, best = 0, len;
+
+  while (pos < end) {
+      count = (end - pos >= 64) ? 64 : (uint32_t)(end - pos);
+      v = (count == 64) ? val_nist_load64(data, pos) : val_nist_load_bits(data, pos, count);
+      mask = (count == 64) ? ~0ULL : ((1ULL << count) - 1);
+      pos += count;
+
+      if (v == mask) {
+          cur += count;
+          continue;
+      }
+
+      /* The run carried in from the previous word ends at the first zero */
+      cur += (uint32_t)__builtin_clzll(~(v << (64 - count)));
+      best = (cur > best) ? cur : best;
+
+      /* Each step shortens every run of ones by one bit */
+      for (x = v, len = 0; x != 0; len++)
+          x &= x << 1;
+      best = (len > best) ? len : best;
+
+      cur = (uint32_t)__builtin_ctzll(~v);
+  }
+
+  return (cur > best) ? cur : best;
+}
+
+/**
+  @brief   This API walks the cumulative sums of the +1/-1 form of a range of
+           a packed bitstream.
+  @param   data   - Packed bitstream.
+  @param   start  - First bit of the range.
+  @param   n      - Number of bits in the range.
+  @param   sum    - Pointer to store the final sum.
+  @param   max    - Pointer to store the highest partial sum, at least 0.
+  @param   min    - Pointer to store the lowest partial sum, at most 0.
+
+  @return  None
+**/
+void
+val_nist_cusum(const uint8_t *data, uint64_t start, uint64_t n,
+               int64_t *sum, int64_t *max, int64_t *min)
+{
+  uint64_t pos = start, end = start + n;
+  int64_t  s = 0, hi = 0, lo = 0;
+  uint8_t  b;
+
+  for (; pos < end && (pos & 7); pos++) {
+      s += NIST_BIT(data, pos) ? 1 : -1;
+      hi = (s > hi) ? s : hi;
+      lo = (s < lo) ? s : lo;
+  }
+
+  for (; pos + 8 <= end; pos += 8) {
+      b = data[pos >> 3];
+      hi = (s + g_nist_cusum_max[b] > hi) ? s + g_nist_cusum_max[b] : hi;
+      lo = (s + g_nist_cusum_min[b] < lo) ? s + g_nist_cusum_min[b] : lo;
+      s += g_nist_cusum_delta[b];
+  }
+
+  for (; pos < end; pos++) {
+      s += NIST_BIT(data, pos) ? 1 : -1;
+      hi = (s > hi) ? s : hi;
+      lo = (s < lo) ? s : lo;
+  }
+
+  *sum = s;
+  *max = hi;
+  *min = lo;
+}
+
+/**
+  @brief   This API counts the overlapping m-bit patterns of a range of a
+           packed bitstream, extended by its own first m - 1 bits as the
+           serial test requires.
+  @param   data    - Packed bitstream.
+  @param   start   - First bit of the range.
+  @param   n       - Number of bits in the range, at least m.
+  @param   m       - Pattern length, 1 to 31.
+  @param   counts  - Array of 2^m counters, indexed by pattern.
+
+  @return  None
+**/
+void
+val_nist_count_patterns(const uint8_t *data, uint64_t start, uint64_t n,
+                        uint32_t m, uint32_t *counts)
+{
+  uint64_t pos, end = start + n;
+  uint32_t mask = (1U << m) - 1, w, j;
+  uint8_t  b;
+
+  for (w = 0; w <= mask; w++)
+      counts[w] = 0;
+
+  w = (uint32_t)val_nist_load_bits(data, start, m - 1);
+  pos = start + m - 1;
+
+  for (; pos < end && (pos & 7); pos++) {
+      w = ((w << 1) | NIST_BIT(data, pos)) & mask;
+      counts[w]++;
+  }
+
+  for (; pos + 8 <= end; pos += 8) {
+      b = data[pos >> 3];
+      for (j = 0; j < 8; j++) {
+          w = ((w << 1) | ((uint32_t)(b >> (7 - j)) & 1)) & mask;
+          counts[w]++;
+      }
+  }
+
+  for (; pos < end; pos++) {
+      w = ((w << 1) | NIST_BIT(data, pos)) & mask;
+      counts[w]++;
+  }
+
+  /* The last m - 1 patterns wrap around to the start of the range */
+  for (pos = start; pos < start + m - 1; pos++) {
+      w = ((w << 1) | NIST_BIT(data, pos)) & mask;
+      counts[w]++;
+  }
+}
+
+/**
+  @brief   This API hands a packed bitstream to the NIST STS. The STS reads
+           the sequences from this buffer instead of an input file until it
+           is cleared with a NULL buffer.
+  @param   data      - Buffer holding the bits, MSB of each byte first.
+  @param   num_bits  - Number of valid bits in the buffer.
+
+  @return  None
+**/
+void
+val_nist_set_stream(const uint8_t *data, uint64_t num_bits)
+{
+  g_nist_stream = data;
+  g_nist_stream_reader = NULL;
+  g_nist_stream_bits = (data == NULL) ? 0 : num_bits;
+
+  if (data != NULL)
+      val_nist_cusum_init();
+}
+
+/**
+  @brief   This API hands the NIST STS a bitstream that is produced on demand
+           by a reader. The STS then evaluates the stream chunk by chunk, so
+           its length is not limited by the memory available. It is cleared
+           with a NULL reader, or by val_nist_set_stream.
+  @param   reader    - Function filling a buffer with the next bytes of the
+                       stream, MSB of each byte first.
+  @param   num_bits  - Number of bits in the stream.
+
+  @return  None
+**/
+void
+val_nist_set_stream_reader(NIST_STREAM_READER reader, uint64_t num_bits)
+{
+  g_nist_stream = NULL;
+  g_nist_stream_reader = reader;
+  g_nist_stream_bits = (reader == NULL) ? 0 : num_bits;
+
+  if (reader != NULL)
+      val_nist_cusum_init();
+}
+
+/**
+  @brief   This API reads the next bytes of a stream set with
+           val_nist_set_stream_reader.
+  @param   buffer  - Buffer to fill.
+  @param   nbytes  - Number of bytes to read.
+
+  @return  AVS_STATUS_PASS, or AVS_STATUS_ERR if no reader is set or it failed.
+**/
+uint32_t
+val_nist_read_stream(uint8_t *buffer, uint64_t nbytes)
+{
+  if (g_nist_stream_reader == NULL)
+      return AVS_STATUS_ERR;
+
+  return (g_nist_stream_reader(buffer, nbytes) == AVS_STATUS_PASS) ? AVS_STATUS_PASS
+                                                                   : AVS_STATUS_ERR;
+}
+
+/**
+  @brief   This API returns the packed bitstream set for the NIST STS.
+  @param   data  - Pointer to store the buffer address, may be NULL. It is
+                   set to NULL for a stream produced by a reader.
+
+  @return  Number of bits in the stream, 0 if no stream is set.
+**/
+uint64_t
+val_nist_get_stream(const uint8_t **data)
+{
+  if (data != NULL)
+      *data = g_nist_stream;
+
+  return g_nist_stream_bits;
+}
+
+/**
+  @brief   This API starts the running counts of a streamed NIST sequence.
+  @param   state        - Running counts to reset.
+  @param   block_len    - Block frequency test block length, 0 to skip it.
+  @param   pattern_len  - Serial test pattern length, 0 to skip it, else 1
+                          to 31.
+  @param   counts       - Array of 2^pattern_len counters, may be NULL when
+                          pattern_len is 0.
+
+  @return  None
+**/
+void
+val_nist_stream_init(NIST_STREAM_STATE_t *state, uint32_t block_len,
+                     uint32_t pattern_len, uint32_t *counts)
+{
+  uint32_t i;
+
+  state->bits = 0;
+  state->ones = 0;
+  state->runs = 0;
+  state->last_bit = 0;
+  state->sum = 0;
+  state->sum_max = 0;
+  state->sum_min = 0;
+  state->block_len = block_len;
+  state->block_fill = 0;
+  state->block_ones = 0;
+  state->blocks = 0;
+  state->block_dev = 0;
+  state->pattern_len = (counts == NULL) ? 0 : pattern_len;
+  state->window = 0;
+  state->head = 0;
+  state->counts = counts;
+
+  for (i = 0; state->pattern_len && i < (1U << state->pattern_len); i++)
+      counts[i] = 0;
+}
+
+/* Feed one bit to the overlapping pattern counts */
+static
+void
+val_nist_stream_pattern(NIST_STREAM_STATE_t *state, uint64_t index, uint32_t bit)
+{
+  state->window = ((state->window << 1) | bit) & ((1U << state->pattern_len) - 1);
+
+  /* The first m - 1 bits are kept to close the sequence in a ring */
+  if (index < state->pattern_len - 1)
+      state->head = (state->head << 1) | bit;
+  else
+      state->counts[state->window]++;
+}
+
+/**
+  @brief   This API adds a range of a packed bitstream to the running counts
+           of a streamed NIST sequence: the ones, the runs, the cumulative
+           sums, the block frequency deviations and the serial patterns.
+  @param   state  - Running counts.
+  @param   data   - Packed bitstream.
+  @param   start  - First bit of the range.
+  @param   n      - Number of bits in the range.
+
+  @return  None
+**/
+void
+val_nist_stream_update(NIST_STREAM_STATE_t *state, const uint8_t *data,
+                       uint64_t start, uint64_t n)
+{
+  uint64_t pos, end = start + n, k;
+  int64_t  sum, max, min, dev;
+  uint32_t j;
+  uint8_t  b;
+
+  if (n == 0)
+      return;
+
+  state->ones += val_nist_count_ones(data, start, n);
+
+  /* A run carries on across the boundary when its bits match */
+  state->runs += val_nist_count_runs(data, start, n);
+  if (state->bits != 0 && NIST_BIT(data, start) == state->last_bit)
+      state->runs--;
+  state->last_bit = NIST_BIT(data, end - 1);
+
+  val_nist_cusum(data, start, n, &sum, &max, &min);
+  state->sum_max = (state->sum + max > state->sum_max) ? state->sum + max : state->sum_max;
+  state->sum_min = (state->sum + min < state->sum_min) ? state->sum + min : state->sum_min;
+  state->sum += sum;
+
+  /* Blocks may span ranges, the bits after the last whole block are dropped */
+  for (pos = start; state->block_len && pos < end; pos += k) {
+      k = state->block_len - state->block_fill;
+      k = (k < end - pos) ? k : end - pos;
+      state->block_ones += val_nist_count_ones(data, pos, k);
+      state->block_fill += k;
+      if (state->block_fill == state->block_len) {
+          dev = 2 * (int64_t)state->block_ones - (int64_t)state->block_len;
+          state->block_dev += (uint64_t)(dev * dev);
+          state->blocks++;
+          state->block_fill = 0;
+          state->block_ones = 0;
+      }
+  }
+
+  if (state->pattern_len) {
+      pos = start;
+      for (; pos < end && (pos & 7); pos++)
+          val_nist_stream_pattern(state, state->bits + pos - start, NIST_BIT(data, pos));
+
+      for (; pos + 8 <= end; pos += 8) {
+          b = data[pos >> 3];
+          for (j = 0; j < 8; j++)
+              val_nist_stream_pattern(state, state->bits + pos - start + j,
+                                      (uint32_t)(b >> (7 - j)) & 1);
+      }
+
+      for (; pos < end; pos++)
+          val_nist_stream_pattern(state, state->bits + pos - start, NIST_BIT(data, pos));
+  }
+
+  state->bits += n;
+}
+
+/**
+  @brief   This API completes the serial pattern counts of a streamed NIST
+           sequence, with the patterns that wrap around to its first bits.
+           The sequence must hold at least pattern_len bits.
+  @param   state  - Running counts.
+
+  @return  None
+**/
+void
+val_nist_stream_finish(NIST_STREAM_STATE_t *state)
+{
+  uint32_t j;
+
+  if (state->pattern_len == 0)
+      return;
+
+  for (j = state->pattern_len - 1; j > 0; j--)
+      val_nist_stream_pattern(state, state->pattern_len, (state->head >> (j - 1)) & 1);
+}
+
 double
 erf(double x)
 {
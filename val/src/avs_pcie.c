@@ -25,9 +25,56 @@ PCIE_INFO_TABLE *g_pcie_info_table;
 pcie_device_bdf_table *g_pcie_bdf_table;
 uint32_t pcie_bdf_table_list_flag;
 
+/* Config space base of every (segment slot, bus), built by val_pcie_create_ecam_lookup.
+   g_pcie_ecam_lookup_slot maps segments 0 to g_pcie_ecam_lookup_max_seg to their slot,
+   segments without an ECAM region map to a last slot of zeros. */
+static addr_t   *g_pcie_ecam_lookup;
+static uint16_t *g_pcie_ecam_lookup_slot;
+static uint32_t  g_pcie_ecam_lookup_max_seg;
+static uint32_t  g_pcie_ecam_lookup_size;
+
+/* BDF -> g_pcie_bdf_table index, built by val_pcie_cap_index_build */
+static uint16_t g_pcie_bdf_hash[PCIE_BDF_HASH_SIZE];
+static uint32_t g_pcie_bdf_hash_valid;
+
 uint64_t
 pal_get_mcfg_ptr(void);
 
+/**
+  @brief   Returns the config space base of bus 0, device 0, function 0 of the
+           given segment and bus, i.e. the ECAM base plus the offset of the bus.
+           Uses the (segment, bus) lookup table when it has been built, else
+           walks the ECAM regions.
+  @param   segment - PCIe segment number
+  @param   bus     - PCIe bus number
+
+  @return  config space base of the bus, 0 if no ECAM region maps the bus
+**/
+static addr_t
+val_pcie_get_bus_cfg_base(uint32_t segment, uint32_t bus)
+{
+  uint32_t i;
+  PCIE_INFO_BLOCK *block;
+
+  if (g_pcie_ecam_lookup) {
+      if (segment > g_pcie_ecam_lookup_max_seg)
+          return 0;
+      return g_pcie_ecam_lookup[(g_pcie_ecam_lookup_slot[segment] * PCIE_MAX_BUS) + bus];
+  }
+
+  for (i = 0; i < g_pcie_info_table->num_entries; i++) {
+      block = &g_pcie_info_table->block[i];
+      if ((bus >= block->start_bus_num) && (bus <= block->end_bus_num) &&
+          (segment == block->segment_num)) {
+          if (block->ecam_base == 0)
+              return 0;
+          return block->ecam_base + (bus * PCIE_MAX_DEV * PCIE_MAX_FUNC * PCIE_CFG_SIZE);
+      }
+  }
+
+  return 0;
+}
+
 /**
   @brief   This API reads 32-bit data from PCIe config space pointed by Bus,
            Device, Function and register offset.
@@ -46,9 +93,7 @@ val_pcie_read_cfg(uint32_t bdf, uint32_t offset, uint32_t *data)
   uint32_t dev     = PCIE_EXTRACT_BDF_DEV(bdf);
   uint32_t func    = PCIE_EXTRACT_BDF_FUNC(bdf);
   uint32_t segment = PCIE_EXTRACT_BDF_SEG(bdf);
-  uint32_t cfg_addr;
-  addr_t   ecam_base = 0;
-  uint32_t i = 0;
+  addr_t   cfg_base;
 
 
   if ((bus >= PCIE_MAX_BUS) || (dev >= PCIE_MAX_DEV) || (func >= PCIE_MAX_FUNC)) {
@@ -61,28 +106,17 @@ val_pcie_read_cfg(uint32_t bdf, uint32_t offset, uint32_t *data)
       return PCIE_NO_MAPPING;
   }
 
-  while (i < val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0))
-  {
-
-      if ((bus >= val_pcie_get_info(PCIE_INFO_START_BUS, i)) &&
-           (bus <= val_pcie_get_info(PCIE_INFO_END_BUS, i)) &&
-           (segment == val_pcie_get_info(PCIE_INFO_SEGMENT, i))) {
-          ecam_base = val_pcie_get_info(PCIE_INFO_ECAM, i);
-          break;
-      }
-      i++;
-  }
-
-  if (ecam_base == 0) {
+  cfg_base = val_pcie_get_bus_cfg_base(segment, bus);
+  if (cfg_base == 0) {
       val_print(AVS_PRINT_ERR, "\n       Read PCIe_CFG: ECAM Base is zero for bdf %x", bdf);
       return PCIE_NO_MAPPING;
   }
 
   /* There are 8 functions / device, 32 devices / Bus and each has a 4KB config space */
-  cfg_addr = (bus * PCIE_MAX_DEV * PCIE_MAX_FUNC * 4096) + \
-               (dev * PCIE_MAX_FUNC * 4096) + (func * 4096);
+  cfg_base += (dev * PCIE_MAX_FUNC * PCIE_CFG_SIZE) + (func * PCIE_CFG_SIZE);
 
-  *data = pal_mmio_read(ecam_base + cfg_addr + offset);
+  val_test_profile_count(PROFILE_CFG_READ);
+  *data = pal_mmio_read(cfg_base + offset);
   return 0;
 
 }
@@ -122,9 +156,7 @@ val_pcie_write_cfg(uint32_t bdf, uint32_t offset, uint32_t data)
   uint32_t dev      = PCIE_EXTRACT_BDF_DEV(bdf);
   uint32_t func     = PCIE_EXTRACT_BDF_FUNC(bdf);
   uint32_t segment  = PCIE_EXTRACT_BDF_SEG(bdf);
-  uint32_t cfg_addr;
-  addr_t   ecam_base = 0;
-  uint32_t i = 0;
+  addr_t   cfg_base;
 
 
   if ((bus >= PCIE_MAX_BUS) || (dev >= PCIE_MAX_DEV) || (func >= PCIE_MAX_FUNC)) {
@@ -137,28 +169,17 @@ val_pcie_write_cfg(uint32_t bdf, uint32_t offset, uint32_t data)
       return;
   }
 
-  while (i < val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0))
-  {
-
-      if ((bus >= val_pcie_get_info(PCIE_INFO_START_BUS, i)) &&
-           (bus <= val_pcie_get_info(PCIE_INFO_END_BUS, i)) &&
-           (segment == val_pcie_get_info(PCIE_INFO_SEGMENT, i))) {
-          ecam_base = val_pcie_get_info(PCIE_INFO_ECAM, i);
-          break;
-      }
-      i++;
-  }
-
-  if (ecam_base == 0) {
+  cfg_base = val_pcie_get_bus_cfg_base(segment, bus);
+  if (cfg_base == 0) {
       val_print(AVS_PRINT_ERR, "\n       Read PCIe_CFG: ECAM Base is zero ", 0);
       return;
   }
 
   /* There are 8 functions / device, 32 devices / Bus and each has a 4KB config space */
-  cfg_addr = (bus * PCIE_MAX_DEV * PCIE_MAX_FUNC * 4096) + \
-               (dev * PCIE_MAX_FUNC * 4096) + (func * 4096);
+  cfg_base += (dev * PCIE_MAX_FUNC * PCIE_CFG_SIZE) + (func * PCIE_CFG_SIZE);
 
-  pal_mmio_write(ecam_base + cfg_addr + offset, data);
+  val_test_profile_count(PROFILE_CFG_WRITE);
+  pal_mmio_write(cfg_base + offset, data);
 }
 
 /**
@@ -468,6 +489,82 @@ val_pcie_print_device_info(void)
   }
 }
 
+/**
+  @brief   Builds a flat table of the config space base of every bus, indexed
+           by (segment slot, bus), and a segment -> slot index, so that the
+           config space accessors get the base of a bus with two table loads
+           instead of walking the ECAM regions on every access. Only the
+           segments present in the ECAM table get a slot of buses, the others
+           share one slot of zeros. Where ECAM regions overlap the first one
+           wins, as in the ECAM walk.
+  @param   None
+
+  @return  None
+**/
+static void
+val_pcie_create_ecam_lookup(void)
+{
+  uint32_t i, bus, slot, num_segs = 0, max_seg = 0;
+  uint32_t num_entries = g_pcie_info_table->num_entries;
+  uint32_t size;
+  PCIE_INFO_BLOCK *block;
+
+  g_pcie_ecam_lookup = NULL;
+  g_pcie_ecam_lookup_slot = NULL;
+  g_pcie_ecam_lookup_max_seg = 0;
+  g_pcie_ecam_lookup_size = 0;
+
+  if (num_entries == 0)
+      return;
+
+  for (i = 0; i < num_entries; i++) {
+      block = &g_pcie_info_table->block[i];
+      if ((block->ecam_base != 0) && (block->segment_num > max_seg))
+          max_seg = block->segment_num;
+  }
+
+  /* PCI segment groups are 16 bit, keep the ECAM walk for anything else */
+  if (max_seg > 0xFFFF)
+      return;
+
+  /* There are at most as many segments as ECAM regions, plus the slot of zeros.
+     The segment index follows the bus table in the same allocation. */
+  size = (num_entries + 1) * PCIE_MAX_BUS * sizeof(addr_t) + (max_seg + 1) * sizeof(uint16_t);
+  g_pcie_ecam_lookup = (addr_t *)pal_mem_alloc(size);
+  if (g_pcie_ecam_lookup == NULL) {
+      val_print(AVS_PRINT_WARN, "\n       ECAM lookup table allocation failed", 0);
+      return;
+  }
+
+  pal_mem_set(g_pcie_ecam_lookup, size, 0);
+  g_pcie_ecam_lookup_slot = (uint16_t *)(g_pcie_ecam_lookup + ((num_entries + 1) * PCIE_MAX_BUS));
+  pal_mem_set(g_pcie_ecam_lookup_slot, (max_seg + 1) * sizeof(uint16_t), 0xFF);
+
+  for (i = 0; i < num_entries; i++) {
+      block = &g_pcie_info_table->block[i];
+      if (block->ecam_base == 0)
+          continue;
+
+      if (g_pcie_ecam_lookup_slot[block->segment_num] == 0xFFFF)
+          g_pcie_ecam_lookup_slot[block->segment_num] = num_segs++;
+
+      slot = g_pcie_ecam_lookup_slot[block->segment_num];
+      for (bus = block->start_bus_num; (bus <= block->end_bus_num) && (bus < PCIE_MAX_BUS); bus++) {
+          if (g_pcie_ecam_lookup[(slot * PCIE_MAX_BUS) + bus] == 0)
+              g_pcie_ecam_lookup[(slot * PCIE_MAX_BUS) + bus] =
+                  block->ecam_base + (bus * PCIE_MAX_DEV * PCIE_MAX_FUNC * PCIE_CFG_SIZE);
+      }
+  }
+
+  for (i = 0; i <= max_seg; i++) {
+      if (g_pcie_ecam_lookup_slot[i] == 0xFFFF)
+          g_pcie_ecam_lookup_slot[i] = num_segs;
+  }
+
+  g_pcie_ecam_lookup_max_seg = max_seg;
+  g_pcie_ecam_lookup_size = size;
+}
+
 /**
   @brief   This API will call PAL layer to fill in the PCIe information
            into the g_pcie_info_table pointer.
@@ -489,6 +586,7 @@ val_pcie_create_info_table(uint64_t *pcie_info_table)
   g_pcie_info_table = (PCIE_INFO_TABLE *)pcie_info_table;
 
   pal_pcie_create_info_table(g_pcie_info_table);
+  val_pcie_create_ecam_lookup();
 
   val_print(AVS_PRINT_TEST, " PCIE_INFO: Number of ECAM regions    :    %lx \n", val_pcie_get_info(PCIE_INFO_NUM_ECAM, 0));
 
@@ -543,22 +641,359 @@ static uint32_t val_pcie_populate_device_rootport(void)
   return 0;
 }
 
+/**
+  @brief   State of a parallel probe of the ECAM regions, read by the secondary
+           PEs with their MMU off, so it is cleaned to memory before dispatch.
+**/
+static struct {
+  pcie_scan_shard *shards;
+  uint32_t         stride;
+  uint32_t         num_shards;
+  uint32_t         num_workers;
+} g_pcie_scan;
+
+/**
+  @brief  Probes every device on the given bus and records the functions
+          which respond in the shard. Functions 1-7 are only probed when
+          function 0 is present and multi-function. Kept free of prints and deep calls, as it may run on a secondary
+          PE with a small stack.
+
+  @param  shard  - Shard of the ECAM region the bus belongs to
+  @param  bus    - Bus to be probed
+
+  @return PCIE_SUCCESS, PCIE_NO_MAPPING or PCIE_SCAN_FULL
+**/
+static uint32_t
+val_pcie_probe_bus(pcie_scan_shard *shard, uint32_t bus)
+{
+  uint32_t dev_index;
+  uint32_t func_index;
+  uint32_t num_func;
+  uint32_t reg_value;
+  uint32_t htr;
+  addr_t   bus_base;
+  addr_t   cfg_base;
+
+  bus_base = val_pcie_get_bus_cfg_base(shard->seg_num, bus);
+  if (bus_base == 0)
+      return PCIE_NO_MAPPING;
+
+  for (dev_index = 0; dev_index < PCIE_MAX_DEV; dev_index++)
+  {
+      num_func = PCIE_MAX_FUNC;
+
+      for (func_index = 0; func_index < num_func; func_index++)
+      {
+          cfg_base = bus_base + (dev_index * PCIE_MAX_FUNC * PCIE_CFG_SIZE) +
+                                (func_index * PCIE_CFG_SIZE);
+
+          shard->cfg_reads++;
+          reg_value = pal_mmio_read(cfg_base + TYPE01_VIDR);
+          if (reg_value == PCIE_UNKNOWN_RESPONSE)
+          {
+              /* No other function may be present if function 0 is absent */
+              if (func_index == 0)
+                  break;
+              continue;
+          }
+
+          shard->cfg_reads++;
+          htr = (pal_mmio_read(cfg_base + TYPE01_CLSR) >> TYPE01_HTR_SHIFT) & TYPE01_HTR_MASK;
+
+          /* Single function device, skip function 1-7 */
+          if ((func_index == 0) && !((htr >> HTR_MFD_SHIFT) & HTR_MFD_MASK))
+              num_func = 1;
+
+          if (shard->num_entries >= PCIE_SCAN_MAX_BDF)
+              return PCIE_SCAN_FULL;
+
+          shard->bdf[shard->num_entries++] =
+                        PCIE_CREATE_BDF(shard->seg_num, bus, dev_index, func_index);
+      }
+  }
+
+  return PCIE_SUCCESS;
+}
+
+/**
+  @brief  Probes every bus of one ECAM region in ascending order, so the
+          shard is in BDF order. Buses are not limited to the ranges behind
+          the bridges found, as the root buses of other host bridges may sit
+          anywhere in the region.
+
+  @param  shard  - Shard of the ECAM region, seg_num, start_bus and end_bus set
+
+  @return None, the result is left in shard->status and shard->done is set
+**/
+static void
+val_pcie_probe_ecam(pcie_scan_shard *shard)
+{
+  uint32_t bus_index;
+  uint32_t status = PCIE_SUCCESS;
+
+  for (bus_index = shard->start_bus;
+       (bus_index <= shard->end_bus) && (status == PCIE_SUCCESS); bus_index++)
+  {
+      status = val_pcie_probe_bus(shard, bus_index);
+      if (status == PCIE_NO_MAPPING)
+          shard->failed_bus = bus_index;
+  }
+
+  shard->status = status;
+  shard->done = 1;
+}
+
+#ifndef TARGET_LINUX
+/**
+  @brief  Payload run by the secondary PEs taking part in a parallel probe.
+          Worker w probes the ECAM regions w, w + num_workers, ...
+
+  @param  None
+
+  @return None
+**/
+static void
+val_pcie_probe_payload(void)
+{
+  uint32_t index = val_pe_get_index_mpid(val_pe_get_mpid());
+  uint64_t payload, worker;
+  uint32_t i;
+
+  val_get_test_data(index, &payload, &worker);
+
+  for (i = (uint32_t)worker; i < g_pcie_scan.num_shards; i += g_pcie_scan.num_workers)
+      val_pcie_probe_ecam((pcie_scan_shard *)((uint8_t *)g_pcie_scan.shards +
+                                              (i * g_pcie_scan.stride)));
+}
+
+/**
+  @brief  Probes the ECAM regions on up to one PE per region, the present PE
+          being worker 0. Every region is probed into a private shard which
+          is padded to a page, so that no two PEs write to the same cache line.
+
+  @param  None
+
+  @return 0 on success, 1 if a secondary PE did not complete in time
+**/
+static uint32_t
+val_pcie_probe_parallel(void)
+{
+  uint32_t i, pe, worker;
+  uint32_t num_pe = val_pe_get_num();
+  uint32_t my_index = val_pe_get_index_mpid(val_pe_get_mpid());
+  volatile pcie_scan_shard *shard;
+  VAL_TIMEOUT_t timeout;
+
+  g_pcie_scan.num_workers = (num_pe < g_pcie_scan.num_shards) ? num_pe : g_pcie_scan.num_shards;
+
+  /* Publish the probe state and the ECAM lookup table to memory */
+  val_data_cache_ops_by_va((addr_t)&g_pcie_scan, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)&g_pcie_ecam_lookup, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)&g_pcie_ecam_lookup_slot, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)&g_pcie_ecam_lookup_max_seg, CLEAN_AND_INVALIDATE);
+  if (g_pcie_ecam_lookup)
+      val_data_cache_ops_by_range((addr_t)g_pcie_ecam_lookup, g_pcie_ecam_lookup_size, CLEAN);
+  val_data_cache_ops_by_range((addr_t)g_pcie_scan.shards,
+                              (uint64_t)g_pcie_scan.num_shards * g_pcie_scan.stride,
+                              CLEAN_AND_INVALIDATE);
+
+  val_print(AVS_PRINT_DEBUG, "\n       PCIe probe on %d PEs", g_pcie_scan.num_workers);
+
+  for (worker = 1, pe = 0; (worker < g_pcie_scan.num_workers) && (pe < num_pe); pe++) {
+      if (pe == my_index)
+          continue;
+      val_execute_on_pe(pe, val_pcie_probe_payload, worker++);
+  }
+
+  /* Worker 0, the present PE */
+  for (i = 0; i < g_pcie_scan.num_shards; i += g_pcie_scan.num_workers)
+      val_pcie_probe_ecam((pcie_scan_shard *)((uint8_t *)g_pcie_scan.shards +
+                                              (i * g_pcie_scan.stride)));
+
+  val_timeout_start(&timeout, PCIE_SCAN_TIMEOUT_US);
+  for (i = 0; i < g_pcie_scan.num_shards; i++) {
+      if ((i % g_pcie_scan.num_workers) == 0)
+          continue;
+
+      shard = (pcie_scan_shard *)((uint8_t *)g_pcie_scan.shards + (i * g_pcie_scan.stride));
+      do {
+          val_data_cache_ops_by_va((addr_t)&shard->done, INVALIDATE);
+      } while (!shard->done && !val_timeout_expired(&timeout));
+
+      if (!shard->done) {
+          val_print(AVS_PRINT_ERR, "\n       PCIe probe of ECAM %d timed out", i);
+          return 1;
+      }
+  }
+
+  /* Own shards are dirty in the cache, the other ones were written to memory */
+  val_data_cache_ops_by_range((addr_t)g_pcie_scan.shards,
+                              (uint64_t)g_pcie_scan.num_shards * g_pcie_scan.stride,
+                              CLEAN_AND_INVALIDATE);
+  return 0;
+}
+#endif
+
+/**
+  @brief   Returns the slot of a BDF in the BDF hash, packing segment, bus,
+           device and function into a 24 bit key.
+  @param   bdf - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+
+  @return  initial hash slot
+**/
+static uint32_t
+val_pcie_bdf_hash_slot(uint32_t bdf)
+{
+  uint32_t key;
+
+  key = (PCIE_EXTRACT_BDF_SEG(bdf) << 16) | (PCIE_EXTRACT_BDF_BUS(bdf) << 8) |
+        ((PCIE_EXTRACT_BDF_DEV(bdf) & 0x1F) << 3) | (PCIE_EXTRACT_BDF_FUNC(bdf) & 0x7);
+
+  return (key * 0x9E3779B1u) >> (32 - PCIE_BDF_HASH_BITS);
+}
+
+/**
+  @brief   Returns the g_pcie_bdf_table entry of a BDF.
+  @param   bdf - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+
+  @return  entry of the BDF, NULL if the BDF is not part of the table
+**/
+static pcie_device_attr *
+val_pcie_bdf_lookup(uint32_t bdf)
+{
+  uint32_t slot;
+  uint32_t probe;
+  uint16_t index;
+
+  if (!g_pcie_bdf_hash_valid)
+      return NULL;
+
+  slot = val_pcie_bdf_hash_slot(bdf);
+  for (probe = 0; probe < PCIE_BDF_HASH_SIZE; probe++)
+  {
+      index = g_pcie_bdf_hash[slot];
+      if (index == PCIE_BDF_HASH_EMPTY)
+          return NULL;
+
+      if (g_pcie_bdf_table->device[index].bdf == bdf)
+          return &g_pcie_bdf_table->device[index];
+
+      slot = (slot + 1) & (PCIE_BDF_HASH_SIZE - 1);
+  }
+
+  return NULL;
+}
+
+/**
+  @brief   Records the capabilities of a function in its capability index,
+           in list order so that a lookup returns the same offset as a walk.
+           The index is left invalid if the function does not respond and
+           marked partial if it overflows or a list does not terminate, in
+           both cases val_pcie_find_capability falls back to walking the lists.
+  @param   dev - g_pcie_bdf_table entry of the function
+
+  @return  None
+**/
+static void
+val_pcie_cap_index_fill(pcie_device_attr *dev)
+{
+  uint32_t reg_value;
+  uint32_t next_cap_offset;
+  uint32_t count;
+  uint32_t ret;
+
+  dev->cap_state = PCIE_CAP_INDEX_INVALID;
+  dev->num_cap = 0;
+
+  ret = val_pcie_read_cfg(dev->bdf, TYPE01_CPR, &reg_value);
+  if (ret == PCIE_NO_MAPPING || reg_value == PCIE_UNKNOWN_RESPONSE)
+      return;
+
+  dev->cap_state = PCIE_CAP_INDEX_VALID;
+
+  /* PCI capabilities, at most 48 fit in the 192 bytes after the header */
+  next_cap_offset = (reg_value & TYPE01_CPR_MASK);
+  for (count = 0; next_cap_offset && (count < 48); count++)
+  {
+      val_pcie_read_cfg(dev->bdf, next_cap_offset, &reg_value);
+      if (dev->num_cap < PCIE_CAP_INDEX_SIZE)
+          dev->cap[dev->num_cap++] = (next_cap_offset << 16) | (reg_value & PCIE_CIDR_MASK);
+      else
+          dev->cap_state = PCIE_CAP_INDEX_PARTIAL;
+      next_cap_offset = ((reg_value >> PCIE_NCPR_SHIFT) & PCIE_NCPR_MASK);
+  }
+
+  if (next_cap_offset)
+      dev->cap_state = PCIE_CAP_INDEX_PARTIAL;
+
+  /* PCIe extended capabilities, at most 960 fit in the extended config space */
+  next_cap_offset = PCIE_ECAP_START;
+  for (count = 0; next_cap_offset && (count < 960); count++)
+  {
+      val_pcie_read_cfg(dev->bdf, next_cap_offset, &reg_value);
+      if (reg_value == PCIE_UNKNOWN_RESPONSE)
+          break;
+      if (dev->num_cap < PCIE_CAP_INDEX_SIZE)
+          dev->cap[dev->num_cap++] = PCIE_CAP_INDEX_ECAP | (next_cap_offset << 16) |
+                                     (reg_value & PCIE_ECAP_CIDR_MASK);
+      else
+          dev->cap_state = PCIE_CAP_INDEX_PARTIAL;
+      next_cap_offset = ((reg_value >> PCIE_ECAP_NCPR_SHIFT) & PCIE_ECAP_NCPR_MASK);
+  }
+
+  if (next_cap_offset)
+      dev->cap_state = PCIE_CAP_INDEX_PARTIAL;
+}
+
+/**
+  @brief   Builds the BDF hash over g_pcie_bdf_table and the capability index
+           of every function in the table.
+           1. Caller       -  val_pcie_create_device_bdf_table
+           2. Prerequisite -  g_pcie_bdf_table populated
+
+  @return  None
+**/
+static void
+val_pcie_cap_index_build(void)
+{
+  uint32_t tbl_index;
+  uint32_t slot;
+
+  g_pcie_bdf_hash_valid = 0;
+  for (slot = 0; slot < PCIE_BDF_HASH_SIZE; slot++)
+      g_pcie_bdf_hash[slot] = PCIE_BDF_HASH_EMPTY;
+
+  for (tbl_index = 0; tbl_index < g_pcie_bdf_table->num_entries; tbl_index++)
+  {
+      slot = val_pcie_bdf_hash_slot(g_pcie_bdf_table->device[tbl_index].bdf);
+      while (g_pcie_bdf_hash[slot] != PCIE_BDF_HASH_EMPTY)
+          slot = (slot + 1) & (PCIE_BDF_HASH_SIZE - 1);
+      g_pcie_bdf_hash[slot] = tbl_index;
+
+      val_pcie_cap_index_fill(&g_pcie_bdf_table->device[tbl_index]);
+  }
+
+  g_pcie_bdf_hash_valid = 1;
+
+  /* Make the index visible to PEs running with the MMU off */
+  val_data_cache_ops_by_range((addr_t)g_pcie_bdf_table, PCIE_DEVICE_BDF_TABLE_SZ, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_range((addr_t)g_pcie_bdf_hash, sizeof(g_pcie_bdf_hash), CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_range((addr_t)&g_pcie_bdf_hash_valid, sizeof(g_pcie_bdf_hash_valid),
+                              CLEAN_AND_INVALIDATE);
+}
+
 uint32_t
 val_pcie_create_device_bdf_table()
 {
 
   uint32_t num_ecam;
-  uint32_t seg_num;
-  uint32_t start_bus;
-  uint32_t end_bus;
-  uint32_t bus_index;
-  uint32_t dev_index;
-  uint32_t func_index;
   uint32_t ecam_index;
+  uint32_t tbl_index;
   uint32_t bdf;
-  uint32_t reg_value;
   uint32_t cid_offset;
   uint32_t status;
+  uint32_t cfg_reads = 0;
+  pcie_scan_shard *shard;
 
   /* if table is already present, return success */
   if (g_pcie_bdf_table)
@@ -582,53 +1017,113 @@ val_pcie_create_device_bdf_table()
       return 1;
   }
 
+  /* One shard per ecam, padded to a page */
+  g_pcie_scan.stride = ((uint32_t)sizeof(pcie_scan_shard) + MEM_ALIGN_4K - 1) & ~(MEM_ALIGN_4K - 1);
+  g_pcie_scan.num_shards = num_ecam;
+  g_pcie_scan.shards = (pcie_scan_shard *)pal_aligned_alloc(MEM_ALIGN_4K,
+                                                            num_ecam * g_pcie_scan.stride);
+  if (!g_pcie_scan.shards)
+  {
+      val_print(AVS_PRINT_ERR, "\n       PCIe scan memory allocation failed          ", 0);
+      return 1;
+  }
+
+  pal_mem_set(g_pcie_scan.shards, num_ecam * g_pcie_scan.stride, 0);
+
   for (ecam_index = 0; ecam_index < num_ecam; ecam_index++)
   {
       /* Derive ecam specific information */
-      seg_num = val_pcie_get_info(PCIE_INFO_SEGMENT, ecam_index);
-      start_bus = val_pcie_get_info(PCIE_INFO_START_BUS, ecam_index);
-      end_bus = val_pcie_get_info(PCIE_INFO_END_BUS, ecam_index);
+      shard = (pcie_scan_shard *)((uint8_t *)g_pcie_scan.shards + (ecam_index * g_pcie_scan.stride));
+      shard->seg_num = val_pcie_get_info(PCIE_INFO_SEGMENT, ecam_index);
+      shard->start_bus = val_pcie_get_info(PCIE_INFO_START_BUS, ecam_index);
+      shard->end_bus = val_pcie_get_info(PCIE_INFO_END_BUS, ecam_index);
+
+      if (shard->end_bus >= PCIE_MAX_BUS)
+          shard->end_bus = PCIE_MAX_BUS - 1;
 
-      /* Iterate over all buses, devices and functions in this ecam */
-      for (bus_index = start_bus; bus_index <= end_bus; bus_index++)
+      /* Nothing to probe */
+      if (shard->start_bus > shard->end_bus)
+          shard->done = 1;
+  }
+
+  status = 1;
+#ifndef TARGET_LINUX
+  /* Secondary PEs need the ECAM lookup table and the shared memory */
+  if (g_pcie_parallel_enum && (num_ecam > 1) && (val_pe_get_num() > 1) &&
+      g_pcie_ecam_lookup && val_get_shared_mem_cmd(0)) {
+      if (val_pcie_probe_parallel()) {
+          /* A PE which did not complete may still write to its shard, so the
+             shards are leaked rather than handed back to the allocator */
+          g_pcie_scan.shards = NULL;
+          return 1;
+      }
+      status = 0;
+  }
+#endif
+
+  /* Serial probe, one ecam at a time */
+  for (ecam_index = 0; status && (ecam_index < num_ecam); ecam_index++)
+  {
+      shard = (pcie_scan_shard *)((uint8_t *)g_pcie_scan.shards + (ecam_index * g_pcie_scan.stride));
+      if (!shard->done)
+          val_pcie_probe_ecam(shard);
+  }
+
+  /* Merge the shards in ecam order, the same order as a serial scan, and drop
+     the functions which are not part of the table */
+  for (ecam_index = 0; ecam_index < num_ecam; ecam_index++)
+  {
+      shard = (pcie_scan_shard *)((uint8_t *)g_pcie_scan.shards + (ecam_index * g_pcie_scan.stride));
+      cfg_reads += shard->cfg_reads;
+
+      if (shard->status == PCIE_NO_MAPPING)
       {
-          for (dev_index = 0; dev_index < PCIE_MAX_DEV; dev_index++)
+          /* Return if there is a bdf mapping issue */
+          val_print(AVS_PRINT_ERR, "\n       BDF 0x%x mapping issue",
+                    PCIE_CREATE_BDF(shard->seg_num, shard->failed_bus, 0, 0));
+          pal_mem_free_aligned(g_pcie_scan.shards);
+          g_pcie_scan.shards = NULL;
+          return 1;
+      }
+
+      if (shard->status == PCIE_SCAN_FULL)
+          val_print(AVS_PRINT_WARN, "\n       Too many functions in ECAM %d, table truncated",
+                    ecam_index);
+
+      for (tbl_index = 0; tbl_index < shard->num_entries; tbl_index++)
+      {
+          bdf = shard->bdf[tbl_index];
+
+          /* Skip if the device is a host bridge */
+          if (val_pcie_is_host_bridge(bdf))
+              continue;
+
+          /* Skip if the device is a PCI legacy device */
+          if (val_pcie_find_capability(bdf, PCIE_CAP, CID_PCIECS,  &cid_offset) != PCIE_SUCCESS)
+              continue;
+
+          status = pal_pcie_check_device_valid(bdf);
+          if (status)
+              continue;
+
+          if (g_pcie_bdf_table->num_entries >= PCIE_DEVICE_BDF_TABLE_ENTRIES)
           {
-              for (func_index = 0; func_index < PCIE_MAX_FUNC; func_index++)
-              {
-                  /* Form bdf using seg, bus, device, function numbers */
-                  bdf = PCIE_CREATE_BDF(seg_num, bus_index, dev_index, func_index);
-
-                  /* Probe pcie device Function with this bdf */
-                  if (val_pcie_read_cfg(bdf, TYPE01_VIDR, &reg_value) == PCIE_NO_MAPPING)
-                  {
-                      /* Return if there is a bdf mapping issue */
-                      val_print(AVS_PRINT_ERR, "\n       BDF 0x%x mapping issue", bdf);
-                      return 1;
-                  }
-
-                  /* Store the Function's BDF if there was a valid response */
-                  if (reg_value != PCIE_UNKNOWN_RESPONSE)
-                  {
-                      /* Skip if the device is a host bridge */
-                      if (val_pcie_is_host_bridge(bdf))
-                          continue;
-
-                      /* Skip if the device is a PCI legacy device */
-                      if (val_pcie_find_capability(bdf, PCIE_CAP, CID_PCIECS,  &cid_offset) != PCIE_SUCCESS)
-                          continue;
-
-                      status = pal_pcie_check_device_valid(bdf);
-                      if (status)
-                          continue;
-
-                      g_pcie_bdf_table->device[g_pcie_bdf_table->num_entries++].bdf = bdf;
-                  }
-              }
+              val_print(AVS_PRINT_WARN, "\n       PCIe BDF table full, BDF 0x%x dropped", bdf);
+              continue;
           }
+
+          g_pcie_bdf_table->device[g_pcie_bdf_table->num_entries++].bdf = bdf;
       }
   }
 
+  pal_mem_free_aligned(g_pcie_scan.shards);
+  g_pcie_scan.shards = NULL;
+
+  val_print(AVS_PRINT_TEST,
+            " PCIE_INFO: Config reads for BDF scan :    %d\n", cfg_reads);
+
+  val_pcie_cap_index_build();
+
   /* Sanity Check : Confirm all EP (normal, integrated) have a rootport */
   if (val_pcie_populate_device_rootport())
   {
@@ -710,6 +1205,14 @@ val_pcie_bdf_table_ptr()
 void
 val_pcie_free_info_table()
 {
+  if (g_pcie_ecam_lookup) {
+      pal_mem_free((void *)g_pcie_ecam_lookup);
+      g_pcie_ecam_lookup = NULL;
+      g_pcie_ecam_lookup_slot = NULL;
+      g_pcie_ecam_lookup_max_seg = 0;
+      g_pcie_ecam_lookup_size = 0;
+  }
+
   pal_mem_free((void *)g_pcie_info_table);
 }
 
@@ -1194,8 +1697,8 @@ val_pcie_device_port_type(uint32_t bdf)
 }
 
 /**
-  @brief  Find a Function's config capability offset matching it's input parameter
-          cid. cid_offset set to the matching cpability offset w.r.t. zero.
+  @brief  Walk a Function's capability list for the capability matching the input
+          parameter cid. cid_offset set to the matching cpability offset w.r.t. zero.
 
   @param  bdf        - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
   @param  cid        - Capability ID
@@ -1203,8 +1706,8 @@ val_pcie_device_port_type(uint32_t bdf)
   @return PCIE_CAP_NOT_FOUND, if there was a failure in finding required capability.
           PCIE_SUCCESS, if the search was successful.
 **/
-uint32_t
-val_pcie_find_capability(uint32_t bdf, uint32_t cid_type, uint32_t cid, uint32_t *cid_offset)
+static uint32_t
+val_pcie_walk_capability(uint32_t bdf, uint32_t cid_type, uint32_t cid, uint32_t *cid_offset)
 {
 
   uint32_t reg_value;
@@ -1250,6 +1753,115 @@ val_pcie_find_capability(uint32_t bdf, uint32_t cid_type, uint32_t cid, uint32_t
   return PCIE_CAP_NOT_FOUND;
 }
 
+/**
+  @brief  Find a Function's config capability offset matching it's input parameter
+          cid. cid_offset set to the matching cpability offset w.r.t. zero.
+          Functions in g_pcie_bdf_table are looked up in their capability index,
+          which is rebuilt here after val_pcie_cap_index_invalidate.
+
+  @param  bdf        - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @param  cid        - Capability ID
+  @param  cid_offset - On return, points to cid offset in Function config space
+  @return PCIE_CAP_NOT_FOUND, if there was a failure in finding required capability.
+          PCIE_SUCCESS, if the search was successful.
+**/
+uint32_t
+val_pcie_find_capability(uint32_t bdf, uint32_t cid_type, uint32_t cid, uint32_t *cid_offset)
+{
+
+  pcie_device_attr *dev;
+  uint32_t ecap;
+  uint32_t index;
+
+  dev = val_pcie_bdf_lookup(bdf);
+  if (dev && (cid_type == PCIE_CAP || cid_type == PCIE_ECAP))
+  {
+      if (dev->cap_state == PCIE_CAP_INDEX_INVALID)
+          val_pcie_cap_index_fill(dev);
+
+      if (dev->cap_state != PCIE_CAP_INDEX_INVALID)
+      {
+          ecap = (cid_type == PCIE_ECAP) ? PCIE_CAP_INDEX_ECAP : 0;
+          for (index = 0; index < dev->num_cap; index++)
+          {
+              if (((dev->cap[index] & PCIE_CAP_INDEX_ECAP) == ecap) &&
+                  ((dev->cap[index] & 0xFFFF) == cid))
+              {
+                  *cid_offset = (dev->cap[index] >> 16) & 0xFFF;
+                  return PCIE_SUCCESS;
+              }
+          }
+
+          if (dev->cap_state == PCIE_CAP_INDEX_VALID)
+              return PCIE_CAP_NOT_FOUND;
+      }
+  }
+
+  return val_pcie_walk_capability(bdf, cid_type, cid, cid_offset);
+}
+
+/**
+  @brief  Invalidates the capability index of a Function, to be called after
+          resetting the Function (e.g. FLR). The index is rebuilt on the next
+          val_pcie_find_capability of the Function.
+
+  @param  bdf        - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @return None
+**/
+void
+val_pcie_cap_index_invalidate(uint32_t bdf)
+{
+
+  pcie_device_attr *dev;
+
+  dev = val_pcie_bdf_lookup(bdf);
+  if (!dev)
+      return;
+
+  dev->cap_state = PCIE_CAP_INDEX_INVALID;
+  dev->num_cap = 0;
+}
+
+/**
+  @brief  Invalidates the capability index of every Function below a Port,
+          i.e. on its secondary to subordinate buses, to be called after a
+          secondary bus reset of the Port.
+
+  @param  bdf        - Segment/Bus/Dev/Func of the Port in PCIE_CREATE_BDF format
+  @return None
+**/
+void
+val_pcie_cap_index_invalidate_bus_range(uint32_t bdf)
+{
+
+  uint32_t reg_value;
+  uint32_t sec_bus;
+  uint32_t sub_bus;
+  uint32_t bus;
+  uint32_t tbl_index;
+  pcie_device_attr *dev;
+
+  if (!g_pcie_bdf_hash_valid)
+      return;
+
+  val_pcie_read_cfg(bdf, TYPE1_PBN, &reg_value);
+  sec_bus = ((reg_value >> SECBN_SHIFT) & SECBN_MASK);
+  sub_bus = ((reg_value >> SUBBN_SHIFT) & SUBBN_MASK);
+
+  for (tbl_index = 0; tbl_index < g_pcie_bdf_table->num_entries; tbl_index++)
+  {
+      dev = &g_pcie_bdf_table->device[tbl_index];
+      bus = PCIE_EXTRACT_BDF_BUS(dev->bdf);
+
+      if ((PCIE_EXTRACT_BDF_SEG(dev->bdf) == PCIE_EXTRACT_BDF_SEG(bdf)) &&
+          (bus >= sec_bus) && (bus <= sub_bus))
+      {
+          dev->cap_state = PCIE_CAP_INDEX_INVALID;
+          dev->num_cap = 0;
+      }
+  }
+}
+
 /**
   @brief  Disables bus master by clearing Bus Master Enable bit in the command register.
           When BME bit is clear, it disables the ability of a Function to issue Memory
@@ -1733,8 +2345,246 @@ uint32_t val_pcie_bitfield_check(uint32_t bdf, uint64_t *bitfield_entry)
   return 0;
 }
 
+/**
+  @brief  Returns the mask of a bit-field within its word aligned register.
+
+  @param  bf_entry - bit-field entry
+  @return mask of the bit-field
+**/
+static uint32_t
+val_pcie_bitfield_mask(pcie_cfgreg_bitfield_entry *bf_entry)
+{
+  return REG_MASK(bf_entry->end, bf_entry->start) <<
+         REG_SHIFT((bf_entry->reg_offset & WORD_ALIGN_MASK), bf_entry->start);
+}
+
+/**
+  @brief  Returns the value of a bit-field from its word aligned register value.
+
+  @param  bf_entry  - bit-field entry
+  @param  reg_value - register value
+  @return value of the bit-field
+**/
+static uint32_t
+val_pcie_bitfield_value(pcie_cfgreg_bitfield_entry *bf_entry, uint32_t reg_value)
+{
+  return (reg_value >> REG_SHIFT((bf_entry->reg_offset & WORD_ALIGN_MASK), bf_entry->start)) &
+         REG_MASK(bf_entry->end, bf_entry->start);
+}
+
+/**
+  @brief  Returns 1 if the bit-field entry's configured value matches and its
+          attribute is one which val_pcie_bitfield_group_probe toggles.
+
+  @param  bf_entry  - bit-field entry
+  @param  reg_value - register value
+  @return 1 if the attribute of the bit-field is to be probed, else 0
+**/
+static uint32_t
+val_pcie_bitfield_is_probed(pcie_cfgreg_bitfield_entry *bf_entry, uint32_t reg_value)
+{
+  if (val_pcie_bitfield_value(bf_entry, reg_value) != bf_entry->cfg_value)
+      return 0;
+
+  return (bf_entry->attr >= HW_INIT) && (bf_entry->attr <= STICKY_RW);
+}
+
+/**
+  @brief  Reads the register of a bit-field group once, then probes the
+          attributes of all its bit-fields applicable to the Function with a
+          single write of the combined toggle mask, and restores the register.
+          Bit-fields whose configured value mismatches are not toggled, as in
+          val_pcie_bitfield_check.
+
+  @param  bdf       - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @param  dp_type   - device/port type of the Function
+  @param  group     - bit-field group, updated with the register values
+  @param  bf_table  - bit-field entries
+  @param  group_idx - group index of every bit-field entry
+  @param  group_num - index of the group to probe
+  @param  num_bitfield_entries - number of bit-field entries
+  @return None
+**/
+static void
+val_pcie_bitfield_group_probe(uint32_t bdf, uint32_t dp_type,
+                              pcie_cfgreg_bitfield_group *group,
+                              pcie_cfgreg_bitfield_entry *bf_table, uint16_t *group_idx,
+                              uint32_t group_num, uint32_t num_bitfield_entries)
+{
+
+  uint32_t index;
+  uint32_t cap_base;
+  uint32_t mask;
+  uint32_t toggle_mask;
+  uint32_t clear_mask;
+  uint32_t reg_value;
+  uint32_t reg_overwrite_value;
+  pcie_cfgreg_bitfield_entry *bf_entry;
+
+  switch (group->reg_type)
+  {
+      case HEADER:
+          cap_base = 0;
+          group->status = PCIE_SUCCESS;
+          break;
+      case PCIE_CAP:
+      case PCIE_ECAP:
+          group->status = val_pcie_find_capability(bdf, group->reg_type, group->cap_id, &cap_base);
+          break;
+      default:
+          /* Reported per entry */
+          group->status = PCIE_SUCCESS;
+          return;
+  }
+
+  if (group->status != PCIE_SUCCESS)
+      return;
+
+  /* Derive bit-fields of interest from the register value */
+  val_pcie_read_cfg(bdf, cap_base + group->reg_offset, &reg_value);
+
+  /* To prevent status bits are clear when write 1, just clear it firstly */
+  val_pcie_write_cfg(bdf, cap_base + group->reg_offset, reg_value);
+  val_pcie_read_cfg(bdf, cap_base + group->reg_offset, &reg_value);
+
+  /* Combine the toggles of all the bit-fields of the register */
+  toggle_mask = clear_mask = 0;
+  for (index = 0; index < num_bitfield_entries; index++)
+  {
+      bf_entry = &bf_table[index];
+      if ((group_idx[index] != group_num) || !(dp_type & bf_entry->dev_port_bitmask) ||
+          !val_pcie_bitfield_is_probed(bf_entry, reg_value))
+          continue;
+
+      mask = val_pcie_bitfield_mask(bf_entry);
+      switch (bf_entry->attr)
+      {
+          case HW_INIT:
+          case READ_ONLY:
+          case STICKY_RO:
+          case READ_WRITE:
+          case STICKY_RW:
+              /* Read-only bits must not change, read-write bits must */
+              toggle_mask |= mask;
+              break;
+          case RSVDZ_RO:
+              /* Software must use 0b to write to these bits */
+              clear_mask |= mask;
+              break;
+          default:
+              /* RsvdP bits are written with the value read */
+              break;
+      }
+  }
+
+  reg_overwrite_value = (reg_value ^ toggle_mask) & ~clear_mask;
+  val_pcie_write_cfg(bdf, cap_base + group->reg_offset, reg_overwrite_value);
+  val_pcie_read_cfg(bdf, cap_base + group->reg_offset, &group->probe_value);
+
+  /* Restore the original register value */
+  if (group->probe_value != reg_value)
+      val_pcie_write_cfg(bdf, cap_base + group->reg_offset, reg_value);
+
+  group->reg_value = reg_value;
+}
+
+/**
+  @brief  Returns whether a device's bit-field passed the compliance check or not,
+          from the register values of its probed group. Reports the same
+          failures as val_pcie_bitfield_check, with the attribute of a bit-field
+          checked on the bit-field alone as the register was probed for all its
+          bit-fields at once.
+
+  @param  bdf      - Segment/Bus/Dev/Func in the format of PCIE_CREATE_BDF
+  @param  bf_entry - Expected bit-field entry configuration for the comparison
+  @param  group    - probed bit-field group of the entry
+  @return Return 0 for success, else 1 for failure.
+**/
+static uint32_t
+val_pcie_bitfield_group_check(uint32_t bdf, pcie_cfgreg_bitfield_entry *bf_entry,
+                              pcie_cfgreg_bitfield_group *group)
+{
+
+  uint32_t bf_value;
+  uint32_t mask;
+  uint32_t expected;
+  uint32_t actual;
+
+  if (bf_entry->reg_type != HEADER && bf_entry->reg_type != PCIE_CAP &&
+      bf_entry->reg_type != PCIE_ECAP)
+  {
+      val_print(AVS_PRINT_ERR, "\n       Invalid reg_type : 0x%x  ", bf_entry->reg_type);
+      return 1;
+  }
+
+  if (group->status != PCIE_SUCCESS)
+  {
+      val_print(AVS_PRINT_ERR, "\n       PCIe Capability not found for BDF 0x%x", bdf);
+      return group->status;
+  }
+
+  /* Check if bit-field value is proper */
+  bf_value = val_pcie_bitfield_value(bf_entry, group->reg_value);
+  if (bf_value != bf_entry->cfg_value)
+  {
+      val_print(AVS_PRINT_ERR, "\n       BDF 0x%x : ", bdf);
+      val_print(AVS_PRINT_ERR, bf_entry->err_str1, 0);
+      val_print(AVS_PRINT_ERR, ": 0x%x", bf_value);
+      val_print(AVS_PRINT_ERR, " instead of 0x%x", bf_entry->cfg_value);
+      if (!val_strncmp(bf_entry->err_str1, "WARNING", WARN_STR_LEN))
+          return 0;
+      return 1;
+  }
+
+  /* Check if bit-field attribute is proper, reporting the register value read
+     back and the one expected with only this bit-field considered */
+  mask = val_pcie_bitfield_mask(bf_entry);
+  switch (bf_entry->attr)
+  {
+      case HW_INIT:
+      case READ_ONLY:
+      case STICKY_RO:
+      case RSVDZ_RO:
+          /* Software must not alter these bits */
+          actual = group->probe_value;
+          expected = (group->probe_value & ~mask) | (group->reg_value & mask);
+          break;
+      case RSVDP_RO:
+          /* Software must return 0 when read */
+          actual = val_pcie_bitfield_value(bf_entry, group->probe_value);
+          expected = 0;
+          break;
+      case READ_WRITE:
+      case STICKY_RW:
+          /* Software can alter these bits, the toggled value must be read back */
+          actual = (group->probe_value & ~mask) | ((group->reg_value ^ mask) & mask);
+          expected = group->probe_value;
+          break;
+      default:
+          val_print(AVS_PRINT_ERR, "\n       Invalid Attribute : 0x%x  ", bf_entry->attr);
+          return 1;
+  }
+
+  if (actual != expected)
+  {
+      val_print(AVS_PRINT_ERR, "\n       BDF 0x%x : ", bdf);
+      val_print(AVS_PRINT_ERR, bf_entry->err_str2, 0);
+      val_print(AVS_PRINT_ERR, ": 0x%x", actual);
+      val_print(AVS_PRINT_ERR, " instead of 0x%x", expected);
+      if (!val_strncmp(bf_entry->err_str2, "WARNING", WARN_STR_LEN))
+          return 0;
+      return 1;
+  }
+
+  /* Return pass status */
+  val_print(AVS_PRINT_INFO, "\n       BDF 0x%x : PASS", bdf);
+  return 0;
+}
+
 /**
   @brief  Returns if a PCIe config register bitfields are as per sbsa specification.
+          Entries are grouped by register, so that each register is read, probed
+          and restored once per Function, and results are reported in table order.
 
   @param  bf_info_table - table of registers and their bit-fields for checking
   @return Return  0                 for success
@@ -1751,13 +2601,63 @@ val_pcie_register_bitfields_check(uint64_t *bf_info_table, uint32_t num_bitfield
   uint32_t num_fails;
   uint32_t num_pass;
   uint32_t index;
+  uint32_t num_groups;
+  uint32_t group_num;
+  uint32_t cap_id;
+  uint16_t *group_idx;
+  pcie_cfgreg_bitfield_group *groups;
+  pcie_cfgreg_bitfield_entry *bf_table;
   pcie_cfgreg_bitfield_entry *bf_entry;
 
   num_fails = num_pass = tbl_index = 0;
+  bf_table = (pcie_cfgreg_bitfield_entry *)bf_info_table;
 
   val_print(AVS_PRINT_INFO, "\n       Number of bit-field entries to check %d",
             num_bitfield_entries);
 
+  groups = pal_mem_alloc(num_bitfield_entries * sizeof(pcie_cfgreg_bitfield_group));
+  group_idx = pal_mem_alloc(num_bitfield_entries * sizeof(uint16_t));
+  if (!groups || !group_idx)
+  {
+      val_print(AVS_PRINT_ERR, "\n       Bit-field group allocation failed", 0);
+      if (groups)
+          pal_mem_free(groups);
+      if (group_idx)
+          pal_mem_free(group_idx);
+      return num_bitfield_entries;
+  }
+
+  /* Group the entries by register */
+  num_groups = 0;
+  for (index = 0; index < num_bitfield_entries; index++)
+  {
+      bf_entry = &bf_table[index];
+      cap_id = (bf_entry->reg_type == PCIE_ECAP) ? bf_entry->ecap_id :
+               (bf_entry->reg_type == PCIE_CAP) ? bf_entry->cap_id : 0;
+
+      for (group_num = 0; group_num < num_groups; group_num++)
+      {
+          if ((groups[group_num].reg_type == bf_entry->reg_type) &&
+              (groups[group_num].cap_id == cap_id) &&
+              (groups[group_num].reg_offset == (bf_entry->reg_offset & ~WORD_ALIGN_MASK)))
+              break;
+      }
+
+      if (group_num == num_groups)
+      {
+          groups[num_groups].reg_type = bf_entry->reg_type;
+          groups[num_groups].cap_id = cap_id;
+          groups[num_groups].reg_offset = bf_entry->reg_offset & ~WORD_ALIGN_MASK;
+          groups[num_groups].dev_port_bitmask = 0;
+          num_groups++;
+      }
+
+      groups[group_num].dev_port_bitmask |= bf_entry->dev_port_bitmask;
+      group_idx[index] = group_num;
+  }
+
+  val_print(AVS_PRINT_INFO, "\n       Number of registers to check %d", num_groups);
+
   while (tbl_index < g_pcie_bdf_table->num_entries)
   {
       bdf = g_pcie_bdf_table->device[tbl_index++].bdf;
@@ -1768,32 +2668,36 @@ val_pcie_register_bitfields_check(uint64_t *bf_info_table, uint32_t num_bitfield
       /* Get the Function's device/port type from bdf */
       dp_type = val_pcie_device_port_type(bdf);
 
-      /* Set variables to iterate over all bit-field entries */
-      bf_entry = (pcie_cfgreg_bitfield_entry *)&(bf_info_table[0]);
+      /* Probe every register with entries applicable to the Function */
+      for (group_num = 0; group_num < num_groups; group_num++)
+      {
+          if (dp_type & groups[group_num].dev_port_bitmask)
+              val_pcie_bitfield_group_probe(bdf, dp_type, &groups[group_num], bf_table,
+                                            group_idx, group_num, num_bitfield_entries);
+      }
 
       for (index = 0; index < num_bitfield_entries; index++)
       {
+          bf_entry = &bf_table[index];
+
           /*
            * Skip this entry checking, if the Function
            * is not part of it's device/port bit mask.
            */
           if (!(dp_type & bf_entry->dev_port_bitmask))
-          {
-              bf_entry++;
               continue;
-          }
 
           /* Check for the compliance */
-          if (val_pcie_bitfield_check(bdf, (void *)bf_entry))
+          if (val_pcie_bitfield_group_check(bdf, bf_entry, &groups[group_idx[index]]))
               num_fails++;
           else
               num_pass++;
-
-          /* Adjust the pointer to next bf */
-          bf_entry++;
       }
   }
 
+  pal_mem_free(groups);
+  pal_mem_free(group_idx);
+
   /* Return register check status */
   if (num_pass > 0 || num_fails > 0)
       return num_fails;
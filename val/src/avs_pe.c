@@ -249,6 +249,10 @@ val_pe_reg_read(uint32_t reg_id)
             return AA64ReadTcr2();
       case ID_AA64ZFR0_EL1:
           return AA64ReadZfr0();
+      case TPIDR_ELx:
+          if (AA64ReadCurrentEL() == AARCH64_EL1)
+            return AA64ReadTpidr1();
+          return AA64ReadTpidr2();
       default:
            val_report_status(val_pe_get_index_mpid(val_pe_get_mpid()),
                              RESULT_FAIL(g_sbsa_level, 0, 0x78), NULL);
@@ -309,6 +313,12 @@ val_pe_reg_write(uint32_t reg_id, uint64_t write_data)
       case PMBLIMITR_EL1:
           AA64WritePmblimitr(write_data);
           break;
+      case TPIDR_ELx:
+          if (AA64ReadCurrentEL() == AARCH64_EL1)
+            AA64WriteTpidr1(write_data);
+          else
+            AA64WriteTpidr2(write_data);
+          break;
       default:
            val_report_status(val_pe_get_index_mpid(val_pe_get_mpid()),
                              RESULT_FAIL(g_sbsa_level, 0, 0x78), NULL);
@@ -18,6 +18,7 @@
 #include "include/sbsa_avs_val.h"
 #include "include/sbsa_avs_pe.h"
 #include "include/sbsa_avs_common.h"
+#include "include/sbsa_avs_memory.h"
 #include "include/sbsa_std_smc.h"
 #include "sys_arch_src/gic/sbsa_exception.h"
 
@@ -38,6 +39,90 @@ CACHE_INFO_TABLE *g_cache_info_table;
 **/
 ARM_SMC_ARGS g_smc_args;
 
+/**
+  @brief   MPIDR -> PE index lookup. The key packs the affinity bits that vary
+           between the PEs of the system, width[n] low bits of each Aff<n>.
+**/
+static struct {
+  uint16_t *table;              /* PE info table position, or PE_MPIDR_INDEX_INVALID */
+  uint32_t width[4];
+} g_pe_mpidr_index;
+
+static const uint32_t g_pe_aff_shift[4] = {0, 8, 16, 32};
+
+/**
+  @brief   Pack the varying affinity bits of an MPIDR into a table key
+  @param   mpid  MPIDR affinity bits
+  @return  table key
+**/
+static uint32_t
+pe_mpidr_key(uint64_t mpid)
+{
+  uint32_t level, pos = 0, key = 0;
+
+  for (level = 0; level < 4; level++) {
+      key |= (uint32_t)((mpid >> g_pe_aff_shift[level]) &
+                        ((1u << g_pe_mpidr_index.width[level]) - 1)) << pos;
+      pos += g_pe_mpidr_index.width[level];
+  }
+
+  return key;
+}
+
+/**
+  @brief   Build the MPIDR -> PE index table from the PE info table. Affinity
+           values are usually small and dense, so a handful of low bits from
+           each level tell all the PEs apart.
+  @param   None
+  @return  None
+**/
+static void
+pe_mpidr_index_build(void)
+{
+  PE_INFO_ENTRY *entry = g_pe_info_table->pe_info;
+  uint32_t num_pe = g_pe_info_table->header.num_of_pe;
+  uint32_t i, level, bits = 0;
+  uint64_t aff;
+  uint16_t *slot;
+
+  if (g_pe_mpidr_index.table)
+      val_memory_free(g_pe_mpidr_index.table);
+  g_pe_mpidr_index.table = NULL;
+
+  for (level = 0; level < 4; level++) {
+      aff = 0;
+      for (i = 0; i < num_pe; i++)
+          aff |= (entry[i].mpidr >> g_pe_aff_shift[level]) & 0xFF;
+
+      g_pe_mpidr_index.width[level] = 0;
+      while (aff >> g_pe_mpidr_index.width[level])
+          g_pe_mpidr_index.width[level]++;
+      bits += g_pe_mpidr_index.width[level];
+  }
+
+  if (bits > PE_MPIDR_INDEX_MAX_BITS || num_pe >= PE_MPIDR_INDEX_INVALID) {
+      val_print(AVS_PRINT_INFO, " PE_INFO: MPIDR index needs %d bits, using linear search\n",
+                bits);
+      return;
+  }
+
+  g_pe_mpidr_index.table = val_memory_alloc((1u << bits) * sizeof(uint16_t));
+  if (g_pe_mpidr_index.table == NULL)
+      return;
+  val_memory_set(g_pe_mpidr_index.table, (1u << bits) * sizeof(uint16_t), 0xFF);
+
+  /* The first PE with a given MPIDR wins, as with the linear search */
+  for (i = 0; i < num_pe; i++) {
+      slot = &g_pe_mpidr_index.table[pe_mpidr_key(entry[i].mpidr)];
+      if (*slot == PE_MPIDR_INDEX_INVALID)
+          *slot = i;
+  }
+
+  /* Secondary PEs look themselves up before their caches are enabled */
+  val_pe_cache_clean_range((uint64_t)g_pe_mpidr_index.table, (1u << bits) * sizeof(uint16_t));
+  val_pe_cache_clean_range((uint64_t)&g_pe_mpidr_index, sizeof(g_pe_mpidr_index));
+}
+
 
 /**
   @brief   This API will call PAL layer to fill in the PE information
@@ -80,6 +165,10 @@ val_pe_create_info_table(uint64_t *pe_info_table)
       val_print(AVS_PRINT_ERR, "\n *** CRITICAL ERROR: Num PE is 0x0 ***\n", 0);
       return AVS_STATUS_ERR;
   }
+
+  pe_mpidr_index_build();
+  val_pe_cache_index();
+
   return AVS_STATUS_PASS;
 }
 
@@ -93,6 +182,10 @@ val_pe_create_info_table(uint64_t *pe_info_table)
 void
 val_pe_free_info_table()
 {
+  if (g_pe_mpidr_index.table)
+      val_memory_free(g_pe_mpidr_index.table);
+  g_pe_mpidr_index.table = NULL;
+
   pal_mem_free((void *)g_pe_info_table);
 }
 
@@ -174,9 +267,26 @@ val_pe_get_index_mpid(uint64_t mpid)
 
   PE_INFO_ENTRY *entry;
   uint32_t i = g_pe_info_table->header.num_of_pe;
+  uint16_t pos;
+#ifndef TARGET_LINUX
+  uint64_t tpidr;
+
+  /* The running PE looking itself up, which is by far the most common case */
+  tpidr = val_pe_reg_read(TPIDR_ELx);
+  if ((tpidr & PE_TPIDR_VALID) &&
+      ((tpidr >> PE_TPIDR_MPID_SHIFT) & MPIDR_AFF_MASK) == mpid)
+      return tpidr & PE_TPIDR_INDEX_MASK;
+#endif
 
   entry = g_pe_info_table->pe_info;
 
+  if (g_pe_mpidr_index.table) {
+      pos = g_pe_mpidr_index.table[pe_mpidr_key(mpid)];
+      if (pos != PE_MPIDR_INDEX_INVALID && entry[pos].mpidr == mpid)
+          return entry[pos].pe_num;
+      return 0x0;
+  }
+
   while (i > 0) {
     if (entry->mpidr == mpid) {
       return entry->pe_num;
@@ -188,6 +298,33 @@ val_pe_get_index_mpid(uint64_t mpid)
   return 0x0;  //Return index 0 as a safe failsafe value
 }
 
+/**
+  @brief   Look up the index of the running PE and cache it in TPIDR_ELx, so
+           val_pe_get_index_mpid of the running PE needs no lookup.
+           1. Caller       -  VAL, on every PE before it runs test code
+           2. Prerequisite -  val_pe_create_info_table
+  @param   None
+  @return  Index of the running PE
+**/
+uint32_t
+val_pe_cache_index(void)
+{
+  uint64_t mpid = val_pe_get_mpid();
+  uint32_t index;
+
+#ifndef TARGET_LINUX
+  /* Drop a stale value first, so the lookup below does not return it */
+  val_pe_reg_write(TPIDR_ELx, 0);
+  index = val_pe_get_index_mpid(mpid);
+  val_pe_reg_write(TPIDR_ELx, PE_TPIDR_VALID | (mpid << PE_TPIDR_MPID_SHIFT) |
+                              (index & PE_TPIDR_INDEX_MASK));
+#else
+  index = val_pe_get_index_mpid(mpid);
+#endif
+
+  return index;
+}
+
 /**
   @brief   This API returns the index of the PE whose ACPI UID matches with the input UID
            1. Caller       -  Test Suite, VAL
@@ -243,9 +380,163 @@ val_pe_get_uid(uint64_t mpidr)
   return INVALID_PE_INFO;
 }
 
+#ifndef TARGET_LINUX
+/**
+  @brief   Hand over a command to a secondary PE parked in the worker pool.
+           The command is published by bumping the mailbox sequence number,
+           the caller releases the PE with an SEV.
+  @param   index - Index of the parked PE
+  @param   cmd   - PE_POOL_CMD_RUN or PE_POOL_CMD_OFF
+  @return  1 if the PE was parked and the command was posted, else 0
+**/
+static uint32_t
+val_pe_pool_post(uint32_t index, uint32_t cmd)
+{
+  volatile VAL_SHARED_CMD_t *mbox;
+  volatile VAL_SHARED_EVENT_t *evt;
+
+  mbox = val_get_shared_mem_cmd(index);
+  evt = val_get_shared_mem_event(index);
+
+  val_shared_mem_cache_ops(evt, sizeof(*evt), INVALIDATE);
+  if (!evt->parked)
+      return 0;
+
+  val_shared_mem_write_begin(mbox, sizeof(*mbox));
+  mbox->mbox_cmd = cmd;
+  mbox->mbox_seq = mbox->mbox_seq + 1;
+  val_shared_mem_write_end(mbox, sizeof(*mbox));
+
+  return 1;
+}
+
+/**
+  @brief   Park the calling secondary PE in a WFE loop until the primary PE
+           posts a new command in its mailbox.
+  @param   index - Index of the calling PE
+  @return  Command posted by the primary PE
+**/
+static uint32_t
+val_pe_pool_wait(uint32_t index)
+{
+  volatile VAL_SHARED_CMD_t *mbox;
+  volatile VAL_SHARED_EVENT_t *evt;
+  uint32_t seq;
+
+  mbox = val_get_shared_mem_cmd(index);
+  evt = val_get_shared_mem_event(index);
+
+  /* Snapshot the sequence number before advertising the PE as parked,
+     so that a command posted right after cannot be missed */
+  val_shared_mem_cache_ops(mbox, sizeof(*mbox), INVALIDATE);
+  seq = mbox->mbox_seq;
+
+  val_shared_mem_write_begin(evt, sizeof(*evt));
+  evt->parked = 1;
+  val_shared_mem_write_end(evt, sizeof(*evt));
+
+  while (1) {
+      val_shared_mem_cache_ops(mbox, sizeof(*mbox), INVALIDATE);
+      if (mbox->mbox_seq != seq)
+          break;
+      ArmCallWFE();
+  }
+
+  val_shared_mem_write_begin(evt, sizeof(*evt));
+  evt->parked = 0;
+  val_shared_mem_write_end(evt, sizeof(*evt));
+
+  return mbox->mbox_cmd;
+}
+#endif
+
+/**
+  @brief   This API hands the payload already published in the shared memory
+           slot of a secondary PE over to it, if the PE is parked in the worker
+           pool. The PE starts running only after val_pe_pool_signal.
+           1. Caller       -  VAL
+           2. Prerequisite -  val_set_test_data
+  @param   index - Index of the PE
+  @return  1 if the payload was handed over, 0 if the PE must be woken up with PSCI
+**/
+uint32_t
+val_pe_pool_handover(uint32_t index)
+{
+#ifndef TARGET_LINUX
+  if (g_pe_pool)
+      return val_pe_pool_post(index, PE_POOL_CMD_RUN);
+#endif
+  return 0;
+}
+
+/**
+  @brief   This API sends an event to release the PEs parked in the worker pool
+           after their mailboxes have been updated.
+           1. Caller       -  VAL
+           2. Prerequisite -  val_pe_pool_handover
+  @param   None
+  @return  None
+**/
+void
+val_pe_pool_signal(void)
+{
+#ifndef TARGET_LINUX
+  if (g_pe_pool)
+      ArmCallSEV();
+#endif
+}
+
+/**
+  @brief   This API switches off all the secondary PEs parked in the worker
+           pool. The next payload dispatched to them uses PSCI_CPU_ON again.
+           1. Caller       -  Application layer, Test Suite
+           2. Prerequisite -  val_allocate_shared_mem
+  @param   None
+  @return  None
+**/
+void
+val_pe_pool_release(void)
+{
+#ifndef TARGET_LINUX
+  volatile VAL_SHARED_EVENT_t *evt;
+  uint32_t i;
+  uint32_t num_pe = val_pe_get_num();
+  uint32_t released = 0;
+  VAL_TIMEOUT_t timeout;
+
+  if (!g_pe_pool || (val_get_shared_mem_cmd(0) == NULL))
+      return;
+
+  for (i = 0; i < num_pe; i++)
+      released += val_pe_pool_post(i, PE_POOL_CMD_OFF);
+
+  if (!released)
+      return;
+
+  ArmCallSEV();
+
+  /* Wait for the PEs to leave the pool before the mailboxes can be reused */
+  val_timeout_start(&timeout, TIMEOUT_US_LARGE);
+  for (i = 0; i < num_pe; i++) {
+      evt = val_get_shared_mem_event(i);
+      do {
+          val_shared_mem_cache_ops(evt, sizeof(*evt), INVALIDATE);
+      } while (evt->parked && !val_timeout_expired(&timeout));
+
+      if (evt->parked)
+          val_print(AVS_PRINT_WARN, "\n       PE %d did not leave the worker pool", i);
+  }
+
+  val_print(AVS_PRINT_INFO, "\n       Released %d PEs from the worker pool", released);
+#endif
+}
+
 /**
   @brief   'C' Entry point for Secondary PE.
            Uses PSCI_CPU_OFF to switch off PE after payload execution.
+           When the worker pool is enabled the PE parks in a WFE loop
+           instead and runs every payload handed over through its mailbox,
+           PSCI_CPU_OFF is then only called on val_pe_pool_release.
            1. Caller       -  PAL code
            2. Prerequisite -  Stack pointer for this PE is setup by PAL
   @param   None
@@ -257,9 +548,20 @@ val_test_entry(void)
   uint64_t test_arg;
   ARM_SMC_ARGS smc_args;
   void (*vector)(uint64_t args);
+  uint32_t index = val_pe_cache_index();
 
-  val_get_test_data(val_pe_get_index_mpid(val_pe_get_mpid()), (uint64_t *)&vector, &test_arg);
-  vector(test_arg);
+  while (1) {
+      val_get_test_data(index, (uint64_t *)&vector, &test_arg);
+      val_set_test_event(index, PE_DISPATCH_WAKE);
+      vector(test_arg);
+      val_set_test_event(index, PE_DISPATCH_DONE);
+
+#ifndef TARGET_LINUX
+      if (g_pe_pool && (val_pe_pool_wait(index) == PE_POOL_CMD_RUN))
+          continue;
+#endif
+      break;
+  }
 
   // We have completed our TEST code. So, switch off the PE now
   smc_args.Arg0 = ARM_SMC_ID_PSCI_CPU_OFF;
@@ -269,50 +571,77 @@ val_test_entry(void)
 
 
 /**
-  @brief   This API initiates the execution of a test on a secondary PE.
-           Uses PSCI_CPU_ON to wake a secondary PE
-           1. Caller       -  Test Suite
-           2. Prerequisite -  val_create_peinfo_table
+  @brief   This API wakes a secondary PE with PSCI_CPU_ON. The PE picks up the
+           payload which has already been published in its shared memory slot.
+           If the PE is parked in the worker pool, the payload is handed over
+           through its mailbox instead.
+           1. Caller       -  VAL
+           2. Prerequisite -  val_set_test_data
   @param   index - Index of the PE to be woken up
-  @param   payload - Function pointer of the test to be executed on the PE
-  @param   test_input - arguments to be passed to the test.
-  @return  None
+  @return  0 on success, else PSCI error code returned by the firmware
 **/
-void
-val_execute_on_pe(uint32_t index, void (*payload)(void), uint64_t test_input)
+uint32_t
+val_pe_cpu_on(uint32_t index)
 {
 
-  int timeout = TIMEOUT_LARGE;
-  if (index > g_pe_info_table->header.num_of_pe) {
-      val_print(AVS_PRINT_ERR, "Input Index exceeds Num of PE %x \n", index);
-      val_report_status(index, RESULT_FAIL(g_sbsa_level, 0, 0xFF), NULL);
-      return;
-  }
+  VAL_TIMEOUT_t timeout;
 
+  val_timeout_start(&timeout, TIMEOUT_US_LARGE);
   do {
-      g_smc_args.Arg0 = ARM_SMC_ID_PSCI_CPU_ON_AARCH64;
+      /* A pool PE still finishing its previous payload reports ALREADY_ON
+         until it parks, so keep checking the mailbox while retrying */
+      if (val_pe_pool_handover(index)) {
+          val_pe_pool_signal();
+          return 0;
+      }
 
-      /* Set the TEST function pointer in a shared memory location. This location is
-         read by the Secondary PE (val_test_entry()) and executes the test. */
+      g_smc_args.Arg0 = ARM_SMC_ID_PSCI_CPU_ON_AARCH64;
       g_smc_args.Arg1 = val_pe_get_mpid_index(index);
-
-      val_set_test_data(index, (uint64_t)payload, test_input);
+      val_test_profile_count(PROFILE_PSCI);
       pal_pe_execute_payload(&g_smc_args);
 
-  } while (g_smc_args.Arg0 == (uint64_t)ARM_SMC_PSCI_RET_ALREADY_ON && timeout--);
+  } while (g_smc_args.Arg0 == (uint64_t)ARM_SMC_PSCI_RET_ALREADY_ON &&
+           !val_timeout_expired(&timeout));
 
   if (g_smc_args.Arg0 == (uint64_t)ARM_SMC_PSCI_RET_ALREADY_ON)
       val_print(AVS_PRINT_ERR, "\n       PSCI_CPU_ON: cpu already on  ", 0);
   else {
       if(g_smc_args.Arg0 == 0) {
           val_print(AVS_PRINT_INFO, "\n       PSCI_CPU_ON: success  ", 0);
-          return;
+          return 0;
       }
       else
           val_print(AVS_PRINT_ERR, "\n       PSCI_CPU_ON: failure  ", 0);
 
   }
   val_set_status(index, RESULT_FAIL(g_sbsa_level, 0, 0x120 - (int)g_smc_args.Arg0));
+  return (uint32_t)g_smc_args.Arg0;
+}
+
+/**
+  @brief   This API initiates the execution of a test on a secondary PE.
+           Uses PSCI_CPU_ON to wake a secondary PE
+           1. Caller       -  Test Suite
+           2. Prerequisite -  val_create_peinfo_table
+  @param   index - Index of the PE to be woken up
+  @param   payload - Function pointer of the test to be executed on the PE
+  @param   test_input - arguments to be passed to the test.
+  @return  None
+**/
+void
+val_execute_on_pe(uint32_t index, void (*payload)(void), uint64_t test_input)
+{
+
+  if (index > g_pe_info_table->header.num_of_pe) {
+      val_print(AVS_PRINT_ERR, "Input Index exceeds Num of PE %x \n", index);
+      val_report_status(index, RESULT_FAIL(g_sbsa_level, 0, 0xFF), NULL);
+      return;
+  }
+
+  /* Set the TEST function pointer in a shared memory location. This location is
+     read by the Secondary PE (val_test_entry()) and executes the test. */
+  val_set_test_data(index, (uint64_t)payload, test_input);
+  val_pe_cpu_on(index);
 }
 
 /**
@@ -410,6 +739,9 @@ val_pe_default_esr(uint64_t interrupt_type, void *context)
         val_print(AVS_PRINT_WARN, "\n        FAR reported = 0x%llx", val_pe_get_far(context));
         val_print(AVS_PRINT_WARN, "\n        ESR reported = 0x%llx", val_pe_get_esr(context));
     }
+
+    /* Keep the log up to date in case the test does not recover */
+    val_log_flush();
 #endif
     val_set_status(index, RESULT_FAIL(g_sbsa_level, 0, 01));
     val_pe_update_elr(context, g_exception_ret_addr);
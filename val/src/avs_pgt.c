@@ -29,6 +29,46 @@ static uint32_t page_size;
 static uint32_t bits_per_level;
 static uint64_t pgt_addr_mask;
 
+/* Translation table pages of one table hierarchy, carved linearly out of a
+ * single pre-zeroed allocation and released together by val_pgt_destroy.
+ */
+typedef struct
+{
+    uint64_t root_phys;     /* pgt_base of the hierarchy, 0 for a free slot */
+    uint8_t  *base;
+    void     *base_phys;
+    uint32_t num_pages;
+    uint32_t next_page;
+    uint32_t attr;
+} pgt_arena_t;
+
+static pgt_arena_t g_pgt_arena[PGT_ARENA_MAX];
+static pgt_arena_t *g_pgt_arena_cur;
+
+/* Tables being written are cleaned to the PoC for walkers that do not snoop the PE caches */
+static uint32_t g_pgt_clean;
+
+/* Tables and descriptors written by the last val_pgt_create, printed at debug level */
+typedef struct
+{
+    uint32_t table_pages;                   /* Translation table pages allocated */
+    uint32_t leaf_entries[PGT_LEVEL_MAX];   /* Block descriptors per level, pages at level 3 */
+    uint32_t contig_runs;                   /* Entry groups with the contiguous hint set */
+} pgt_footprint_t;
+
+static pgt_footprint_t g_pgt_footprint;
+
+/* Leaf descriptors of recent table walks, direct mapped on the VA page */
+typedef struct
+{
+    uint64_t tt_base;       /* Root table of the walk, 0 for an empty entry */
+    uint64_t va_page;
+    uint64_t desc;
+    uint32_t level;
+} pgt_walk_cache_entry_t;
+
+static pgt_walk_cache_entry_t g_pgt_walk_cache[PGT_WALK_CACHE_SIZE];
+
 typedef struct
 {
     uint64_t *tt_base;
@@ -38,12 +78,218 @@ typedef struct
     uint32_t level;
     uint32_t size_log2;
     uint32_t nbits;
+    uint32_t live;          /* Table of a hierarchy that may already be walked */
 } tt_descriptor_t;
 
+static uint32_t pgt_arena_contains(pgt_arena_t *arena, void *page)
+{
+    return arena != NULL && (uint8_t *)page >= arena->base &&
+           (uint8_t *)page < arena->base + (uint64_t)arena->num_pages * page_size;
+}
+
+static pgt_arena_t *pgt_arena_find(uint64_t root_phys)
+{
+    uint32_t i;
+
+    for (i = 0; i < PGT_ARENA_MAX; i++) {
+        if (g_pgt_arena[i].root_phys != 0 && g_pgt_arena[i].root_phys == root_phys)
+            return &g_pgt_arena[i];
+    }
+
+    return NULL;
+}
+
+/**
+  @brief Allocate a zeroed arena large enough for num_pages translation tables.
+  @param num_pages - number of table pages
+  @param attr - PGT_ARENA_NORMAL or PGT_ARENA_CACHEABLE
+  @return arena, NULL if no slot or memory is available
+**/
+static pgt_arena_t *pgt_arena_alloc(uint32_t num_pages, uint32_t attr)
+{
+    pgt_arena_t *arena = NULL;
+    uint32_t i;
+
+    for (i = 0; i < PGT_ARENA_MAX; i++) {
+        if (g_pgt_arena[i].base == NULL) {
+            arena = &g_pgt_arena[i];
+            break;
+        }
+    }
+
+    if (arena == NULL)
+        return NULL;
+
+    /* Cacheable memory for a walker which snoops the PE caches. Fall back to
+       plain pages, cleaned as tables are written, when the PAL has none. */
+    if (attr == PGT_ARENA_CACHEABLE)
+        arena->base = val_memory_alloc_cacheable(0, num_pages * page_size, &arena->base_phys);
+
+    if (arena->base == NULL) {
+        attr = PGT_ARENA_NORMAL;
+        arena->base = val_memory_alloc_pages(num_pages);
+        if (arena->base == NULL)
+            return NULL;
+    }
+
+    val_memory_set(arena->base, num_pages * page_size, 0);
+    arena->num_pages = num_pages;
+    arena->next_page = 0;
+    arena->attr = attr;
+    return arena;
+}
+
+static void pgt_arena_free(pgt_arena_t *arena)
+{
+    if (arena->attr == PGT_ARENA_CACHEABLE)
+        val_memory_free_cacheable(0, arena->num_pages * page_size, arena->base, arena->base_phys);
+    else
+        val_memory_free_pages(arena->base, arena->num_pages);
+
+    val_memory_set(arena, sizeof(pgt_arena_t), 0);
+}
+
+/* Next table page from the current arena, a separate zeroed page once it is used up */
+static uint64_t *pgt_alloc_page(void)
+{
+    uint64_t *page;
+
+    g_pgt_footprint.table_pages++;
+    if (g_pgt_arena_cur != NULL && g_pgt_arena_cur->next_page < g_pgt_arena_cur->num_pages)
+        return (uint64_t *)(g_pgt_arena_cur->base +
+                            (uint64_t)(g_pgt_arena_cur->next_page++) * page_size);
+
+    page = val_memory_alloc_pages(1);
+    if (page != NULL)
+        val_memory_set(page, page_size, 0);
+    return page;
+}
+
+static void pgt_free_page(pgt_arena_t *arena, void *page)
+{
+    /* Arena pages are released with the whole arena */
+    if (!pgt_arena_contains(arena, page))
+        val_memory_free_pages(page, 1);
+}
+
+/* Number of adjacent entries the contiguous hint spans at a level, 0 if unsupported */
+static uint32_t pgt_contig_entries(uint32_t level)
+{
+    switch (bits_per_level + 3) {
+    case 12:
+        return (level >= 1) ? 16 : 0;
+    case 14:
+        return (level == 3) ? 128 : ((level == 2) ? 32 : 0);
+    case 16:
+        return (level >= 2) ? 32 : 0;
+    default:
+        return 0;
+    }
+}
+
+/* Block descriptors are only legal from level 1 with 4KB granule, level 2 otherwise */
+static uint32_t pgt_block_allowed(uint32_t level)
+{
+    return (bits_per_level + 3 == 12) ? (level >= 1) : (level >= 2);
+}
+
+/* Upper bound of the table pages needed to map mem_desc in a new hierarchy, root
+   included. A table is needed below every entry the region spans at the level
+   above, except the entries fill_translation_table maps with a block: when the
+   input and output addresses are equally aligned for the block size, only the
+   partly covered entries at either end of the region get a table. */
+static uint64_t pgt_arena_estimate(memory_region_descriptor_t *mem_desc, uint32_t num_pgt_levels,
+                                   uint32_t page_size_log2)
+{
+    uint64_t pages = 1;
+    uint64_t first, last, entry_mask;
+    uint32_t depth, level, entry_log2, partial;
+
+    for (; mem_desc->length != 0; ++mem_desc) {
+        for (depth = 1; depth < num_pgt_levels; depth++) {
+            /* Entries of the level above the tables of this depth */
+            level = 4 - num_pgt_levels + depth - 1;
+            entry_log2 = (num_pgt_levels - depth) * bits_per_level + page_size_log2;
+            entry_mask = (0x1ull << entry_log2) - 1;
+            first = mem_desc->virtual_address >> entry_log2;
+            last = (mem_desc->virtual_address + mem_desc->length - 1) >> entry_log2;
+
+            if (pgt_block_allowed(level) &&
+                ((mem_desc->virtual_address ^ mem_desc->physical_address) & entry_mask) == 0) {
+                partial = ((mem_desc->virtual_address & entry_mask) != 0) +
+                          (((mem_desc->virtual_address + mem_desc->length) & entry_mask) != 0);
+                pages += (first == last && partial) ? 1 : partial;
+            } else
+                pages += last - first + 1;
+        }
+    }
+
+    return pages;
+}
+
+/**
+  @brief Set the contiguous hint on every naturally aligned group of entries in
+         [first_index, last_index] whose leaf descriptors map one contiguous, equally
+         aligned output range with the same attributes, and clear it elsewhere so
+         that updates never leave a stale hint behind.
+         Live tables are left alone: changing the hint of entries a walker may
+         already use would need break-before-make and TLB maintenance.
+**/
+static void pgt_update_contig(tt_descriptor_t *tt_desc, uint64_t first_index, uint64_t last_index)
+{
+    uint32_t num = pgt_contig_entries(tt_desc->level);
+    uint64_t group, i, desc, *entry;
+    uint32_t contig;
+
+    if (tt_desc->live || num == 0 || num > (0x1ull << tt_desc->nbits))
+        return;
+
+    for (group = first_index & ~(uint64_t)(num - 1); group <= last_index; group += num)
+    {
+        entry = &tt_desc->tt_base[group];
+        desc = entry[0] & ~PGT_ENTRY_CONTIG_MASK;
+
+        contig = (tt_desc->level == 3) ? IS_PGT_ENTRY_PAGE(desc) : IS_PGT_ENTRY_BLOCK(desc);
+        contig = contig && ((desc >> tt_desc->size_log2) & (num - 1)) == 0;
+        for (i = 1; contig && i < num; i++)
+            contig = (entry[i] & ~PGT_ENTRY_CONTIG_MASK) == desc + (i << tt_desc->size_log2);
+
+        for (i = 0; i < num; i++)
+            entry[i] = contig ? (entry[i] | PGT_ENTRY_CONTIG_MASK) :
+                                (entry[i] & ~PGT_ENTRY_CONTIG_MASK);
+        if (contig)
+            g_pgt_footprint.contig_runs++;
+    }
+}
+
+/* Fill a table replacing a block descriptor with the same mapping, so that the part
+   of the block outside the new region stays mapped */
+static void pgt_split_block(tt_descriptor_t *tt_desc, uint64_t block_desc)
+{
+    uint64_t attributes = PGT_DESC_ATTRIBUTES(block_desc) & ~PGT_ENTRY_CONTIG_MASK;
+    uint64_t output_address = block_desc & ~(PGT_DESC_ATTRIBUTES_MASK | PGT_ENTRY_TYPE_MASK);
+    uint64_t type = (tt_desc->level == 3) ? PGT_ENTRY_PAGE_MASK : PGT_ENTRY_BLOCK_MASK;
+    uint64_t index, num = 0x1ull << tt_desc->nbits;
+
+    for (index = 0; index < num; index++)
+        tt_desc->tt_base[index] = (output_address + (index << tt_desc->size_log2)) | attributes |
+                                  type | PGT_ENTRY_VALID_MASK;
+
+    pgt_update_contig(tt_desc, 0, num - 1);
+}
+
+/**
+  @brief Map [input_base, input_top] in one translation table. Every entry is filled
+         with the largest descriptor allowed: a block when the entry range is covered
+         and both addresses are aligned to it, a next level table otherwise.
+**/
 uint32_t fill_translation_table(tt_descriptor_t tt_desc, memory_region_descriptor_t *mem_desc)
 {
     uint64_t block_size = 0x1ull << tt_desc.size_log2;
-    uint64_t input_address, output_address, table_index, *tt_base_next_level, *table_desc;
+    uint64_t attributes = mem_desc->attributes & ~PGT_ENTRY_CONTIG_MASK;
+    uint64_t input_address, input_next, output_address, table_index, *tt_base_next_level, *table_desc;
+    uint64_t first_index, last_index;
+    uint32_t new_table;
     tt_descriptor_t tt_desc_next_level;
 
     val_print(PGT_DEBUG_LEVEL, "\n      tt_desc.level: %d     ", tt_desc.level);
@@ -53,12 +299,18 @@ uint32_t fill_translation_table(tt_descriptor_t tt_desc, memory_region_descripto
     val_print(PGT_DEBUG_LEVEL, "\n      tt_desc.size_log2: %d     ", tt_desc.size_log2);
     val_print(PGT_DEBUG_LEVEL, "\n      tt_desc.nbits: %d     ", tt_desc.nbits);
 
-    for (input_address = tt_desc.input_base, output_address = tt_desc.output_base;
-         input_address < tt_desc.input_top;
-         input_address += block_size, output_address += block_size)
+    first_index = tt_desc.input_base >> tt_desc.size_log2 & ((0x1ull << tt_desc.nbits) - 1);
+    last_index = first_index;
+
+    for (input_address = tt_desc.input_base, output_address = tt_desc.output_base; ;
+         output_address += input_next - input_address, input_address = input_next)
     {
+        /* Entries are walked on their own boundaries, so an unaligned region start
+           only shortens the first entry */
+        input_next = (input_address | (block_size - 1)) + 1;
         table_index = input_address >> tt_desc.size_log2 & ((0x1ull << tt_desc.nbits) - 1);
         table_desc = &tt_desc.tt_base[table_index];
+        last_index = table_index;
 
         val_print(PGT_DEBUG_LEVEL, "\n      table_index = %d     ", table_index);
 
@@ -67,59 +319,75 @@ uint32_t fill_translation_table(tt_descriptor_t tt_desc, memory_region_descripto
             //Create level 3 page descriptor entry
             *table_desc = PGT_ENTRY_PAGE_MASK | PGT_ENTRY_VALID_MASK;
             *table_desc |= (output_address & ~(uint64_t)(page_size - 1));
-            *table_desc |= mem_desc->attributes;
+            *table_desc |= attributes;
+            g_pgt_footprint.leaf_entries[3]++;
             val_print(PGT_DEBUG_LEVEL, "\n      page_descriptor = 0x%llx     ", *table_desc);
-            continue;
         }
-
         //Are input and output addresses eligible for being described via block descriptor?
-        if ((input_address & (block_size - 1)) == 0 &&
-             (output_address & (block_size - 1)) == 0 &&
-             tt_desc.input_top >= (input_address + block_size - 1)) {
+        else if (pgt_block_allowed(tt_desc.level) &&
+                 (input_address & (block_size - 1)) == 0 &&
+                 (output_address & (block_size - 1)) == 0 &&
+                 tt_desc.input_top >= (input_next - 1))
+        {
             //Create a block descriptor entry
             *table_desc = PGT_ENTRY_BLOCK_MASK | PGT_ENTRY_VALID_MASK;
             *table_desc |= (output_address & ~(block_size - 1));
-            *table_desc |= mem_desc->attributes;
+            *table_desc |= attributes;
+            g_pgt_footprint.leaf_entries[tt_desc.level]++;
             val_print(PGT_DEBUG_LEVEL, "\n      block_descriptor = 0x%llx     ", *table_desc);
-            continue;
         }
-        /*
-        If there's no descriptor populated at current index of this page_table, or
-        If there's a block descriptor, allocate new page, else use the already populated address.
-        Block descriptor info will be overwritten in case its there.
-        */
-        if (*table_desc == 0 || IS_PGT_ENTRY_BLOCK(*table_desc))
+        else
         {
-            tt_base_next_level = val_memory_alloc_pages(1);
-            if (tt_base_next_level == NULL)
+            /*
+            If there's no descriptor populated at current index of this page_table, or
+            If there's a block descriptor, allocate new page, else use the already populated
+            address. A block descriptor is carried over into the new table.
+            */
+            new_table = (*table_desc == 0 || IS_PGT_ENTRY_BLOCK(*table_desc));
+            if (new_table)
+            {
+                tt_base_next_level = pgt_alloc_page();
+                if (tt_base_next_level == NULL)
+                {
+                    val_print(AVS_PRINT_ERR, "\n      fill_translation_table: page allocation failed     ", 0);
+                    return AVS_STATUS_ERR;
+                }
+            }
+            else
+                tt_base_next_level = val_memory_phys_to_virt(*table_desc & pgt_addr_mask);
+
+            tt_desc_next_level.tt_base = tt_base_next_level;
+            tt_desc_next_level.input_base = input_address;
+            tt_desc_next_level.input_top = get_min(tt_desc.input_top, (input_next - 1));
+            tt_desc_next_level.output_base = output_address;
+            tt_desc_next_level.level = tt_desc.level + 1;
+            tt_desc_next_level.size_log2 = tt_desc.size_log2 - bits_per_level;
+            tt_desc_next_level.nbits = bits_per_level;
+            tt_desc_next_level.live = tt_desc.live && !new_table;
+
+            if (new_table && IS_PGT_ENTRY_BLOCK(*table_desc))
+                pgt_split_block(&tt_desc_next_level, *table_desc);
+
+            if (fill_translation_table(tt_desc_next_level, mem_desc))
             {
-                val_print(AVS_PRINT_ERR, "\n      fill_translation_table: page allocation failed     ", 0);
+                if (new_table)
+                    pgt_free_page(g_pgt_arena_cur, tt_base_next_level);
                 return AVS_STATUS_ERR;
             }
-            val_memory_set(tt_base_next_level, page_size, 0);
-        }
-        else
-            tt_base_next_level = val_memory_phys_to_virt(*table_desc & pgt_addr_mask);
 
-        tt_desc_next_level.tt_base = tt_base_next_level;
-        tt_desc_next_level.input_base = input_address;
-        tt_desc_next_level.input_top = get_min(tt_desc.input_top, (input_address + block_size - 1));
-        tt_desc_next_level.output_base = output_address;
-        tt_desc_next_level.level = tt_desc.level + 1;
-        tt_desc_next_level.size_log2 = tt_desc.size_log2 - bits_per_level;
-        tt_desc_next_level.nbits = bits_per_level;
-
-        if (fill_translation_table(tt_desc_next_level, mem_desc))
-        {
-            val_memory_free_pages(tt_base_next_level, 1);
-            return AVS_STATUS_ERR;
+            *table_desc = PGT_ENTRY_TABLE_MASK | PGT_ENTRY_VALID_MASK;
+            *table_desc |= (uint64_t)val_memory_virt_to_phys(tt_base_next_level) &
+                           ~(uint64_t)(page_size - 1);
+            val_print(PGT_DEBUG_LEVEL, "\n      table_descriptor = 0x%llx     ", *table_desc);
         }
 
-        *table_desc = PGT_ENTRY_TABLE_MASK | PGT_ENTRY_VALID_MASK;
-        *table_desc |= (uint64_t)val_memory_virt_to_phys(tt_base_next_level) &
-                       ~(uint64_t)(page_size - 1);
-        val_print(PGT_DEBUG_LEVEL, "\n      table_descriptor = 0x%llx     ", *table_desc);
+        if (input_next - 1 >= tt_desc.input_top)
+            break;
     }
+
+    pgt_update_contig(&tt_desc, first_index, last_index);
+    if (g_pgt_clean)
+        val_data_cache_ops_by_range((addr_t)tt_desc.tt_base, page_size, CLEAN);
     return 0;
 }
 
@@ -145,10 +413,31 @@ uint32_t log2_page_size(uint64_t size)
   @return status
 **/
 uint32_t val_pgt_create(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *pgt_desc)
+{
+    return val_pgt_create_in_arena(mem_desc, pgt_desc, PGT_ARENA_NORMAL);
+}
+
+/**
+  @brief Same as val_pgt_create, a new table hierarchy is carved out of one
+         pre-zeroed arena sized for mem_desc, that val_pgt_destroy frees at once.
+         The arena holds at most PGT_ARENA_MAX_PAGES tables, tables beyond it and
+         those added by later updates of the hierarchy once it is used up are
+         single pages.
+  @param mem_desc - Array of memory addresses and attributes needed for page table creation.
+  @param pgt_desc - Data structure for output page table base and input translation attributes.
+  @param arena_attr - PGT_ARENA_CACHEABLE only when the table walker snoops the PE caches,
+                      e.g. an SMMU with SMMU_IDR0.COHACC set: the tables then need no cache
+                      maintenance. PGT_ARENA_NORMAL otherwise: tables are cleaned to the
+                      PoC as they are written.
+  @return status
+**/
+uint32_t val_pgt_create_in_arena(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *pgt_desc,
+                                 uint32_t arena_attr)
 {
     uint64_t *tt_base;
     tt_descriptor_t tt_desc;
     uint32_t num_pgt_levels, page_size_log2;
+    uint64_t num_pages;
     memory_region_descriptor_t *mem_desc_iter;
 
     page_size = val_memory_page_size();
@@ -162,42 +451,52 @@ uint32_t val_pgt_create(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *
     /* check whether input page descriptor has base addr of translation table
        to use. If the pgt_base member is NULL allocate a page to create a new
        table, else update existing translation table */
+    val_memory_set(&g_pgt_footprint, sizeof(g_pgt_footprint), 0);
+    val_pgt_walk_cache_invalidate();
     if (pgt_desc->pgt_base == (uint64_t) NULL) {
-        tt_base = (uint64_t *) val_memory_alloc_pages(1);
+        /* Tables beyond a full arena are allocated one page at a time */
+        num_pages = pgt_arena_estimate(mem_desc, num_pgt_levels, page_size_log2);
+        if (num_pages > PGT_ARENA_MAX_PAGES)
+            num_pages = PGT_ARENA_MAX_PAGES;
+        g_pgt_arena_cur = pgt_arena_alloc((uint32_t)num_pages, arena_attr);
+        g_pgt_clean = (g_pgt_arena_cur == NULL || g_pgt_arena_cur->attr != PGT_ARENA_CACHEABLE);
+        tt_base = pgt_alloc_page();
         if (tt_base == NULL) {
             val_print(AVS_PRINT_ERR, "\n      val_pgt_create: page allocation failed     ", 0);
             return AVS_STATUS_ERR;
         }
-        val_memory_set(tt_base, page_size, 0);
     }
-    else
+    else {
         tt_base = (uint64_t *) pgt_desc->pgt_base;
+        g_pgt_arena_cur = pgt_arena_find(pgt_desc->pgt_base);
+        g_pgt_clean = (g_pgt_arena_cur == NULL || g_pgt_arena_cur->attr != PGT_ARENA_CACHEABLE);
+    }
 
     tt_desc.tt_base = tt_base;
     pgt_addr_mask = ((0x1ull << (pgt_desc->ias - page_size_log2)) - 1) << page_size_log2;
 
     for (mem_desc_iter = mem_desc; mem_desc_iter->length != 0; ++mem_desc_iter)
     {
-        val_print(PGT_DEBUG_LEVEL, "val_pgt_create:i/p addr = 0x%llx ", mem_desc->virtual_address);
-        val_print(PGT_DEBUG_LEVEL, "val_pgt_create:o/p addr = 0x%llx ", mem_desc->physical_address);
-        val_print(PGT_DEBUG_LEVEL, "val_pgt_create: length = 0x%llx\n ", mem_desc->length);
-        if ((mem_desc->virtual_address & (uint64_t)(page_size - 1)) != 0 ||
-            (mem_desc->physical_address & (uint64_t)(page_size - 1)) != 0)
+        val_print(PGT_DEBUG_LEVEL, "val_pgt_create:i/p addr = 0x%llx ", mem_desc_iter->virtual_address);
+        val_print(PGT_DEBUG_LEVEL, "val_pgt_create:o/p addr = 0x%llx ", mem_desc_iter->physical_address);
+        val_print(PGT_DEBUG_LEVEL, "val_pgt_create: length = 0x%llx\n ", mem_desc_iter->length);
+        if ((mem_desc_iter->virtual_address & (uint64_t)(page_size - 1)) != 0 ||
+            (mem_desc_iter->physical_address & (uint64_t)(page_size - 1)) != 0)
             {
                 val_print(AVS_PRINT_ERR, "\n      val_pgt_create: address alignment error     ", 0);
                 return AVS_STATUS_ERR;
             }
 
-        if (mem_desc->physical_address >= (0x1ull << pgt_desc->oas))
+        if (mem_desc_iter->physical_address >= (0x1ull << pgt_desc->oas))
         {
             val_print(AVS_PRINT_ERR, "\n      val_pgt_create: output address size error     ", 0);
             return AVS_STATUS_ERR;
         }
 
-        if (mem_desc->virtual_address >= (0x1ull << pgt_desc->ias))
+        if (mem_desc_iter->virtual_address >= (0x1ull << pgt_desc->ias))
         {
             val_print(AVS_PRINT_WARN, "\n      val_pgt_create: input address size error, truncating to %d-bits     ", pgt_desc->ias);
-            mem_desc->virtual_address &= ((0x1ull << pgt_desc->ias) - 1);
+            mem_desc_iter->virtual_address &= ((0x1ull << pgt_desc->ias) - 1);
         }
 
         if ((pgt_desc->tcr.tg_size_log2) != page_size_log2)
@@ -206,25 +505,125 @@ uint32_t val_pgt_create(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *
             return AVS_STATUS_ERR;
         }
 
-        tt_desc.input_base = mem_desc->virtual_address & ((0x1ull << pgt_desc->ias) - 1);
-        tt_desc.input_top = tt_desc.input_base + mem_desc->length - 1;
-        tt_desc.output_base = mem_desc->physical_address & ((0x1ull << pgt_desc->oas) - 1);
+        tt_desc.input_base = mem_desc_iter->virtual_address & ((0x1ull << pgt_desc->ias) - 1);
+        tt_desc.input_top = tt_desc.input_base + mem_desc_iter->length - 1;
+        tt_desc.output_base = mem_desc_iter->physical_address & ((0x1ull << pgt_desc->oas) - 1);
         tt_desc.level = 4 - num_pgt_levels;
         tt_desc.size_log2 = (num_pgt_levels - 1) * bits_per_level + page_size_log2;
         tt_desc.nbits = pgt_desc->ias - tt_desc.size_log2;
+        /* An existing hierarchy, such as the one in TTBR0, may be in use */
+        tt_desc.live = (pgt_desc->pgt_base != (uint64_t) NULL);
 
-        if (fill_translation_table(tt_desc, mem_desc))
+        if (fill_translation_table(tt_desc, mem_desc_iter))
         {
-            val_memory_free_pages(tt_base, 1);
+            if (pgt_desc->pgt_base == (uint64_t) NULL) {
+                if (g_pgt_arena_cur != NULL)
+                    pgt_arena_free(g_pgt_arena_cur);
+                else
+                    val_memory_free_pages(tt_base, 1);
+            }
+            g_pgt_arena_cur = NULL;
             return AVS_STATUS_ERR;
         }
     }
 
     pgt_desc->pgt_base = (uint64_t)val_memory_virt_to_phys(tt_base);
+    if (g_pgt_arena_cur != NULL) {
+        g_pgt_arena_cur->root_phys = pgt_desc->pgt_base;
+        val_print(PGT_DEBUG_LEVEL, "\n      val_pgt_create: arena pages used = %d     ",
+                  g_pgt_arena_cur->next_page);
+    }
+    g_pgt_arena_cur = NULL;
+
+    val_print(AVS_PRINT_DEBUG, "\n      val_pgt_create: table pages = %d",
+              g_pgt_footprint.table_pages);
+    val_print(AVS_PRINT_DEBUG, ", L1 blocks = %d", g_pgt_footprint.leaf_entries[1]);
+    val_print(AVS_PRINT_DEBUG, ", L2 blocks = %d", g_pgt_footprint.leaf_entries[2]);
+    val_print(AVS_PRINT_DEBUG, ", pages = %d", g_pgt_footprint.leaf_entries[3]);
+    val_print(AVS_PRINT_DEBUG, ", contiguous runs = %d     ", g_pgt_footprint.contig_runs);
 
     return 0;
 }
 
+/**
+  @brief Drop every translation cached by val_pgt_walk. Called whenever translation
+         tables or memory attributes may have changed.
+  @return void
+**/
+void val_pgt_walk_cache_invalidate(void)
+{
+    val_memory_set(g_pgt_walk_cache, sizeof(g_pgt_walk_cache), 0);
+}
+
+/**
+  @brief Walk the translation tables rooted at tt_base_phys and return the block or
+         page descriptor mapping a virtual address. Successful walks are cached per
+         VA page, so repeated queries for the same page skip the table walk.
+  @param tt_base_phys - physical address of the level 0 (or first level) table
+  @param ias - input address size in bits
+  @param page_size_log2 - translation granule
+  @param virtual_address - address to translate
+  @param desc - output leaf descriptor
+  @param level - output level of the leaf descriptor
+  @return 0 if the address is mapped, AVS_STATUS_ERR otherwise
+**/
+uint32_t val_pgt_walk(uint64_t tt_base_phys, uint32_t ias, uint32_t page_size_log2,
+                      uint64_t virtual_address, uint64_t *desc, uint32_t *level)
+{
+    uint32_t index, num_pgt_levels, this_level, bits_per_lvl;
+    uint32_t bits_at_this_level, bits_remaining;
+    uint64_t val64, tt_base = tt_base_phys, *tt_base_virt;
+    uint64_t va_page = virtual_address >> page_size_log2;
+    pgt_walk_cache_entry_t *entry = &g_pgt_walk_cache[va_page & (PGT_WALK_CACHE_SIZE - 1)];
+
+    if (entry->tt_base == tt_base_phys && entry->va_page == va_page) {
+        *desc = entry->desc;
+        *level = entry->level;
+        return 0;
+    }
+
+    bits_per_lvl = page_size_log2 - 3;
+    num_pgt_levels = (ias - page_size_log2 + bits_per_lvl - 1)/bits_per_lvl;
+    this_level = PGT_LEVEL_MAX - num_pgt_levels;
+    bits_remaining = (num_pgt_levels - 1) * bits_per_lvl + page_size_log2;
+    bits_at_this_level = ias - bits_remaining;
+
+    while (this_level < PGT_LEVEL_MAX) {
+        index = (virtual_address >> bits_remaining) & ((0x1u << bits_at_this_level) - 1);
+        tt_base_virt = (uint64_t*)val_memory_phys_to_virt(tt_base);
+        val64 = tt_base_virt[index];
+
+        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_walk: this_level = %d ", this_level);
+        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_walk: index = %d ", index);
+        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_walk: bits_remaining = %d", bits_remaining);
+        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_walk: tt_base_virt %llx", (uint64_t)tt_base_virt);
+        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_walk: val64 = %llx ", val64);
+
+        if (IS_PGT_ENTRY_INVALID(val64))
+            return AVS_STATUS_ERR;
+
+        /* Level 3 only holds pages, level 0 only tables */
+        if ((this_level == 3) ? IS_PGT_ENTRY_PAGE(val64) :
+                                (this_level != 0 && IS_PGT_ENTRY_BLOCK(val64))) {
+            entry->tt_base = tt_base_phys;
+            entry->va_page = va_page;
+            entry->desc = *desc = val64;
+            entry->level = *level = this_level;
+            return 0;
+        }
+
+        if (this_level == 3 || !IS_PGT_ENTRY_TABLE(val64))
+            return AVS_STATUS_ERR;
+
+        tt_base = val64 & (((0x1ull << (ias - page_size_log2)) - 1) << page_size_log2);
+        ++this_level;
+        bits_remaining -= bits_at_this_level;
+        bits_at_this_level = bits_per_lvl;
+    }
+
+    return AVS_STATUS_ERR;
+}
+
 /**
   @brief Get attributes of a page corresponding to a given virtual address.
   @param pgt_desc - page table base and translation attributes.
@@ -234,10 +633,8 @@ uint32_t val_pgt_create(memory_region_descriptor_t *mem_desc, pgt_descriptor_t *
 **/
 uint64_t val_pgt_get_attributes(pgt_descriptor_t pgt_desc, uint64_t virtual_address, uint64_t *attributes)
 {
-    uint32_t ias, index, num_pgt_levels, this_level;
-    uint32_t bits_at_this_level, bits_remaining;
-    uint64_t val64, tt_base_phys, *tt_base_virt;
-    uint32_t page_size_log2 = pgt_desc.tcr.tg_size_log2;
+    uint64_t desc;
+    uint32_t level;
 
     if (attributes == NULL)
         return AVS_STATUS_ERR;
@@ -245,46 +642,16 @@ uint64_t val_pgt_get_attributes(pgt_descriptor_t pgt_desc, uint64_t virtual_addr
     if (!pgt_desc.pgt_base)
         return AVS_STATUS_ERR;
 
-    ias = 64 - pgt_desc.tcr.tsz;
-
-    bits_per_level = page_size_log2 - 3;
-    num_pgt_levels = (ias - page_size_log2 + bits_per_level - 1)/bits_per_level;
-    this_level = 4 - num_pgt_levels;
-    bits_remaining = (num_pgt_levels - 1) * bits_per_level + page_size_log2;
-    bits_at_this_level = ias - bits_remaining;
-    tt_base_phys = pgt_desc.pgt_base;
-
-    while (1) {
-        index = (virtual_address >> bits_remaining) & ((0x1u << bits_at_this_level) - 1);
-        tt_base_virt = (uint64_t*)val_memory_phys_to_virt(tt_base_phys);
-        val64 = tt_base_virt[index];
+    if (val_pgt_walk(pgt_desc.pgt_base, 64 - pgt_desc.tcr.tsz, pgt_desc.tcr.tg_size_log2,
+                     virtual_address, &desc, &level))
+        return AVS_STATUS_ERR;
 
-        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_get_attr: this_level = %d ", this_level);
-        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_get_attr: index = %d ", index);
-        val_print(PGT_DEBUG_LEVEL,
-                 "\n       val_pgt_get_attr: bits_remaining = %d", bits_remaining);
-        val_print(PGT_DEBUG_LEVEL,
-                 "\n       val_pgt_get_attr: tt_base_virt %llx", (uint64_t)tt_base_virt);
-        val_print(PGT_DEBUG_LEVEL, "\n       val_pgt_get_attr: val64 = %llx ", val64);
-        if (this_level == 3)
-        {
-            if (!IS_PGT_ENTRY_PAGE(val64))
-                return AVS_STATUS_ERR;
-            *attributes = PGT_DESC_ATTRIBUTES(val64);
-            return 0;
-        }
-        if (IS_PGT_ENTRY_BLOCK(val64)) {
-            *attributes = PGT_DESC_ATTRIBUTES(val64);
-            return 0;
-        }
-        tt_base_phys = val64 & (((0x1ull << (ias - page_size_log2)) - 1) << page_size_log2);
-        ++this_level;
-        bits_remaining -= bits_at_this_level;
-        bits_at_this_level = bits_per_level;
-    }
+    *attributes = PGT_DESC_ATTRIBUTES(desc);
+    return 0;
 }
 
-static void free_translation_table(uint64_t *tt_base, uint32_t bits_at_this_level, uint32_t this_level)
+static void free_translation_table(pgt_arena_t *arena, uint64_t *tt_base,
+                                   uint32_t bits_at_this_level, uint32_t this_level)
 {
     uint32_t index;
     uint64_t *tt_base_next_virt;
@@ -300,9 +667,9 @@ static void free_translation_table(uint64_t *tt_base, uint32_t bits_at_this_leve
             tt_base_next_virt = val_memory_phys_to_virt((tt_base[index] & pgt_addr_mask));
             if (tt_base_next_virt == NULL)
                 continue;
-            free_translation_table(tt_base_next_virt, bits_per_level, this_level+1);
+            free_translation_table(arena, tt_base_next_virt, bits_per_level, this_level+1);
             val_print(PGT_DEBUG_LEVEL, "\n      free_translation_table: tt_base_next_virt = %llx     ", (uint64_t)tt_base_next_virt);
-            val_memory_free_pages(tt_base_next_virt, 1);
+            pgt_free_page(arena, tt_base_next_virt);
         }
     }
 }
@@ -316,6 +683,7 @@ void val_pgt_destroy(pgt_descriptor_t pgt_desc)
 {
     uint32_t page_size_log2, num_pgt_levels;
     uint64_t *pgt_base_virt = val_memory_phys_to_virt(pgt_desc.pgt_base);
+    pgt_arena_t *arena;
 
     if (!pgt_desc.pgt_base)
         return;
@@ -327,8 +695,18 @@ void val_pgt_destroy(pgt_descriptor_t pgt_desc)
     pgt_addr_mask = ((0x1ull << (pgt_desc.ias - page_size_log2)) - 1) << page_size_log2;
     num_pgt_levels = (pgt_desc.ias - page_size_log2 + bits_per_level - 1)/bits_per_level;
 
-    free_translation_table(pgt_base_virt,
-                           pgt_desc.ias - ((num_pgt_levels - 1) * bits_per_level + page_size_log2),
-                           4 - num_pgt_levels);
-    val_memory_free_pages(pgt_base_virt, 1);
+    val_pgt_walk_cache_invalidate();
+    arena = pgt_arena_find(pgt_desc.pgt_base);
+
+    /* Only tables allocated after the arena ran out need to be freed one by one */
+    if (arena == NULL || arena->next_page >= arena->num_pages)
+        free_translation_table(arena, pgt_base_virt,
+                               pgt_desc.ias - ((num_pgt_levels - 1) * bits_per_level +
+                                               page_size_log2),
+                               4 - num_pgt_levels);
+
+    if (arena != NULL)
+        pgt_arena_free(arena);
+    else
+        val_memory_free_pages(pgt_base_virt, 1);
 }
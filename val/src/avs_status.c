@@ -86,13 +86,13 @@ val_report_status(uint32_t index, uint32_t status, char8_t *ruleid)
 void
 val_set_status(uint32_t index, uint32_t status)
 {
-  volatile VAL_SHARED_MEM_t *mem;
+  volatile VAL_SHARED_STATUS_t *st;
 
-  mem = (VAL_SHARED_MEM_t *) pal_mem_get_shared_addr();
-  mem = mem + index;
-  mem->status = status;
+  st = val_get_shared_mem_status(index);
 
-  val_data_cache_ops_by_va((addr_t)&mem->status, CLEAN_AND_INVALIDATE);
+  val_shared_mem_write_begin(st, sizeof(*st));
+  st->status = status;
+  val_shared_mem_write_end(st, sizeof(*st));
 }
 
 /**
@@ -105,14 +105,13 @@ val_set_status(uint32_t index, uint32_t status)
 uint32_t
 val_get_status(uint32_t index)
 {
-  volatile VAL_SHARED_MEM_t *mem;
+  volatile VAL_SHARED_STATUS_t *st;
 
-  mem = (VAL_SHARED_MEM_t *) pal_mem_get_shared_addr();
-  mem = mem + index;
+  st = val_get_shared_mem_status(index);
 
-  val_data_cache_ops_by_va((addr_t)&mem->status, INVALIDATE);
+  val_shared_mem_cache_ops(st, sizeof(*st), INVALIDATE);
 
-  return (uint32_t)(mem->status);
+  return (uint32_t)(st->status);
 
 }
 
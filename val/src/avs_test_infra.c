@@ -18,6 +18,109 @@
 #include "include/sbsa_avs_val.h"
 #include "include/sbsa_avs_pe.h"
 #include "include/sbsa_avs_common.h"
+#include "include/sbsa_avs_timer_support.h"
+#include "include/sbsa_avs_memory.h"
+
+/**
+  @brief   List of PEs whose result is still outstanding during a multi-PE test
+**/
+static uint32_t *g_pending_pe_list;
+
+#ifndef TARGET_LINUX
+/**
+  @brief   Log file output. Prints of the PE that called val_log_init are
+           collected in the buffer and written when it fills up, at test
+           boundaries and on unexpected exceptions. Other PEs write through.
+**/
+static struct {
+  uint32_t enabled;
+  uint32_t level;             /* Log file verbosity, independent of g_print_level */
+  uint64_t owner_mpid;
+  uint32_t used;
+  char8_t  buffer[VAL_LOG_BUFFER_SIZE];
+} g_val_log;
+
+/**
+  @brief  Enable the log file output of val_print. The PAL decides where the
+          output goes, see pal_log_write.
+          1. Caller       - Application layer, once a log file is open
+          2. Prerequisite - None.
+
+  @param level  the log file verbosity (1 to 5), prints below it only reach
+                the console
+
+  @return None
+ **/
+void
+val_log_init(uint32_t level)
+{
+  g_val_log.level = level;
+  g_val_log.owner_mpid = val_pe_get_mpid();
+  g_val_log.used = 0;
+  g_val_log.enabled = 1;
+}
+
+/**
+  @brief  Write out the buffered log file output.
+          1. Caller       - VAL, Application layer before the log file is closed
+          2. Prerequisite - None.
+
+  @return None
+ **/
+void
+val_log_flush(void)
+{
+  /* The log is only ever written by the PE which owns the buffer */
+  if (!g_val_log.enabled || !g_val_log.used || val_pe_get_mpid() != g_val_log.owner_mpid)
+      return;
+
+  pal_log_write(g_val_log.buffer, g_val_log.used);
+  g_val_log.used = 0;
+}
+
+/**
+  @brief  Add a formatted print to the log file output.
+
+  @param string  formatted ASCII string
+  @param data    64-bit data
+
+  @return None
+ **/
+static void
+val_log_print(char8_t *string, uint64_t data)
+{
+  char8_t line[VAL_LOG_LINE_MAX];
+
+  if (val_pe_get_mpid() != g_val_log.owner_mpid) {
+      pal_log_write(line, pal_log_format(line, VAL_LOG_LINE_MAX, string, data));
+      return;
+  }
+
+  if (VAL_LOG_BUFFER_SIZE - g_val_log.used < VAL_LOG_LINE_MAX)
+      val_log_flush();
+
+  g_val_log.used += pal_log_format(&g_val_log.buffer[g_val_log.used],
+                                   VAL_LOG_LINE_MAX, string, data);
+}
+#endif
+
+/**
+  @brief  Send a print to the console and to the log file output.
+
+  @param string  formatted ASCII string
+  @param data    64-bit data
+
+  @return None
+ **/
+static void
+val_print_all(char8_t *string, uint64_t data)
+{
+  pal_print(string, data);
+#ifndef TARGET_LINUX
+  if (g_val_log.enabled)
+      val_log_print(string, data);
+#endif
+}
 
 /**
   @brief  This API calls PAL layer to print a formatted string
@@ -25,6 +128,9 @@
           1. Caller       - Application layer
           2. Prerequisite - None.
 
+          The print also goes to the log file output if its level is
+          at least the log file verbosity given to val_log_init.
+
   @param level   the print verbosity (1 to 5)
   @param string  formatted ASCII string
   @param data    64-bit data. set to 0 if no data is to sent to console.
@@ -38,26 +144,33 @@ val_print(uint32_t level, char8_t *string, uint64_t data)
   if (level >= g_print_level)
       pal_print(string, data);
 
+#ifndef TARGET_LINUX
+  if (g_val_log.enabled && level >= g_val_log.level)
+      val_log_print(string, data);
+#endif
 }
 
 void
 val_print_test_end(uint32_t status, char8_t *string)
 {
-  pal_print("\n      ", 0);
+  val_print_all("\n      ", 0);
 
   if (status != AVS_STATUS_PASS) {
-      pal_print("One or more ", 0);
-      pal_print(string, 0);
-      pal_print(" tests failed or were skipped.", 0);
+      val_print_all("One or more ", 0);
+      val_print_all(string, 0);
+      val_print_all(" tests failed or were skipped.", 0);
   }
   else {
-      pal_print("All ", 0);
-      pal_print(string, 0);
-      pal_print(" tests passed.", 0);
+      val_print_all("All ", 0);
+      val_print_all(string, 0);
+      val_print_all(" tests passed.", 0);
   }
 
-  pal_print("\n", 0);
+  val_print_all("\n", 0);
 
+#ifndef TARGET_LINUX
+  val_log_flush();
+#endif
 }
 
 /**
@@ -96,6 +209,7 @@ val_print_raw(uint64_t uart_address, uint32_t level, char8_t *string,
 uint8_t
 val_mmio_read8(addr_t addr)
 {
+  val_test_profile_count(PROFILE_MMIO_READ);
   return pal_mmio_read8(addr);
 
 }
@@ -113,6 +227,7 @@ val_mmio_read8(addr_t addr)
 uint16_t
 val_mmio_read16(addr_t addr)
 {
+  val_test_profile_count(PROFILE_MMIO_READ);
   return pal_mmio_read16(addr);
 
 }
@@ -130,6 +245,7 @@ val_mmio_read16(addr_t addr)
 uint32_t
 val_mmio_read(addr_t addr)
 {
+  val_test_profile_count(PROFILE_MMIO_READ);
   return pal_mmio_read(addr);
 
 }
@@ -147,6 +263,7 @@ val_mmio_read(addr_t addr)
 uint64_t
 val_mmio_read64(addr_t addr)
 {
+  val_test_profile_count(PROFILE_MMIO_READ);
   return pal_mmio_read64(addr);
 
 }
@@ -166,6 +283,7 @@ void
 val_mmio_write8(addr_t addr, uint8_t data)
 {
 
+  val_test_profile_count(PROFILE_MMIO_WRITE);
   pal_mmio_write8(addr, data);
 }
 
@@ -184,6 +302,7 @@ void
 val_mmio_write16(addr_t addr, uint16_t data)
 {
 
+  val_test_profile_count(PROFILE_MMIO_WRITE);
   pal_mmio_write16(addr, data);
 }
 
@@ -202,6 +321,7 @@ void
 val_mmio_write(addr_t addr, uint32_t data)
 {
 
+  val_test_profile_count(PROFILE_MMIO_WRITE);
   pal_mmio_write(addr, data);
 }
 /**
@@ -219,6 +339,7 @@ void
 val_mmio_write64(addr_t addr, uint64_t data)
 {
 
+  val_test_profile_count(PROFILE_MMIO_WRITE);
   pal_mmio_write64(addr, data);
 }
 
@@ -243,10 +364,16 @@ val_initialize_test(uint32_t test_num, char8_t *desc, uint32_t num_pe, uint32_t
   uint32_t i;
   uint32_t index = val_pe_get_index_mpid(val_pe_get_mpid());
 
+#ifndef TARGET_LINUX
+  /* Output of the previous test is complete */
+  val_log_flush();
+#endif
+
   val_print(AVS_PRINT_ERR, "%4d : ", test_num); //Always print this
   val_print(AVS_PRINT_TEST, desc, 0);
   val_report_status(0, SBSA_AVS_START(level, test_num), ruleid);
   val_pe_initialize_default_exception_handler(val_pe_default_esr);
+  val_test_profile_start(test_num);
 
   g_sbsa_tests_total++;
 
@@ -274,7 +401,28 @@ val_initialize_test(uint32_t test_num, char8_t *desc, uint32_t num_pe, uint32_t
 }
 
 /**
-  @brief  Allocate memory which is to be shared across PEs
+  @brief   Aligned base of the shared memory region, size of one part of a PE
+           slot and size of the smallest data cache line used for maintenance
+**/
+static addr_t   g_shared_mem_base;
+static uint32_t g_shared_mem_stride;
+static uint32_t g_shared_mem_line;
+
+/* Parts of a PE slot, in the order they are laid out */
+#define SHARED_MEM_CMD      0
+#define SHARED_MEM_STATUS   1
+#define SHARED_MEM_EVENT    2
+
+#define SHARED_MEM_MAX(a, b)  ((a) > (b) ? (a) : (b))
+#define SHARED_MEM_PART_SIZE  SHARED_MEM_MAX(sizeof(VAL_SHARED_CMD_t), \
+                              SHARED_MEM_MAX(sizeof(VAL_SHARED_STATUS_t), sizeof(VAL_SHARED_EVENT_t)))
+
+/**
+  @brief  Allocate memory which is to be shared across PEs. Each PE gets one
+          slot of VAL_SHARED_MEM_PARTS parts, each padded and aligned to the
+          cache writeback granule (CTR_EL0.CWG), so that neighbouring PEs never
+          write to the same cache line and the primary PE never writes to a
+          line written by the PE running the payload.
 
   @param  None
 
@@ -283,8 +431,49 @@ val_initialize_test(uint32_t test_num, char8_t *desc, uint32_t num_pe, uint32_t
 void
 val_allocate_shared_mem()
 {
+  uint32_t i;
+  uint32_t granule = 64;
+  addr_t base;
+#ifndef TARGET_LINUX
+  uint64_t ctr;
+#endif
+
+  g_shared_mem_line = 64;
+
+#ifndef TARGET_LINUX
+  ctr = val_pe_reg_read(CTR_EL0);
+
+  /* CWG of 0 means no information, use the architectural maximum of 2KB */
+  granule = (((ctr >> 24) & 0xF) == 0) ? 2048 : (4 << ((ctr >> 24) & 0xF));
+  g_shared_mem_line = 4 << ((ctr >> 16) & 0xF);
+#endif
+
+  g_shared_mem_stride = ((uint32_t)SHARED_MEM_PART_SIZE + granule - 1) & ~(granule - 1);
+
+  /* One additional slot leaves room to align the base to the granule */
+  pal_mem_allocate_shared(val_pe_get_num() + 1, VAL_SHARED_MEM_PARTS * g_shared_mem_stride);
+
+  base = pal_mem_get_shared_addr();
+  if (base != 0)
+      base = (base + granule - 1) & ~((addr_t)granule - 1);
+  g_shared_mem_base = base;
+
+  val_data_cache_ops_by_va((addr_t)&g_shared_mem_base, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)&g_shared_mem_stride, CLEAN_AND_INVALIDATE);
+  val_data_cache_ops_by_va((addr_t)&g_shared_mem_line, CLEAN_AND_INVALIDATE);
+
+  /* Mailbox state is read by secondary PEs, start from a known clean slot */
+  if (base != 0) {
+      for (i = 0; i < val_pe_get_num() * VAL_SHARED_MEM_PARTS; i++) {
+          val_memory_set((void *)(base + (addr_t)i * g_shared_mem_stride), SHARED_MEM_PART_SIZE, 0);
+          val_shared_mem_cache_ops((void *)(base + (addr_t)i * g_shared_mem_stride),
+                                   SHARED_MEM_PART_SIZE, CLEAN_AND_INVALIDATE);
+      }
+  }
 
-  pal_mem_allocate_shared(val_pe_get_num(), sizeof(VAL_SHARED_MEM_t));
+  g_pending_pe_list = pal_mem_alloc(val_pe_get_num() * sizeof(uint32_t));
+  if (g_pending_pe_list == NULL)
+      val_print(AVS_PRINT_ERR, "\n Allocation of pending PE list failed", 0);
 
 }
 
@@ -301,7 +490,185 @@ void
 val_free_shared_mem()
 {
 
+  /* Parked PEs poll their mailbox, switch them off before the memory goes away */
+  val_pe_pool_release();
   pal_mem_free_shared();
+  g_shared_mem_base = 0;
+
+  if (g_pending_pe_list != NULL) {
+      pal_mem_free(g_pending_pe_list);
+      g_pending_pe_list = NULL;
+  }
+}
+
+/**
+  @brief  Return one part of the shared memory slot of a PE.
+
+  @param index   the PE Index
+  @param part    SHARED_MEM_CMD, SHARED_MEM_STATUS or SHARED_MEM_EVENT
+
+  @return        Pointer to the part, NULL if shared memory is not allocated
+ **/
+static void *
+val_get_shared_mem_part(uint32_t index, uint32_t part)
+{
+  if (g_shared_mem_base == 0)
+      return NULL;
+
+  return (void *)(g_shared_mem_base +
+                  ((addr_t)index * VAL_SHARED_MEM_PARTS + part) * g_shared_mem_stride);
+}
+
+/**
+  @brief  These APIs return the part of the shared memory slot of the PE
+          identified by index written by the primary PE (payload and pool
+          commands), the test status, and the part written by the PE running
+          the payload (payload events).
+          1. Caller       - VAL
+          2. Prerequisite - val_allocate_shared_mem
+
+  @param index   the PE Index
+
+  @return        Pointer to the part, NULL if shared memory is not allocated
+ **/
+VAL_SHARED_CMD_t *
+val_get_shared_mem_cmd(uint32_t index)
+{
+  return val_get_shared_mem_part(index, SHARED_MEM_CMD);
+}
+
+VAL_SHARED_STATUS_t *
+val_get_shared_mem_status(uint32_t index)
+{
+  return val_get_shared_mem_part(index, SHARED_MEM_STATUS);
+}
+
+VAL_SHARED_EVENT_t *
+val_get_shared_mem_event(uint32_t index)
+{
+  return val_get_shared_mem_part(index, SHARED_MEM_EVENT);
+}
+
+/**
+  @brief  Perform a cache maintenance operation on one part of a shared memory
+          slot. A part fits in a single cache line on most implementations, in
+          which case this is a single operation.
+          1. Caller       - VAL
+          2. Prerequisite - val_allocate_shared_mem
+
+  @param part  Pointer to the part
+  @param size  Size of the part
+  @param type  CLEAN, INVALIDATE or CLEAN_AND_INVALIDATE
+
+  @return        None
+ **/
+void
+val_shared_mem_cache_ops(volatile void *part, uint32_t size, uint32_t type)
+{
+  addr_t addr = (addr_t)part;
+  addr_t end_addr = addr + size;
+
+  while (addr < end_addr) {
+      val_data_cache_ops_by_va(addr, type);
+      addr += g_shared_mem_line;
+  }
+}
+
+/**
+  @brief  Start an update of one part of a shared memory slot. Every part
+          starts with a sequence number, which is odd while the part is
+          being written and even once the update is complete, so that readers
+          can detect a copy taken in the middle of an update. A part only has
+          one writer at a time.
+          1. Caller       - VAL
+          2. Prerequisite - val_allocate_shared_mem
+
+  @param part  Pointer to the part
+  @param size  Size of the part
+
+  @return        None
+ **/
+void
+val_shared_mem_write_begin(volatile void *part, uint32_t size)
+{
+  volatile uint32_t *seq = part;
+
+  val_shared_mem_cache_ops(part, size, INVALIDATE);
+  *seq = *seq + 1;
+  val_shared_mem_cache_ops(part, size, CLEAN);
+}
+
+/**
+  @brief  Complete an update of one part of a shared memory slot started with
+          val_shared_mem_write_begin, and publish the new fields.
+          1. Caller       - VAL
+          2. Prerequisite - val_shared_mem_write_begin
+
+  @param part  Pointer to the part
+  @param size  Size of the part
+
+  @return        None
+ **/
+void
+val_shared_mem_write_end(volatile void *part, uint32_t size)
+{
+  volatile uint32_t *seq = part;
+
+  *seq = *seq + 1;
+  val_shared_mem_cache_ops(part, size, CLEAN_AND_INVALIDATE);
+}
+
+/**
+  @brief  Copy one part of a shared memory slot. The copy is retried while the
+          sequence number is odd, or when it changed by the time the part has
+          been invalidated and read again after the copy.
+
+  @param part  Pointer to the part
+  @param copy  Caller buffer of the same size
+  @param size  Size of the part
+
+  @return        None
+ **/
+static void
+val_shared_mem_read(volatile void *part, void *copy, uint32_t size)
+{
+  volatile uint32_t *src = part;
+  uint32_t *dst = copy;
+  uint32_t seq, i;
+
+  do {
+      val_shared_mem_cache_ops(part, size, INVALIDATE);
+      seq = src[0];
+      for (i = 1; i < size / sizeof(uint32_t); i++)
+          dst[i] = src[i];
+      val_shared_mem_cache_ops(part, size, INVALIDATE);
+  } while ((seq & 1) || (src[0] != seq));
+
+  dst[0] = seq;
+}
+
+/**
+  @brief  Take a consistent copy of each of the three parts of the shared
+          memory slot of a PE. The parts have different writers and are copied
+          one after the other, so the copy is only consistent within a part.
+          1. Caller       - VAL
+          2. Prerequisite - val_allocate_shared_mem
+
+  @param index     the PE Index
+  @param snapshot  Caller buffer that receives the copy of the slot
+
+  @return        Sequence number of the copied payload events
+ **/
+uint32_t
+val_get_shared_mem_snapshot(uint32_t index, VAL_SHARED_MEM_t *snapshot)
+{
+  val_shared_mem_read(val_get_shared_mem_cmd(index), &snapshot->cmd, sizeof(snapshot->cmd));
+  val_shared_mem_read(val_get_shared_mem_status(index), &snapshot->status,
+                      sizeof(snapshot->status));
+  val_shared_mem_read(val_get_shared_mem_event(index), &snapshot->event,
+                      sizeof(snapshot->event));
+
+  return snapshot->event.seq;
 }
 
 /**
@@ -320,7 +687,7 @@ val_free_shared_mem()
 void
 val_set_test_data(uint32_t index, uint64_t addr, uint64_t test_data)
 {
-  volatile VAL_SHARED_MEM_t *mem;
+  volatile VAL_SHARED_CMD_t *cmd;
 
   if(index > val_pe_get_num())
   {
@@ -328,14 +695,50 @@ val_set_test_data(uint32_t index, uint64_t addr, uint64_t test_data)
       return;
   }
 
-  mem = (VAL_SHARED_MEM_t *)pal_mem_get_shared_addr();
-  mem = mem + index;
+  cmd = val_get_shared_mem_cmd(index);
 
-  mem->data0 = addr;
-  mem->data1 = test_data;
+  /* The events of the previous payload are left to the PE, a new dispatch
+     number tells them apart from those of this one */
+  val_shared_mem_write_begin(cmd, sizeof(*cmd));
+  cmd->data0 = addr;
+  cmd->data1 = test_data;
+  cmd->dispatch = cmd->dispatch + 1;
+  val_shared_mem_write_end(cmd, sizeof(*cmd));
+}
+
+/**
+  @brief  This API records a dispatch event (payload picked up or payload
+          returned) along with the current system counter value in the
+          shared memory slot of the PE identified by index.
+          1. Caller       - VAL
+          2. Prerequisite - val_set_test_data
+
+  @param index   PE index recording the event
+  @param event   PE_DISPATCH_WAKE or PE_DISPATCH_DONE
 
-  val_data_cache_ops_by_va((addr_t)&mem->data0, CLEAN_AND_INVALIDATE);
-  val_data_cache_ops_by_va((addr_t)&mem->data1, CLEAN_AND_INVALIDATE);
+  @return        None
+ **/
+void
+val_set_test_event(uint32_t index, uint32_t event)
+{
+  volatile VAL_SHARED_CMD_t *cmd;
+  volatile VAL_SHARED_EVENT_t *evt;
+
+  cmd = val_get_shared_mem_cmd(index);
+  evt = val_get_shared_mem_event(index);
+
+  if (event == PE_DISPATCH_WAKE)
+      val_shared_mem_cache_ops(cmd, sizeof(*cmd), INVALIDATE);
+
+  val_shared_mem_write_begin(evt, sizeof(*evt));
+  if (event == PE_DISPATCH_WAKE) {
+      evt->dispatch = cmd->dispatch;
+      evt->wake_ts = val_get_timestamp();
+  } else {
+      evt->done_ts = val_get_timestamp();
+      evt->done = evt->dispatch;
+  }
+  val_shared_mem_write_end(evt, sizeof(*evt));
 }
 
 /**
@@ -353,7 +756,7 @@ void
 val_get_test_data(uint32_t index, uint64_t *data0, uint64_t *data1)
 {
 
-  volatile VAL_SHARED_MEM_t *mem;
+  VAL_SHARED_MEM_t snapshot;
 
   if(index > val_pe_get_num())
   {
@@ -361,15 +764,413 @@ val_get_test_data(uint32_t index, uint64_t *data0, uint64_t *data1)
       return;
   }
 
-  mem = (VAL_SHARED_MEM_t *) pal_mem_get_shared_addr();
-  mem = mem + index;
+  val_get_shared_mem_snapshot(index, &snapshot);
+
+  *data0 = snapshot.cmd.data0;
+  *data1 = snapshot.cmd.data1;
+
+}
+
+/**
+  @brief   Per-test wall-clock records and the record of the running test
+**/
+static VAL_TEST_PROFILE_t  g_test_profile[VAL_MAX_TEST_PROFILE];
+static uint32_t            g_num_test_profile;
+static VAL_TEST_PROFILE_t *g_test_profile_active;
+static uint64_t            g_test_profile_mpid;
+
+/**
+  @brief  This API returns the current value of the system counter. It is used
+          to timestamp the dispatch and completion of multi-PE test payloads.
+          1. Caller       - VAL
+          2. Prerequisite - None
+
+  @param  None
+
+  @return 64-bit system counter value
+ **/
+uint64_t
+val_get_timestamp(void)
+{
+#ifndef TARGET_LINUX
+  return ArmReadCntPct();
+#else
+  return 0;
+#endif
+}
+
+/**
+  @brief   System counter frequency in Hz, looked up on first use. Zero when
+           no counter is available, in which case timeouts count polls.
+**/
+static uint64_t g_counter_freq;
+
+static uint64_t
+val_get_timeout_frequency(void)
+{
+#ifndef TARGET_LINUX
+  if (g_counter_freq == 0)
+      g_counter_freq = val_get_counter_frequency();
+
+  if (g_counter_freq == 0)
+      g_counter_freq = ArmReadCntFrq();
+#endif
+
+  return g_counter_freq;
+}
+
+/**
+  @brief  This API converts a number of system counter ticks to microseconds.
+          1. Caller       - VAL
+          2. Prerequisite - None
+
+  @param  ticks  Number of system counter ticks
+
+  @return Time in microseconds, or ticks if the counter frequency is unknown
+ **/
+uint64_t
+val_ticks_to_us(uint64_t ticks)
+{
+  uint64_t freq = val_get_timeout_frequency();
+
+  if (freq == 0)
+      return ticks;
+
+  return ((ticks / freq) * 1000000) + (((ticks % freq) * 1000000) / freq);
+}
+
+/**
+  @brief  This API starts a timeout of the given length in microseconds. The
+          length is converted to system counter ticks once, so expiry does not
+          depend on how long each poll of the caller takes.
+          1. Caller       - VAL, Test Suite
+          2. Prerequisite - None
+
+  @param  timeout  Timeout to be started
+  @param  time_us  Length of the timeout in microseconds
+
+  @return None
+ **/
+void
+val_timeout_start(VAL_TIMEOUT_t *timeout, uint64_t time_us)
+{
+  uint64_t freq = val_get_timeout_frequency();
+
+  timeout->start = val_get_timestamp();
+  timeout->polls = 0;
+
+  if (freq == 0) {
+      /* No counter, fall back to one poll per microsecond */
+      timeout->ticks = time_us;
+      return;
+  }
+
+  timeout->ticks = ((time_us / 1000000) * freq) + (((time_us % 1000000) * freq) / 1000000);
+}
+
+/**
+  @brief  Check a timeout for expiry without accounting it to the test.
+
+  @param  timeout  Timeout to be checked
+
+  @return 1 if the timeout has expired, else 0
+ **/
+static uint32_t
+val_timeout_check(VAL_TIMEOUT_t *timeout)
+{
+  timeout->polls++;
+
+  if (g_counter_freq)
+      return ((val_get_timestamp() - timeout->start) >= timeout->ticks);
+
+  return (timeout->polls >= timeout->ticks);
+}
+
+/**
+  @brief  This API checks whether a timeout started with val_timeout_start
+          has expired. An expiry is accounted to the test which is running.
+          1. Caller       - VAL, Test Suite
+          2. Prerequisite - val_timeout_start
+
+  @param  timeout  Timeout to be checked
+
+  @return 1 if the timeout has expired, else 0
+ **/
+uint32_t
+val_timeout_expired(VAL_TIMEOUT_t *timeout)
+{
+  if (!val_timeout_check(timeout))
+      return 0;
+
+  if (g_test_profile_active)
+      g_test_profile_active->timeouts++;
+
+  return 1;
+}
+
+/**
+  @brief  This API busy-waits for the given number of microseconds on the
+          system counter.
+          1. Caller       - Test Suite
+          2. Prerequisite - None
+
+  @param  time_us  Time to wait in microseconds
+
+  @return None
+ **/
+void
+val_delay_us(uint64_t time_us)
+{
+  VAL_TIMEOUT_t timeout;
+
+  val_timeout_start(&timeout, time_us);
+  while (!val_timeout_check(&timeout));
+}
+
+/**
+  @brief  This API opens the wall-clock record of a test.
+          1. Caller       - VAL
+          2. Prerequisite - None
+
+  @param  test_num  Unique test number
+
+  @return None
+ **/
+void
+val_test_profile_start(uint32_t test_num)
+{
+  uint32_t i;
+  VAL_TEST_PROFILE_t *profile;
+
+  if (g_num_test_profile >= VAL_MAX_TEST_PROFILE) {
+      g_test_profile_active = NULL;
+      return;
+  }
+
+  profile = &g_test_profile[g_num_test_profile++];
+  profile->test_num = test_num;
+  profile->timeouts = 0;
+  profile->elapsed  = 0;
+  for (i = 0; i < PROFILE_COUNT_MAX; i++)
+      profile->count[i] = 0;
+  profile->start_ts = val_get_timestamp();
+
+  /* Only accesses made by the PE running the test are counted, secondary
+     PEs run with the MMU off and cannot update the record coherently */
+  g_test_profile_mpid = val_pe_get_mpid();
+
+  g_test_profile_active = profile;
+}
+
+/**
+  @brief  This API closes the wall-clock record of the running test.
+          1. Caller       - VAL
+          2. Prerequisite - val_test_profile_start
+
+  @param  None
+
+  @return None
+ **/
+void
+val_test_profile_end(void)
+{
+  if (g_test_profile_active == NULL)
+      return;
+
+  g_test_profile_active->elapsed = val_get_timestamp() - g_test_profile_active->start_ts;
+  g_test_profile_active = NULL;
+}
+
+/**
+  @brief  This API counts one access of the given type against the running
+          test. It is called by the VAL MMIO, config space and PSCI wrappers.
+          1. Caller       - VAL
+          2. Prerequisite - None
+
+  @param  type  Type of the access, see VAL_PROFILE_COUNT_e
+
+  @return None
+ **/
+void
+val_test_profile_count(VAL_PROFILE_COUNT_e type)
+{
+  if ((g_test_profile_active == NULL) || (type >= PROFILE_COUNT_MAX))
+      return;
+
+  if (val_pe_get_mpid() != g_test_profile_mpid)
+      return;
+
+  g_test_profile_active->count[type]++;
+}
+
+/**
+  @brief  Sort key of a test record, either the wall-clock time or the total
+          number of MMIO and config space accesses.
+**/
+#define PROFILE_SORT_TIME    0
+#define PROFILE_SORT_ACCESS  1
+
+static uint64_t
+val_test_profile_key(VAL_TEST_PROFILE_t *profile, uint32_t sort)
+{
+  if (sort == PROFILE_SORT_TIME)
+      return profile->elapsed;
+
+  return (uint64_t)profile->count[PROFILE_MMIO_READ] + profile->count[PROFILE_MMIO_WRITE] +
+         profile->count[PROFILE_CFG_READ] + profile->count[PROFILE_CFG_WRITE];
+}
+
+/**
+  @brief  Print the VAL_TEST_PROFILE_TOP tests with the largest sort key.
+
+  @param  sort   PROFILE_SORT_TIME or PROFILE_SORT_ACCESS
+  @param  title  Heading of the table
+
+  @return None
+ **/
+static void
+val_test_profile_print_top(uint32_t sort, char8_t *title)
+{
+  uint32_t i, j, num;
+  uint16_t order[VAL_MAX_TEST_PROFILE];
+  uint16_t tmp;
+  VAL_TEST_PROFILE_t *profile;
+
+  /* Insertion sort of the record indices, largest key first */
+  for (i = 0; i < g_num_test_profile; i++) {
+      tmp = (uint16_t)i;
+      j = i;
+      while (j && (val_test_profile_key(&g_test_profile[order[j - 1]], sort) <
+                   val_test_profile_key(&g_test_profile[tmp], sort))) {
+          order[j] = order[j - 1];
+          j--;
+      }
+      order[j] = tmp;
+  }
+
+  num = (g_num_test_profile < VAL_TEST_PROFILE_TOP) ? g_num_test_profile : VAL_TEST_PROFILE_TOP;
+
+  val_print(AVS_PRINT_TEST, title, 0);
+  val_print(AVS_PRINT_TEST, "\n       Test        Time(us)   MMIO rd   MMIO wr    Cfg rd    Cfg wr  PSCI", 0);
+
+  for (i = 0; i < num; i++) {
+      profile = &g_test_profile[order[i]];
+      val_print(AVS_PRINT_TEST, "\n       %4d", profile->test_num);
+      val_print(AVS_PRINT_TEST, " %15d", val_ticks_to_us(profile->elapsed));
+      val_print(AVS_PRINT_TEST, " %9d", profile->count[PROFILE_MMIO_READ]);
+      val_print(AVS_PRINT_TEST, " %9d", profile->count[PROFILE_MMIO_WRITE]);
+      val_print(AVS_PRINT_TEST, " %9d", profile->count[PROFILE_CFG_READ]);
+      val_print(AVS_PRINT_TEST, " %9d", profile->count[PROFILE_CFG_WRITE]);
+      val_print(AVS_PRINT_TEST, " %5d", profile->count[PROFILE_PSCI]);
+  }
+}
+
+#ifndef TARGET_LINUX
+/**
+  @brief  Print every test record as one comma separated line, so that the
+          profile can be extracted from the -f log file.
+
+  @param  None
+
+  @return None
+ **/
+static void
+val_test_profile_print_csv(void)
+{
+  uint32_t i, j;
+  VAL_TEST_PROFILE_t *profile;
+
+  val_print(AVS_PRINT_ERR,
+            "\nPROFILE,test,time_us,timeouts,mmio_rd,mmio_wr,cfg_rd,cfg_wr,psci", 0);
+
+  for (i = 0; i < g_num_test_profile; i++) {
+      profile = &g_test_profile[i];
+      val_print(AVS_PRINT_ERR, "\nPROFILE,%d", profile->test_num);
+      val_print(AVS_PRINT_ERR, ",%d", val_ticks_to_us(profile->elapsed));
+      val_print(AVS_PRINT_ERR, ",%d", profile->timeouts);
+      for (j = 0; j < PROFILE_COUNT_MAX; j++)
+          val_print(AVS_PRINT_ERR, ",%d", profile->count[j]);
+  }
+  val_print(AVS_PRINT_ERR, "\n", 0);
+}
+#endif
+
+/**
+  @brief  This API prints the profile of the run: the total wall-clock time
+          and access counts, the tests in which a timeout expired and the
+          slowest and most MMIO-heavy tests. With g_profile_csv set, every
+          test record is also printed in CSV form.
+          1. Caller       - Application layer
+          2. Prerequisite - None
+
+  @param  None
+
+  @return None
+ **/
+void
+val_test_profile_report(void)
+{
+  uint32_t i, j;
+  uint64_t total = 0;
+  uint64_t count[PROFILE_COUNT_MAX] = {0};
+  VAL_TEST_PROFILE_t *profile;
+
+  if (g_num_test_profile == 0)
+      return;
+
+  for (i = 0; i < g_num_test_profile; i++) {
+      profile = &g_test_profile[i];
+      total += profile->elapsed;
+      for (j = 0; j < PROFILE_COUNT_MAX; j++)
+          count[j] += profile->count[j];
+
+      if (profile->timeouts) {
+          val_print(AVS_PRINT_TEST, "\n      Test %4d", profile->test_num);
+          val_print(AVS_PRINT_TEST, " : %d timeout(s) expired", profile->timeouts);
+          val_print(AVS_PRINT_TEST, " in %d us", val_ticks_to_us(profile->elapsed));
+      }
+  }
+
+  val_test_profile_print_top(PROFILE_SORT_TIME, "\n\n      Slowest tests :");
+  val_test_profile_print_top(PROFILE_SORT_ACCESS, "\n\n      Most MMIO-heavy tests :");
+
+  val_print(AVS_PRINT_TEST, "\n\n      Total test time  : %d ms", val_ticks_to_us(total) / 1000);
+  if (g_counter_freq == 0)
+      val_print(AVS_PRINT_TEST, "\n      (no system counter, times are in polls)", 0);
+  val_print(AVS_PRINT_TEST, "\n      MMIO reads  : %d", count[PROFILE_MMIO_READ]);
+  val_print(AVS_PRINT_TEST, ", writes : %d", count[PROFILE_MMIO_WRITE]);
+  val_print(AVS_PRINT_TEST, "\n      Cfg reads   : %d", count[PROFILE_CFG_READ]);
+  val_print(AVS_PRINT_TEST, ", writes : %d", count[PROFILE_CFG_WRITE]);
+  val_print(AVS_PRINT_TEST, "\n      PSCI calls  : %d", count[PROFILE_PSCI]);
+  val_print(AVS_PRINT_TEST, "\n", 0);
+
+#ifndef TARGET_LINUX
+  if (g_profile_csv)
+      val_test_profile_print_csv();
+#endif
+}
 
-  val_data_cache_ops_by_va((addr_t)&mem->data0, INVALIDATE);
-  val_data_cache_ops_by_va((addr_t)&mem->data1, INVALIDATE);
+/**
+  @brief  Check whether the PE identified by index has finished the current
+          test, either by reporting a final status or by returning from the
+          payload last dispatched to it.
 
-  *data0 = mem->data0;
-  *data1 = mem->data1;
+  @param index   PE index to be checked
 
+  @return 1 if the PE has completed, else 0
+ **/
+static uint32_t
+val_is_test_complete(uint32_t index)
+{
+  volatile VAL_SHARED_EVENT_t *evt;
+
+  /* The dispatch number is only written by this PE, the cached copy is current */
+  evt = val_get_shared_mem_event(index);
+  val_shared_mem_cache_ops(evt, sizeof(*evt), INVALIDATE);
+  if (evt->done == val_get_shared_mem_cmd(index)->dispatch)
+      return 1;
+
+  return !IS_RESULT_PENDING(val_get_status(index));
 }
 
 /**
@@ -380,40 +1181,101 @@ val_get_test_data(uint32_t index, uint64_t *data0, uint64_t *data1)
 
   @param test_num  Unique test number
   @param num_pe    Number of PE who are executing this test
-  @param timeout   integer value ob expiry the API will timeout and return
+  @param timeout_us time in microseconds after which the API will timeout and return
 
   @return        None
  **/
 
 void
-val_wait_for_test_completion(uint32_t test_num, uint32_t num_pe, uint32_t timeout)
+val_wait_for_test_completion(uint32_t test_num, uint32_t num_pe, uint64_t timeout_us)
 {
 
-  uint32_t i = 0, j = 0;
+  uint32_t i;
+  uint32_t pending = 0;
+  VAL_TIMEOUT_t timeout;
 
   //For single PE tests, there is no need to wait for the results
   if (num_pe == 1)
       return;
 
-  while(--timeout)
+  if (g_pending_pe_list == NULL)
+      return;
+
+  /* PEs are retired from the pending list as they complete, so every pass
+     only polls the PEs which have not reported yet */
+  for (i = 0; i < num_pe; i++)
+      g_pending_pe_list[pending++] = i;
+
+  val_timeout_start(&timeout, timeout_us);
+  while (pending && !val_timeout_expired(&timeout))
   {
-      j = 0;
-      for (i = 0; i < num_pe; i++)
+      i = 0;
+      while (i < pending)
       {
-          if (IS_RESULT_PENDING(val_get_status(i))) {
-              j = i+1;
-          }
+          if (val_is_test_complete(g_pending_pe_list[i]))
+              g_pending_pe_list[i] = g_pending_pe_list[--pending];
+          else
+              i++;
       }
-      //If None of the PE have the status as Pending, return
-      if (!j)
-          return;
   }
-  //We are here if we timed-out, set the last index PE as failed
-  val_set_status(j-1, RESULT_FAIL(g_sbsa_level, test_num, 0xF));
+
+  /* Fail every PE still without a final status: those which timed out, and
+     those which returned from the payload without reporting one */
+  for (i = 0; i < num_pe; i++) {
+      if (IS_RESULT_PENDING(val_get_status(i)))
+          val_set_status(i, RESULT_FAIL(g_sbsa_level, test_num, 0xF));
+  }
+}
+
+/**
+  @brief  Print the time taken by each secondary PE to pick up and complete
+          the payload, relative to the start of the dispatch.
+
+  @param num_pe      Number of PEs which executed the payload
+  @param my_index    Index of the dispatching PE
+  @param dispatch_ts System counter value at the start of the dispatch
+
+  @return        None
+ **/
+static void
+val_print_dispatch_time(uint32_t num_pe, uint32_t my_index, uint64_t dispatch_ts)
+{
+  uint32_t i;
+  uint64_t max_wake = 0, max_done = 0;
+  VAL_SHARED_MEM_t slot;
+
+  for (i = 0; i < num_pe; i++) {
+      if (i == my_index)
+          continue;
+
+      val_get_shared_mem_snapshot(i, &slot);
+
+      if (slot.event.done != slot.cmd.dispatch || slot.event.wake_ts < dispatch_ts ||
+          slot.event.done_ts < dispatch_ts)
+          continue;
+
+      val_print(AVS_PRINT_INFO, "\n       PE %4d", i);
+      val_print(AVS_PRINT_INFO, " wake +%d ticks", slot.event.wake_ts - dispatch_ts);
+      val_print(AVS_PRINT_INFO, " done +%d ticks", slot.event.done_ts - dispatch_ts);
+
+      if (slot.event.wake_ts - dispatch_ts > max_wake)
+          max_wake = slot.event.wake_ts - dispatch_ts;
+      if (slot.event.done_ts - dispatch_ts > max_done)
+          max_done = slot.event.done_ts - dispatch_ts;
+  }
+
+  val_print(AVS_PRINT_DEBUG, "\n       Dispatched to %d PEs", num_pe - 1);
+  val_print(AVS_PRINT_DEBUG, ", last wake +%d ticks", max_wake);
+  val_print(AVS_PRINT_DEBUG, ", last done +%d ticks", max_done);
+  val_print(AVS_PRINT_DEBUG, ", total %d ticks", val_get_timestamp() - dispatch_ts);
 }
 
 /**
-  @brief  This API Executes the payload function on secondary PEs
+  @brief  This API Executes the payload function on secondary PEs.
+          The payload is published in the shared memory slot of every PE
+          first and the PSCI CPU_ON calls are then issued back-to-back,
+          so that the secondary PEs wake up while the present PE runs
+          its own copy of the payload.
           1. Caller       - Application layer
           2. Prerequisite - val_pe_create_info_table
 
@@ -430,18 +1292,30 @@ val_run_test_payload(uint32_t test_num, uint32_t num_pe, void (*payload)(void),
 
   uint32_t my_index = val_pe_get_index_mpid(val_pe_get_mpid());
   uint32_t i;
+  uint64_t dispatch_ts;
 
-  payload();  //this is test run separately on present PE
-  if (num_pe == 1)
+  if (num_pe == 1) {
+      payload();  //this is test run separately on present PE
       return;
+  }
 
-  //Now run the test on all other PE
   for (i = 0; i < num_pe; i++) {
       if (i != my_index)
-          val_execute_on_pe(i, payload, test_input);
+          val_set_test_data(i, (uint64_t)payload, test_input);
   }
 
-  val_wait_for_test_completion(test_num, num_pe, TIMEOUT_LARGE);
+  //Now wake all other PE in one batch, PEs parked in the worker pool only need an event
+  dispatch_ts = val_get_timestamp();
+  for (i = 0; i < num_pe; i++) {
+      if ((i != my_index) && !val_pe_pool_handover(i))
+          val_pe_cpu_on(i);
+  }
+  val_pe_pool_signal();
+
+  payload();  //this is test run separately on present PE
+
+  val_wait_for_test_completion(test_num, num_pe, TIMEOUT_US_LARGE);
+  val_print_dispatch_time(num_pe, my_index, dispatch_ts);
 }
 
 /**
@@ -462,6 +1336,8 @@ val_check_for_error(uint32_t test_num, uint32_t num_pe, char8_t *ruleid)
   uint32_t error_flag = 0;
   uint32_t my_index = val_pe_get_index_mpid(val_pe_get_mpid());
 
+  val_test_profile_end();
+
   /* this special case is needed when the Main PE is not the first entry
      of pe_info_table but num_pe is 1 for SOC tests */
   if (num_pe == 1) {
@@ -513,6 +1389,36 @@ val_data_cache_ops_by_va(addr_t addr, uint32_t type)
 
 }
 
+/**
+  @brief  Perform a data cache maintenance operation on every cache line of
+          an address range. The smallest data cache line size of the system
+          (CTR_EL0.DminLine) is used as the step.
+          1. Caller       - VAL
+          2. Prerequisite - None
+
+  @param addr  Start of the range
+  @param size  Size of the range in bytes
+  @param type  CLEAN, INVALIDATE or CLEAN_AND_INVALIDATE
+
+  @return      None
+**/
+void
+val_data_cache_ops_by_range(addr_t addr, uint64_t size, uint32_t type)
+{
+  uint32_t line = 64;
+  addr_t   end_addr = addr + size;
+
+#ifndef TARGET_LINUX
+  line = 4 << ((val_pe_reg_read(CTR_EL0) >> 16) & 0xF);
+#endif
+
+  addr &= ~((addr_t)line - 1);
+  while (addr < end_addr) {
+      pal_pe_data_cache_ops_by_va(addr, type);
+      addr += line;
+  }
+}
+
 /**
   @brief  Update ELR based on the offset provided
 **/
@@ -74,6 +74,7 @@ val_suspend_pe(uint32_t power_state, uint64_t entry, uint32_t context_id)
   smc_args.Arg1 = power_state;
   smc_args.Arg2 = entry;
   smc_args.Arg3 = context_id;
+  val_test_profile_count(PROFILE_PSCI);
   pal_pe_call_smc(&smc_args, gPsciConduit);
 }
 
@@ -302,13 +302,13 @@ WriteCmdQSYNC(
 
 void PollTillCommandQueueDone(uint32_t its_index)
 {
-  uint32_t    count;
   uint64_t    creadr_value;
   uint64_t    stall_value;
   uint64_t    cwriter_value;
   uint64_t    ItsBase;
+  VAL_TIMEOUT_t timeout;
 
-  count = 0;
+  val_timeout_start(&timeout, WAIT_ITS_COMMAND_DONE_US);
   ItsBase = g_gic_its_info->GicIts[its_index].Base;
   cwriter_value = val_mmio_read64(ItsBase + ARM_GITS_CWRITER);
   creadr_value = val_mmio_read64(ItsBase + ARM_GITS_CREADR);
@@ -324,8 +324,7 @@ void PollTillCommandQueueDone(uint32_t its_index)
                  );
     }
 
-    count++;
-    if (count > WAIT_ITS_COMMAND_DONE) {
+    if (val_timeout_expired(&timeout)) {
       val_print(AVS_PRINT_ERR,
                 "\n       ITS : Command Queue READR not moving, Test may not pass", 0);
       break;
@@ -36,7 +36,7 @@
 #define ARM_LPI_MIN_IDBITS  14
 #define ARM_LPI_MAX_IDBITS  31
 
-#define WAIT_ITS_COMMAND_DONE   10000
+#define WAIT_ITS_COMMAND_DONE_US   TIMEOUT_US_MEDIUM
 
 /* GICv3 specific registers */
 
@@ -53,6 +53,9 @@ BITFIELD_DECL(uint32_t, IDR1_SSIDSIZE, 10, 6)
 BITFIELD_DECL(uint32_t, IDR1_SIDSIZE, 5, 0)
 
 
+#define SMMU_IDR3_OFFSET 0xc
+#define IDR3_RIL (1 << 10)
+
 #define SMMU_IDR5_OFFSET 0x14
 BITFIELD_DECL(uint32_t, IDR5_OAS, 2, 0)
 #define SMMU_OAS_MAX_IDX 7
@@ -124,6 +127,10 @@ BITFIELD_DECL(uint64_t, MSI_MASK, 51, 2)
 #define EVT_ID_CFG_CONFLICT      0x21
 #define EVT_ID_PAGE_REQUEST      0x24
 #define EVT_ID_VMS_FETCH         0x25
+#define EVT_ID_MAX               EVT_ID_VMS_FETCH
+
+/* Events copied out of the event queue per drain pass */
+#define SMMU_EVTQ_DRAIN_BATCH    64
 
 #define SMMU_PAGE1_BASE_OFFSET   0x10000
 #define SMMU_SH_ISH              3
@@ -189,8 +196,30 @@ BITFIELD_DECL(uint64_t, STRTAB_STE_3_S2TTB, 51, 4)
 BITFIELD_DECL(uint64_t, CMDQ_0_OP, 7, 0)
 BITFIELD_DECL(uint64_t, CMDQ_CFGI_1_RANGE, 4, 0)
 #define CMDQ_CFGI_1_ALL_STES 31
-
-#define SMMU_CMDQ_POLL_TIMEOUT 0x100000
+BITFIELD_DECL(uint64_t, CMDQ_CFGI_0_SSID, 31, 12)
+BITFIELD_DECL(uint64_t, CMDQ_CFGI_0_SID, 63, 32)
+
+BITFIELD_DECL(uint64_t, CMDQ_TLBI_0_NUM, 16, 12)
+#define CMDQ_TLBI_RANGE_NUM_MAX 31
+BITFIELD_DECL(uint64_t, CMDQ_TLBI_0_SCALE, 24, 20)
+BITFIELD_DECL(uint64_t, CMDQ_TLBI_0_VMID, 47, 32)
+BITFIELD_DECL(uint64_t, CMDQ_TLBI_0_ASID, 63, 48)
+#define CMDQ_TLBI_1_LEAF (1UL << 0)
+BITFIELD_DECL(uint64_t, CMDQ_TLBI_1_TG, 11, 10)
+#define CMDQ_TLBI_1_ADDR_MASK (~0xfffUL)
+
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_0_CS, 13, 12)
+#define CMDQ_SYNC_0_CS_IRQ 1
+#define CMDQ_SYNC_0_CS_SEV 2
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_0_MSH, 23, 22)
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_0_MSIATTR, 27, 24)
+#define CMDQ_SYNC_0_MSIATTR_OIWB 0xf
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_0_MSIDATA, 63, 32)
+BITFIELD_DECL(uint64_t, CMDQ_SYNC_1_MSIADDR, 51, 2)
+
+#define SMMU_CMDQ_POLL_TIMEOUT_US TIMEOUT_US_MEDIUM
+/* Beyond this many pages, without range invalidation, invalidate the whole ASID/VMID */
+#define SMMU_TLBI_MAX_PAGES 64
 
 #define CDTAB_SPLIT			10
 #define CDTAB_L2_ENTRY_COUNT	(1 << CDTAB_SPLIT)
@@ -22,7 +22,7 @@ smmu_dev_t *g_smmu;
 uint32_t g_smmu_index;
 uint64_t g_page1_base;
 
-struct smmu_master_node *g_smmu_master_list_head = NULL;
+smmu_master_table_t g_smmu_master_table;
 
 static uint64_t align_to_size(uint64_t addr,  uint64_t size)
 {
@@ -55,97 +55,194 @@ static uint32_t smmu_queue_empty(smmu_queue_t *q)
            ((q->prod & wrap_mask) == (q->cons & wrap_mask));
 }
 
-static int smmu_cmdq_build_cmd(uint64_t *cmd, uint8_t opcode)
+static int smmu_cmdq_build_cmd(uint64_t *cmd, smmu_cmdq_ent_t *ent)
 {
     val_memory_set(cmd, CMDQ_DWORDS_PER_ENT << 3, 0);
-    cmd[0] |= BITFIELD_SET(CMDQ_0_OP, opcode);
-    switch (opcode) {
+    cmd[0] |= BITFIELD_SET(CMDQ_0_OP, ent->opcode);
+    switch (ent->opcode) {
     case CMDQ_OP_TLBI_EL2_ALL:
     case CMDQ_OP_TLBI_NSNH_ALL:
-    case CMDQ_OP_CMD_SYNC:
         break;
     case CMDQ_OP_CFGI_ALL:
         cmd[1] |= BITFIELD_SET(CMDQ_CFGI_1_RANGE, CMDQ_CFGI_1_ALL_STES);
         break;
+    case CMDQ_OP_CFGI_CD:
+        cmd[0] |= BITFIELD_SET(CMDQ_CFGI_0_SSID, ent->ssid);
+        /* fall through */
+    case CMDQ_OP_CFGI_STE:
+        cmd[0] |= BITFIELD_SET(CMDQ_CFGI_0_SID, ent->sid);
+        break;
+    case CMDQ_OP_TLBI_NH_VA:
+        cmd[0] |= BITFIELD_SET(CMDQ_TLBI_0_NUM, ent->num) |
+                  BITFIELD_SET(CMDQ_TLBI_0_SCALE, ent->scale) |
+                  BITFIELD_SET(CMDQ_TLBI_0_VMID, ent->vmid) |
+                  BITFIELD_SET(CMDQ_TLBI_0_ASID, ent->asid);
+        cmd[1] |= BITFIELD_SET(CMDQ_TLBI_1_TG, ent->tg) |
+                  (ent->addr & CMDQ_TLBI_1_ADDR_MASK);
+        if (ent->leaf)
+            cmd[1] |= CMDQ_TLBI_1_LEAF;
+        break;
+    case CMDQ_OP_TLBI_S2_IPA:
+        cmd[0] |= BITFIELD_SET(CMDQ_TLBI_0_NUM, ent->num) |
+                  BITFIELD_SET(CMDQ_TLBI_0_SCALE, ent->scale) |
+                  BITFIELD_SET(CMDQ_TLBI_0_VMID, ent->vmid);
+        cmd[1] |= BITFIELD_SET(CMDQ_TLBI_1_TG, ent->tg) |
+                  (ent->addr & CMDQ_TLBI_1_ADDR_MASK);
+        if (ent->leaf)
+            cmd[1] |= CMDQ_TLBI_1_LEAF;
+        break;
+    case CMDQ_OP_TLBI_NH_ASID:
+        cmd[0] |= BITFIELD_SET(CMDQ_TLBI_0_VMID, ent->vmid) |
+                  BITFIELD_SET(CMDQ_TLBI_0_ASID, ent->asid);
+        break;
+    case CMDQ_OP_TLBI_S12_VMALL:
+        cmd[0] |= BITFIELD_SET(CMDQ_TLBI_0_VMID, ent->vmid);
+        break;
+    case CMDQ_OP_CMD_SYNC:
+        /* Completion is signalled by an MSI write of msi_data to addr when
+         * an address is given, otherwise by an event (SEV).
+         */
+        if (ent->addr) {
+            cmd[0] |= BITFIELD_SET(CMDQ_SYNC_0_CS, CMDQ_SYNC_0_CS_IRQ) |
+                      BITFIELD_SET(CMDQ_SYNC_0_MSH, SMMU_SH_ISH) |
+                      BITFIELD_SET(CMDQ_SYNC_0_MSIATTR, CMDQ_SYNC_0_MSIATTR_OIWB) |
+                      BITFIELD_SET(CMDQ_SYNC_0_MSIDATA, ent->msi_data);
+            cmd[1] |= ent->addr & (CMDQ_SYNC_1_MSIADDR_MASK << CMDQ_SYNC_1_MSIADDR_SHIFT);
+        } else {
+            cmd[0] |= BITFIELD_SET(CMDQ_SYNC_0_CS, CMDQ_SYNC_0_CS_SEV);
+        }
+        break;
     default:
-        val_print(AVS_PRINT_ERR, "\n      Unsupported SMMU command 0x%x    ", opcode);
+        val_print(AVS_PRINT_ERR, "\n      Unsupported SMMU command 0x%x    ", ent->opcode);
         return -1;
     }
 
     return 0;
 }
 
-static int smmu_cmdq_write_cmd(smmu_dev_t *smmu, uint64_t *cmd)
+/* Make the commands written so far visible to the SMMU with one PROD write */
+static void smmu_cmdq_publish(smmu_dev_t *smmu)
 {
-    uint32_t timeout = SMMU_CMDQ_POLL_TIMEOUT;
-    int ret = 0, i;
-    uint64_t *cmd_dst;
-    smmu_cmd_queue_t *cmdq = &smmu->cmdq;
-    smmu_queue_t
-        queue =
-            {
-                .log2nent = cmdq->queue.log2nent,
-            };
+#ifndef TARGET_LINUX
+    ArmExecuteMemoryBarrier();
+#endif
+    val_mmio_write((uint64_t)smmu->cmdq.prod_reg, smmu->cmdq.queue.prod);
+}
 
-    while (smmu_queue_full(&cmdq->queue) && timeout) {
-        timeout--;
-    }
+static int smmu_cmdq_wait_for_space(smmu_dev_t *smmu)
+{
+    VAL_TIMEOUT_t timeout;
+    smmu_cmd_queue_t *cmdq = &smmu->cmdq;
 
-    if (!timeout) {
-        val_print(AVS_PRINT_ERR, "\n      SMMU CMD queue is full     ", 0);
-        return -1;
-    }
+    /* The shadow CONS only lags behind the SMMU, so a queue that is not full
+     * according to it has room without reading the register.
+     */
+    if (!smmu_queue_full(&cmdq->queue))
+        return 0;
 
-    queue.prod = val_mmio_read((uint64_t)cmdq->prod_reg);
-    cmd_dst = (uint64_t *)(cmdq->base + ((queue.prod & ((0x1ull << queue.log2nent) - 1))
-                                         * (cmdq->entry_size)));
-    for (i = 0; i < CMDQ_DWORDS_PER_ENT; ++i)
-        cmd_dst[i] = cmd[i];
-    queue.prod = smmu_inc_prod(&queue);
+    /* Queue is full of unpublished commands, let the SMMU start on them */
+    smmu_cmdq_publish(smmu);
 
-#ifndef TARGET_LINUX
-    ArmExecuteMemoryBarrier();
-#endif
-    val_mmio_write((uint64_t)cmdq->prod_reg, queue.prod);
+    val_timeout_start(&timeout, SMMU_CMDQ_POLL_TIMEOUT_US);
+    do {
+        cmdq->queue.cons = val_mmio_read((uint64_t)cmdq->cons_reg);
+        if (!smmu_queue_full(&cmdq->queue))
+            return 0;
+    } while (!val_timeout_expired(&timeout));
 
-    return ret;
+    val_print(AVS_PRINT_ERR, "\n      SMMU CMD queue is full     ", 0);
+    return -1;
 }
 
-static int smmu_cmdq_issue_cmd(smmu_dev_t *smmu,
-                   uint8_t opcode)
+static int smmu_cmdq_batch_submit(smmu_cmdq_batch_t *batch);
+
+/**
+  @brief Write a command to the next free queue slot at the shadow PROD index.
+         The command is not visible to the SMMU until smmu_cmdq_batch_submit.
+         The last free slot is kept for the CMD_SYNC of the batch: a command
+         which would take it first completes the batch so far, then is added.
+  @param batch - batch the command is added to
+  @param ent - command operands
+  @return 0 on success
+**/
+static int smmu_cmdq_batch_add(smmu_cmdq_batch_t *batch, smmu_cmdq_ent_t *ent)
 {
-    uint64_t cmd[CMDQ_DWORDS_PER_ENT];
+    uint64_t *cmd_dst;
+    smmu_cmd_queue_t *cmdq = &batch->smmu->cmdq;
+    smmu_queue_t next;
 
-    if (smmu_cmdq_build_cmd(cmd, opcode)) {
+    if (smmu_cmdq_wait_for_space(batch->smmu))
         return -1;
+
+    if (ent->opcode != CMDQ_OP_CMD_SYNC && batch->num) {
+        next = cmdq->queue;
+        next.prod = smmu_inc_prod(&next);
+        if (smmu_queue_full(&next)) {
+            if (smmu_cmdq_batch_submit(batch) || smmu_cmdq_wait_for_space(batch->smmu))
+                return -1;
+        }
     }
 
-    return smmu_cmdq_write_cmd(smmu, cmd);
+    cmd_dst = (uint64_t *)(cmdq->base + ((cmdq->queue.prod & ((0x1ull << cmdq->queue.log2nent) - 1))
+                                         * (cmdq->entry_size)));
+    if (smmu_cmdq_build_cmd(cmd_dst, ent))
+        return -1;
+
+    cmdq->queue.prod = smmu_inc_prod(&cmdq->queue);
+    batch->num++;
+    return 0;
 }
 
-static void smmu_cmdq_poll_until_consumed(smmu_dev_t *smmu)
+static int smmu_cmdq_wait_for_sync(smmu_dev_t *smmu, uint32_t seq)
 {
-    uint32_t timeout = SMMU_CMDQ_POLL_TIMEOUT;
+    VAL_TIMEOUT_t timeout;
     smmu_cmd_queue_t *cmdq = &smmu->cmdq;
-    smmu_queue_t queue = {
-                .log2nent = smmu->cmdq.queue.log2nent,
-                .prod = val_mmio_read((uint64_t)smmu->cmdq.prod_reg),
-                .cons = val_mmio_read((uint64_t)smmu->cmdq.cons_reg)
-            };
-
-    while (timeout > 0) {
-        if (smmu_queue_empty(&queue))
-            break;
-        queue.cons = val_mmio_read((uint64_t)cmdq->cons_reg);
-        timeout--;
-    }
 
-    if (!timeout) {
-        val_print(AVS_PRINT_ERR, "\n      CMDQ poll timeout at 0x%08x", queue.prod);
-        val_print(AVS_PRINT_ERR, "\n      prod_reg = 0x%08x,", val_mmio_read((uint64_t)smmu->cmdq.prod_reg));
-        val_print(AVS_PRINT_ERR, "\n      cons_reg = 0x%08x", val_mmio_read((uint64_t)smmu->cmdq.cons_reg));
-        val_print(AVS_PRINT_ERR, "\n      gerror   = 0x%08x     ", val_mmio_read(smmu->base + SMMU_GERROR_OFFSET));
+    val_timeout_start(&timeout, SMMU_CMDQ_POLL_TIMEOUT_US);
+    if (cmdq->sync_word) {
+        /* The SMMU writes the sequence number once all earlier commands completed */
+        do {
+            if (*cmdq->sync_word == seq)
+                return 0;
+        } while (!val_timeout_expired(&timeout));
+    } else {
+        do {
+            cmdq->queue.cons = val_mmio_read((uint64_t)cmdq->cons_reg);
+            if (smmu_queue_empty(&cmdq->queue))
+                return 0;
+        } while (!val_timeout_expired(&timeout));
+    }
+
+    val_print(AVS_PRINT_ERR, "\n      CMDQ poll timeout at 0x%08x", cmdq->queue.prod);
+    val_print(AVS_PRINT_ERR, "\n      prod_reg = 0x%08x,", val_mmio_read((uint64_t)cmdq->prod_reg));
+    val_print(AVS_PRINT_ERR, "\n      cons_reg = 0x%08x", val_mmio_read((uint64_t)cmdq->cons_reg));
+    val_print(AVS_PRINT_ERR, "\n      gerror   = 0x%08x     ", val_mmio_read(smmu->base + SMMU_GERROR_OFFSET));
+    return -1;
+}
+
+/**
+  @brief Terminate the batch with a single CMD_SYNC, ring PROD once and wait
+         for the SMMU to complete every command of the batch.
+  @param batch - batch to submit, empty on return
+  @return 0 on success
+**/
+static int smmu_cmdq_batch_submit(smmu_cmdq_batch_t *batch)
+{
+    smmu_cmd_queue_t *cmdq = &batch->smmu->cmdq;
+    smmu_cmdq_ent_t sync = { .opcode = CMDQ_OP_CMD_SYNC };
+
+    if (cmdq->sync_word) {
+        sync.addr = cmdq->sync_word_phys;
+        sync.msi_data = ++cmdq->sync_seq;
     }
+
+    if (smmu_cmdq_batch_add(batch, &sync))
+        return -1;
+
+    smmu_cmdq_publish(batch->smmu);
+    batch->num = 0;
+
+    return smmu_cmdq_wait_for_sync(batch->smmu, sync.msi_data);
 }
 
 static void smmu_strtab_write_ste(smmu_master_t *master, uint64_t *ste)
@@ -256,6 +353,17 @@ static uint32_t smmu_cmd_queue_init(smmu_dev_t *smmu)
                        BITFIELD_SET(QUEUE_BASE_LOG2SIZE, cmdq->queue.log2nent);
 
     cmdq->queue.prod = cmdq->queue.cons = 0;
+
+    /* CMD_SYNC completion is signalled through an MSI write to sync_word, which
+     * the PE can only poll when the SMMU accesses memory coherently.
+     */
+    cmdq->sync_seq = 0;
+    cmdq->sync_word = NULL;
+    if (smmu->supported.msi && smmu->supported.cohacc) {
+        cmdq->sync_word = val_memory_calloc(1, sizeof(uint32_t));
+        if (cmdq->sync_word)
+            cmdq->sync_word_phys = (uint64_t)val_memory_virt_to_phys((void *)cmdq->sync_word);
+    }
     return 1;
 }
 
@@ -437,32 +545,121 @@ static int smmu_reg_write_sync(smmu_dev_t *smmu, uint32_t val,
     return 1;
 }
 
-smmu_master_t *smmu_master_at(uint32_t sid)
+static uint32_t smmu_master_hash(uint64_t key, uint32_t size)
 {
-    struct smmu_master_node *node = g_smmu_master_list_head;
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (size - 1);
+}
 
-    while (node != NULL)
-    {
-        if (node->master->sid == sid)
-            return node->master;
-        node = node->next;
+static smmu_master_slot_t *smmu_master_slot_find(smmu_master_slot_t *slot, uint32_t size,
+                                                 uint64_t key)
+{
+    uint32_t i = smmu_master_hash(key, size);
+
+    /* Linear probing, the table is never more than half full */
+    while (slot[i].key != 0 && slot[i].key != key)
+        i = (i + 1) & (size - 1);
+
+    return &slot[i];
+}
+
+static uint32_t smmu_master_table_grow(smmu_master_table_t *table)
+{
+    smmu_master_slot_t *slot;
+    uint32_t size, i;
+
+    size = table->size ? (table->size << 1) : SMMU_MASTER_TABLE_INIT_SIZE;
+    slot = val_memory_calloc(size, sizeof(smmu_master_slot_t));
+    if (slot == NULL)
+        return 0;
+
+    for (i = 0; i < table->size; i++) {
+        if (table->slot[i].key != 0)
+            *smmu_master_slot_find(slot, size, table->slot[i].key) = table->slot[i];
     }
 
-    node = val_memory_alloc(sizeof(struct smmu_master_node));
-    if (node == NULL)
+    if (table->slot)
+        val_memory_free(table->slot);
+    table->slot = slot;
+    table->size = size;
+    return 1;
+}
+
+static smmu_master_t *smmu_master_pool_alloc(smmu_master_table_t *table)
+{
+    uint32_t chunk = table->count / SMMU_MASTER_POOL_CHUNK;
+
+    if (chunk >= SMMU_MASTER_POOL_MAX_CHUNKS)
         return NULL;
 
-    node->master = val_memory_calloc(1, sizeof(smmu_master_t));
-    if (node->master == NULL)
-    {
-        val_memory_free(node);
+    if (table->pool[chunk] == NULL) {
+        table->pool[chunk] = val_memory_calloc(SMMU_MASTER_POOL_CHUNK, sizeof(smmu_master_t));
+        if (table->pool[chunk] == NULL)
+            return NULL;
+    }
+
+    return &table->pool[chunk][table->count++ % SMMU_MASTER_POOL_CHUNK];
+}
+
+/* Look up an existing master, NULL if the stream id was never mapped */
+static smmu_master_t *smmu_master_find(uint32_t smmu_index, uint32_t sid)
+{
+    smmu_master_table_t *table = &g_smmu_master_table;
+    smmu_master_slot_t *slot;
+    uint64_t key = SMMU_MASTER_KEY(smmu_index, sid);
+
+    if (table->size == 0)
         return NULL;
+
+    slot = smmu_master_slot_find(table->slot, table->size, key);
+    return (slot->key == key) ? slot->master : NULL;
+}
+
+/**
+  @brief Look up the master for a stream id of an SMMU, creating an empty one
+         on first use. Unmapped masters stay in the table for reuse.
+  @param smmu_index - index of the SMMU in the global SMMU table
+  @param sid - stream id of the master
+  @return master, NULL on allocation failure
+**/
+smmu_master_t *smmu_master_at(uint32_t smmu_index, uint32_t sid)
+{
+    smmu_master_table_t *table = &g_smmu_master_table;
+    smmu_master_slot_t *slot;
+    smmu_master_t *master;
+
+    master = smmu_master_find(smmu_index, sid);
+    if (master != NULL)
+        return master;
+
+    if ((table->count + 1) * 2 > table->size) {
+        if (!smmu_master_table_grow(table))
+            return NULL;
     }
 
-    node->next = g_smmu_master_list_head;
-    g_smmu_master_list_head = node;
+    master = smmu_master_pool_alloc(table);
+    if (master == NULL)
+        return NULL;
 
-    return node->master;
+    slot = smmu_master_slot_find(table->slot, table->size, SMMU_MASTER_KEY(smmu_index, sid));
+    slot->key = SMMU_MASTER_KEY(smmu_index, sid);
+    slot->master = master;
+    return master;
+}
+
+static void smmu_master_table_free(void)
+{
+    smmu_master_table_t *table = &g_smmu_master_table;
+    uint32_t i;
+
+    for (i = 0; i < SMMU_MASTER_POOL_MAX_CHUNKS; i++) {
+        if (table->pool[i])
+            val_memory_free(table->pool[i]);
+    }
+
+    if (table->slot)
+        val_memory_free(table->slot);
+
+    val_memory_set(table, sizeof(smmu_master_table_t), 0);
 }
 
 // Event handler. Gives the info of the kind of event error generated.
@@ -534,41 +731,42 @@ static int smmu_handle_evt(smmu_dev_t *smmu, uint64_t *event)
     return 0;
 }
 
-static void smmu_queue_read(smmu_evnt_queue_t *evntq, uint64_t *event)
+/**
+  @brief Copy the events between the shadow CONS and a single snapshot of PROD
+         into a local ring, then release them to the SMMU with one CONS write.
+         A new overflow, PROD.OVFLG differing from CONS.OVACKFLG, is counted
+         and flagged for the next report, and acknowledged by toggling
+         CONS.OVACKFLG in the same CONS write.
+  @param evntq - event queue to drain
+  @param ring - destination, SMMU_EVTQ_DRAIN_BATCH events
+  @return number of events copied
+**/
+static uint32_t smmu_evtq_drain(smmu_evnt_queue_t *evntq, uint64_t *ring)
 {
-    uint64_t *val = (uint64_t *)(evntq->base + ((evntq->queue.cons) &
-            (((0x1ull << (evntq->queue.log2nent)) - 1))) * evntq->entry_size);
-    for (int i = 0; i < EVNTQ_DWORDS_PER_ENT; ++i)
-    {
-      *event++ = val[i];
-    }
-
-    return;
-}
+    smmu_queue_t *queue = &evntq->queue;
+    uint32_t index_mask = (0x1ul << queue->log2nent) - 1;
+    uint32_t num = 0, i;
+    uint64_t *src;
 
+    queue->prod = val_mmio_read((uint64_t)evntq->prod_reg);
+    if (SMMU_QUEUE_OVF(queue->prod) != SMMU_QUEUE_OVF(queue->cons)) {
+        evntq->overflow = 1;
+        evntq->ovf_total++;
+    }
 
-static int smmu_queue_remove_raw(smmu_evnt_queue_t *evntq, uint64_t *event)
-{
-    if (smmu_queue_empty(&evntq->queue))
-    {
-        return 1;
+    while (!smmu_queue_empty(queue) && (num < SMMU_EVTQ_DRAIN_BATCH)) {
+        src = (uint64_t *)(evntq->base + (queue->cons & index_mask) * evntq->entry_size);
+        for (i = 0; i < EVNTQ_DWORDS_PER_ENT; ++i)
+            *ring++ = src[i];
+        queue->cons = smmu_inc_cons(queue);
+        num++;
     }
 
-    smmu_queue_read(evntq, event);
-    evntq->queue.cons = smmu_inc_cons(&evntq->queue);
-    val_mmio_write((uint64_t)evntq->cons_reg, evntq->queue.cons);
-    return 0;
-}
+    /* Acknowledge the overflow together with the consumed entries */
+    queue->cons = SMMU_QUEUE_OVF(queue->prod) | (queue->cons & ~SMMU_QUEUE_OVERFLOW_FLAG);
+    val_mmio_write((uint64_t)evntq->cons_reg, queue->cons);
 
-static int queue_sync_prod_in(smmu_evnt_queue_t *evntq)
-{
-    uint32_t prod;
-    int ret = 0;
-    prod = val_mmio_read((uint64_t)evntq->prod_reg);
-    if (SMMU_QUEUE_OVF(prod) != SMMU_QUEUE_OVF(evntq->queue.prod))
-        ret = 1;
-    evntq->queue.prod = prod;
-    return ret;
+    return num;
 }
 
 static uint32_t smmu_gerror_check(smmu_dev_t *smmu)
@@ -595,11 +793,12 @@ static uint32_t smmu_gerror_check(smmu_dev_t *smmu)
 
 void smmu_evtq_thread(void)
 {
-    uint32_t ret;
+    uint32_t ret, num, n, id;
     smmu_dev_t *smmu = &g_smmu[g_smmu_index];
     smmu_evnt_queue_t *evntq = &smmu->evntq;
-    smmu_queue_t *queue = &evntq->queue;
-    uint64_t event[EVNTQ_DWORDS_PER_ENT];
+    uint64_t ring[SMMU_EVTQ_DRAIN_BATCH * EVNTQ_DWORDS_PER_ENT];
+    uint64_t *event;
+
     ret = smmu_gerror_check(smmu);
     if (ret)
     {
@@ -607,33 +806,30 @@ void smmu_evtq_thread(void)
         return;
     }
 
-    do {
-        while (!smmu_queue_remove_raw(evntq, event)) {
-            uint8_t id = BITFIELD_GET(EVTQ_0_ID, event[0]);
-            ret = smmu_handle_evt(smmu, event);
-            val_print(AVS_PRINT_TEST, "\n  event 0x%02x received: %d     ", id);
-            for (int i = 0; i < ARRAY_SIZE(event); ++i)
+    while ((num = smmu_evtq_drain(evntq, ring)) != 0) {
+        val_print(AVS_PRINT_INFO, "\n  %d events drained", num);
+
+        for (n = 0, event = ring; n < num; n++, event += EVNTQ_DWORDS_PER_ENT) {
+            id = BITFIELD_GET(EVTQ_0_ID, event[0]);
+            evntq->evt_count[(id <= EVT_ID_MAX) ? id : 0]++;
+            evntq->evt_total++;
+
+            smmu_handle_evt(smmu, event);
+            val_print(AVS_PRINT_TEST, "\n  event 0x%02x received     ", id);
+            for (int i = 0; i < EVNTQ_DWORDS_PER_ENT; ++i)
             {
                 val_print(AVS_PRINT_TEST, "\n  0x%016llx     ", (unsigned long long)event[i]);
             }
-
-            val_print(AVS_PRINT_INFO, "\n  prod is: %x", val_mmio_read((uint64_t)evntq->prod_reg));
-            val_print(AVS_PRINT_INFO, "\n  cons is: %x", val_mmio_read((uint64_t)evntq->cons_reg));
         }
+    }
 
-        if (queue_sync_prod_in(evntq))
-            val_print(AVS_PRINT_WARN, "\n  EVTQ overflow detected -- events lost     ", 0);
-    } while (!smmu_queue_empty(&evntq->queue));
-
-    if (val_mmio_read((uint64_t)evntq->prod_reg) == val_mmio_read((uint64_t)evntq->cons_reg))
-    {
+    if (evntq->overflow) {
+        val_print(AVS_PRINT_WARN, "\n  EVTQ overflow detected -- events lost     ", 0);
+        evntq->overflow = 0;
+    } else
         val_print(AVS_PRINT_TEST, "\n  No outstanding events in the queue. Queue Empty.\n", 0);
-    }
 
-    evntq->queue.cons = ((queue->prod) & (1 << 31)) |
-                        ((queue->cons) & (1 << queue->log2nent)) |
-                        ((queue->cons) & ((1 << queue->log2nent) - 1));
-return;
+    return;
 }
 
 static int smmu_dev_disable(smmu_dev_t *smmu)
@@ -647,18 +843,155 @@ static int smmu_dev_disable(smmu_dev_t *smmu)
     return ret;
 }
 
-static void smmu_tlbi_cfgi(smmu_dev_t *smmu)
+static int smmu_tlbi_cfgi(smmu_dev_t *smmu)
 {
+    smmu_cmdq_batch_t batch = { .smmu = smmu };
+    smmu_cmdq_ent_t ent = { .opcode = CMDQ_OP_CFGI_ALL };
+
     /* Invalidate any cached configuration */
-    smmu_cmdq_issue_cmd(smmu, CMDQ_OP_CFGI_ALL);
+    if (smmu_cmdq_batch_add(&batch, &ent))
+        return -1;
     if (smmu->supported.hyp) {
-        smmu_cmdq_issue_cmd(smmu, CMDQ_OP_TLBI_EL2_ALL);
+        ent.opcode = CMDQ_OP_TLBI_EL2_ALL;
+        if (smmu_cmdq_batch_add(&batch, &ent))
+            return -1;
+    }
+
+    ent.opcode = CMDQ_OP_TLBI_NSNH_ALL;
+    if (smmu_cmdq_batch_add(&batch, &ent))
+        return -1;
+
+    return smmu_cmdq_batch_submit(&batch);
+}
+
+static uint32_t smmu_master_granule_shift(smmu_master_t *master)
+{
+    uint64_t tg;
+
+    if (master->stage == SMMU_STAGE_S2)
+        tg = BITFIELD_GET(STRTAB_STE_2_VTCR_S2TG, master->stage2_config.vtcr);
+    else
+        tg = BITFIELD_GET(CDTAB_CD_0_TCR_TG0, master->stage1_config.cd.tcr);
+
+    /* TG0 and S2TG encodings: 0 - 4KB, 1 - 64KB, 2 - 16KB */
+    if (tg == 1)
+        return 16;
+    if (tg == 2)
+        return 14;
+    return 12;
+}
+
+/**
+  @brief Add the commands invalidating the TLB entries of a master for an input
+         address range to a batch. Uses range invalidation when the SMMU
+         implements it (IDR3.RIL), otherwise one command per page, or the whole
+         ASID/VMID when the range spans more than SMMU_TLBI_MAX_PAGES pages.
+         The commands are not leaf only, the walk caches of the tables of the
+         range are invalidated as well.
+  @param batch - batch the commands are added to
+  @param master - master whose translations changed
+  @param iova - start of the range
+  @param size - size of the range in bytes
+  @return 0 on success
+**/
+static int smmu_tlbi_range(smmu_cmdq_batch_t *batch, smmu_master_t *master,
+                           uint64_t iova, uint64_t size)
+{
+    smmu_cmdq_ent_t ent = { 0 };
+    uint32_t shift = smmu_master_granule_shift(master);
+    uint64_t num_pages, end, inv_range;
+    uint32_t num, scale;
+
+    if (size == 0)
+        return 0;
+
+    end = iova + size;
+    iova &= ~((0x1ull << shift) - 1);
+    num_pages = (end - iova + (0x1ull << shift) - 1) >> shift;
+
+    if (master->stage == SMMU_STAGE_S1) {
+        ent.opcode = CMDQ_OP_TLBI_NH_VA;
+        ent.asid = master->stage1_config.cd.asid;
+    } else {
+        ent.opcode = CMDQ_OP_TLBI_S2_IPA;
+        ent.vmid = master->stage2_config.vmid;
+    }
+
+    if (!master->smmu->supported.ril && num_pages > SMMU_TLBI_MAX_PAGES) {
+        ent.opcode = (master->stage == SMMU_STAGE_S1) ? CMDQ_OP_TLBI_NH_ASID :
+                                                        CMDQ_OP_TLBI_S12_VMALL;
+        return smmu_cmdq_batch_add(batch, &ent);
+    }
+
+    inv_range = 0x1ull << shift;
+    if (master->smmu->supported.ril)
+        ent.tg = (shift - 10) / 2;
+
+    while (num_pages) {
+        if (master->smmu->supported.ril) {
+            /* Each command covers (NUM + 1) << SCALE pages, consume the
+             * range from its lowest set bit upwards.
+             */
+            for (scale = 0; !(num_pages & (0x1ull << scale)); scale++)
+                ;
+            num = (num_pages >> scale) & CMDQ_TLBI_RANGE_NUM_MAX;
+            ent.scale = scale;
+            ent.num = num - 1;
+            inv_range = (uint64_t)num << (scale + shift);
+            num_pages -= (uint64_t)num << scale;
+        } else {
+            num_pages--;
+        }
+
+        ent.addr = iova;
+        if (smmu_cmdq_batch_add(batch, &ent))
+            return -1;
+        iova += inv_range;
+    }
+
+    return 0;
+}
+
+/* Invalidate the cached configuration and TLB entries of one master only,
+ * leaving the other streams of the SMMU untouched. The TLB entries are
+ * invalidated by range when the IOVA span of the master is known, else by
+ * ASID or VMID.
+ */
+static int smmu_master_invalidate(smmu_master_t *master)
+{
+    smmu_cmdq_batch_t batch = { .smmu = master->smmu };
+    smmu_cmdq_ent_t ent = { .opcode = CMDQ_OP_CFGI_STE, .sid = master->sid };
+
+    /* Not a leaf, a level 2 stream table may have been installed for the sid */
+    if (smmu_cmdq_batch_add(&batch, &ent))
+        return -1;
+
+    if (master->stage == SMMU_STAGE_S1) {
+        ent.opcode = CMDQ_OP_CFGI_CD;
+        ent.ssid = master->ssid;
+        if (smmu_cmdq_batch_add(&batch, &ent))
+            return -1;
+    }
+
+    if (master->iova_end) {
+        if (smmu_tlbi_range(&batch, master, master->iova_start,
+                            master->iova_end - master->iova_start))
+            return -1;
+        return smmu_cmdq_batch_submit(&batch);
     }
 
-    smmu_cmdq_issue_cmd(smmu, CMDQ_OP_TLBI_NSNH_ALL);
-    smmu_cmdq_issue_cmd(smmu, CMDQ_OP_CMD_SYNC);
+    if (master->stage == SMMU_STAGE_S1) {
+        ent.opcode = CMDQ_OP_TLBI_NH_ASID;
+        ent.asid = master->stage1_config.cd.asid;
+    } else {
+        ent.opcode = CMDQ_OP_TLBI_S12_VMALL;
+        ent.vmid = master->stage2_config.vmid;
+    }
+
+    if (smmu_cmdq_batch_add(&batch, &ent))
+        return -1;
 
-    smmu_cmdq_poll_until_consumed(smmu);
+    return smmu_cmdq_batch_submit(&batch);
 }
 
 static int smmu_reset(smmu_dev_t *smmu)
@@ -694,7 +1027,10 @@ static int smmu_reset(smmu_dev_t *smmu)
         return ret;
     }
 
-    smmu_tlbi_cfgi(smmu);
+    if (smmu_tlbi_cfgi(smmu)) {
+        val_print(AVS_PRINT_ERR, "\n      failed to invalidate SMMU caches     ", 0);
+        return 0;
+    }
 
     val_mmio_write64(smmu->base + SMMU_EVNTQ_BASE_OFFSET, smmu->evntq.queue_base);
     val_mmio_write(smmu->page1_base + SMMU_EVNTQ_PROD_OFFSET, smmu->evntq.queue.prod);
@@ -801,6 +1137,9 @@ static uint32_t smmu_probe(smmu_dev_t *smmu)
     if (data & IDR0_MSI)
         smmu->supported.msi = 1;
 
+    if (data & IDR0_COHACC)
+        smmu->supported.cohacc = 1;
+
     if (!(data & (IDR0_S1P | IDR0_S2P))) {
         val_print(AVS_PRINT_ERR, "\n      no translation support!     ", 0);
         return 0;
@@ -835,6 +1174,11 @@ static uint32_t smmu_probe(smmu_dev_t *smmu)
     if (smmu->sid_bits <= STRTAB_SPLIT)
         smmu->supported.st_level_2lvl = 0;
 
+    /* IDR3 */
+    data = val_mmio_read(smmu->base + SMMU_IDR3_OFFSET);
+    if (data & IDR3_RIL)
+        smmu->supported.ril = 1;
+
     /* IDR5 */
     data = val_mmio_read(smmu->base + SMMU_IDR5_OFFSET);
 
@@ -1048,6 +1392,7 @@ uint32_t val_smmu_map(smmu_master_attributes_t master_attr, pgt_descriptor_t pgt
     smmu_master_t *master;
     smmu_dev_t *smmu;
     uint64_t *ste;
+    uint32_t live;
 
     if (g_smmu == NULL)
         return 1;
@@ -1065,16 +1410,34 @@ uint32_t val_smmu_map(smmu_master_attributes_t master_attr, pgt_descriptor_t pgt
         return 1;
     }
 
-    if ((master = smmu_master_at(master_attr.streamid)) == NULL)
+    if ((master = smmu_master_at(master_attr.smmu_index, master_attr.streamid)) == NULL)
         return 1;
 
-    if (master->smmu == NULL)
+    live = (master->smmu != NULL);
+    if (!live)
     {
         master->smmu = smmu;
         master->sid = master_attr.streamid;
         master->ssid_bits = master_attr.ssid_bits;
     }
 
+    /* The IOVA span of a live master also covers the translations being replaced,
+     * it is no longer known once the range of one of its mappings is not given.
+     */
+    if ((master_attr.iova_size == 0) || (live && (master->iova_end == 0)))
+    {
+        master->iova_start = 0;
+        master->iova_end = 0;
+    } else if (!live)
+    {
+        master->iova_start = master_attr.iova;
+        master->iova_end = master_attr.iova + master_attr.iova_size;
+    } else
+    {
+        master->iova_start = get_min(master->iova_start, master_attr.iova);
+        master->iova_end = get_max(master->iova_end, master_attr.iova + master_attr.iova_size);
+    }
+
     /* TODO: Support for stage 1 and stage 2 translations in one stream table entry(STE)
      * This implementation only supports either stage 1 or stage 2 in one STE
      */
@@ -1148,7 +1511,8 @@ uint32_t val_smmu_map(smmu_master_attributes_t master_attr, pgt_descriptor_t pgt
     smmu_strtab_write_ste(master, ste);
     dump_strtab(ste);
 
-    smmu_tlbi_cfgi(smmu);
+    if (smmu_master_invalidate(master))
+        return 1;
 
     return 0;
 }
@@ -1164,7 +1528,10 @@ void val_smmu_unmap(smmu_master_attributes_t master_attr)
     smmu_master_t *master;
     uint64_t *strtab;
 
-    if ((master = smmu_master_at(master_attr.streamid)) == NULL)
+    if (master_attr.smmu_index >= g_num_smmus)
+        return;
+
+    if ((master = smmu_master_find(master_attr.smmu_index, master_attr.streamid)) == NULL)
         return;
 
     if (master->smmu == NULL)
@@ -1176,8 +1543,12 @@ void val_smmu_unmap(smmu_master_attributes_t master_attr)
     strtab = master->smmu->strtab_cfg.strtab64 + master_attr.streamid * STRTAB_STE_DWORDS;
     smmu_strtab_write_ste(NULL, strtab);
 
-    smmu_cdtab_free(master);
-    smmu_tlbi_cfgi(master->smmu);
+    /* Make sure the SMMU no longer walks the context descriptors before freeing them,
+       they are leaked if the invalidation did not complete */
+    if (smmu_master_invalidate(master))
+        val_print(AVS_PRINT_ERR, "\n      SMMU invalidation failed for sid 0x%x     ", master->sid);
+    else
+        smmu_cdtab_free(master);
     val_memory_set(master, sizeof(smmu_master_t), 0);
 }
 
@@ -1224,11 +1595,14 @@ void val_smmu_stop(void)
         smmu_dev_disable(smmu);
         if (smmu->cmdq.base_ptr)
             val_memory_free(smmu->cmdq.base_ptr);
+        if (smmu->cmdq.sync_word)
+            val_memory_free((void *)smmu->cmdq.sync_word);
         if (smmu->evntq.base_ptr)
             val_memory_free(smmu->evntq.base_ptr);
         smmu_free_strtab(smmu);
     }
 
+    smmu_master_table_free();
     val_memory_free(g_smmu);
 }
 
@@ -1296,11 +1670,35 @@ val_smmu_get_info(SMMU_INFO_e type, uint32_t smmu_index)
             return smmu->ias;
         case SMMU_OUT_ADDR_SIZE:
             return smmu->oas;
+        case SMMU_COHERENT_ACCESS:
+            return smmu->supported.cohacc;
         default:
             return val_iovirt_get_smmu_info(type, smmu_index);
     }
 }
 
+static void smmu_evtq_print_stats(smmu_evnt_queue_t *evntq)
+{
+    uint32_t id;
+
+    val_print(AVS_PRINT_TEST, "\n      Events received : %d", evntq->evt_total);
+    for (id = 0; id <= EVT_ID_MAX; id++) {
+        if (evntq->evt_count[id] == 0)
+            continue;
+        if (id == 0)
+            val_print(AVS_PRINT_TEST, "\n        unknown ID : ", 0);
+        else
+            val_print(AVS_PRINT_TEST, "\n        ID 0x%02x    : ", id);
+        val_print(AVS_PRINT_TEST, "%d", evntq->evt_count[id]);
+    }
+    val_print(AVS_PRINT_TEST, "\n      Overflows       : %d", evntq->ovf_total);
+}
+
+/**
+  @brief  Drain the event queue of every SMMU, then print the number of events
+          received per event ID and how many times the queue overflowed since init.
+  @return void
+**/
 void val_smmu_dump_eventq(void)
 {
     val_print(AVS_PRINT_TEST, "\n      Eventq dump starting...    ", 0);
@@ -1313,6 +1711,7 @@ void val_smmu_dump_eventq(void)
 
         val_print(AVS_PRINT_TEST, "\n      Eventq of SMMU index %x ", g_smmu_index);
         smmu_evtq_thread();
+        smmu_evtq_print_stats(&g_smmu[g_smmu_index].evntq);
     }
 
     val_print(AVS_PRINT_TEST, "\n      Eventq dump finished...    ", 0);
@@ -29,9 +29,19 @@ static uint64_t inline get_max(uint64_t x, uint64_t y)
     return x > y ? x : y;
 }
 
+static uint64_t inline get_min(uint64_t x, uint64_t y)
+{
+    return x < y ? x : y;
+}
+
 #define CMDQ_OP_CFGI_STE 0x3
 #define CMDQ_OP_CFGI_ALL 0x4
+#define CMDQ_OP_CFGI_CD 0x5
+#define CMDQ_OP_TLBI_NH_ASID 0x11
+#define CMDQ_OP_TLBI_NH_VA 0x12
 #define CMDQ_OP_TLBI_EL2_ALL 0x20
+#define CMDQ_OP_TLBI_S12_VMALL 0x28
+#define CMDQ_OP_TLBI_S2_IPA 0x2a
 #define CMDQ_OP_TLBI_NSNH_ALL 0x30
 #define CMDQ_OP_CMD_RESUME 0x44
 #define CMDQ_OP_CMD_SYNC 0x46
@@ -55,8 +65,26 @@ typedef struct {
     uint32_t *prod_reg;
     uint32_t *cons_reg;
     uint32_t sid;
+    volatile uint32_t *sync_word;  /* CMD_SYNC MSI completion target */
+    uint64_t sync_word_phys;
+    uint32_t sync_seq;
 } smmu_cmd_queue_t;
 
+/* Operands of a command, only the ones used by the opcode are encoded */
+typedef struct {
+    uint8_t  opcode;
+    uint8_t  leaf;
+    uint32_t sid;
+    uint32_t ssid;
+    uint16_t asid;
+    uint16_t vmid;
+    uint64_t addr;
+    uint8_t  num;
+    uint8_t  scale;
+    uint8_t  tg;
+    uint32_t msi_data;
+} smmu_cmdq_ent_t;
+
 typedef struct {
     smmu_queue_t queue;
     void    *base_ptr;
@@ -66,6 +94,10 @@ typedef struct {
     uint64_t entry_size;
     uint32_t *prod_reg;
     uint32_t *cons_reg;
+    uint32_t evt_count[EVT_ID_MAX + 1];  /* Per event ID, index 0 counts unknown IDs */
+    uint32_t evt_total;
+    uint32_t overflow;                   /* Events were lost since the last report */
+    uint32_t ovf_total;                  /* Overflows since the queue was enabled */
 } smmu_evnt_queue_t;
 
 typedef struct {
@@ -137,12 +169,20 @@ typedef struct {
            uint32_t s1p:1;
            uint32_t s2p:1;
            uint32_t msi:1;
+           uint32_t ril:1;
+           uint32_t cohacc:1;
         };
         uint32_t bitmap;
     } supported;
     uint64_t msi_address;
 } smmu_dev_t;
 
+/* Commands written to the queue but not yet published through PROD */
+typedef struct {
+    smmu_dev_t *smmu;
+    uint32_t num;
+} smmu_cmdq_batch_t;
+
 typedef enum {
     SMMU_STAGE_S1 = 0,
     SMMU_STAGE_S2,
@@ -158,11 +198,29 @@ typedef struct {
     uint32_t sid;
     uint32_t ssid;
     uint32_t ssid_bits;
+    /* IOVA span translated for the master, iova_end is 0 when it is not known */
+    uint64_t iova_start;
+    uint64_t iova_end;
 } smmu_master_t;
 
-struct smmu_master_node {
+/* Masters are found through an open addressing hash table keyed by
+ * (smmu index, stream id) and allocated from a pool of fixed size chunks.
+ */
+#define SMMU_MASTER_TABLE_INIT_SIZE 64
+#define SMMU_MASTER_POOL_CHUNK      32
+#define SMMU_MASTER_POOL_MAX_CHUNKS 64
+#define SMMU_MASTER_KEY(smmu_index, sid) ((((uint64_t)(smmu_index) + 1) << 32) | (sid))
+
+typedef struct {
+    uint64_t key;              /* SMMU_MASTER_KEY, 0 for an empty slot */
     smmu_master_t *master;
-    struct smmu_master_node *next;
-};
+} smmu_master_slot_t;
+
+typedef struct {
+    smmu_master_slot_t *slot;
+    uint32_t size;             /* Number of slots, power of 2 */
+    uint32_t count;            /* Masters allocated from the pool */
+    smmu_master_t *pool[SMMU_MASTER_POOL_MAX_CHUNKS];
+} smmu_master_table_t;
 
 #endif /*__SMMU_V3_H__ */